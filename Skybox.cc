@@ -124,25 +124,23 @@ GLuint Skybox::loadCubeTex(std::vector<const GLchar*> faces)
 	glGenTextures(1, &textureID);
 	glActiveTexture(GL_TEXTURE0);
 
-	int x,y,n;
-	unsigned char* data;
+	// Decode every face at once, the sky is drawn from the first frame so
+	// they are waited for
+	std::vector<CubeFace> decoded(faces.size());
+	std::vector<std::thread> decoders;
+	for(GLuint i = 0; i < faces.size(); i++)
+		decoders.push_back(std::thread(&Skybox::DecodeFace, faces[i], &decoded[i]));
+	for(GLuint i = 0; i < decoders.size(); i++)
+		decoders[i].join();
 
 	glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
 	for(GLuint i = 0; i < faces.size(); i++)
-	{   
-  		
-  		data = stbi_load(
-      faces[i], /*char* filepath */
-      &x, /*The address to store the width of the image*/
-      &y, /*The address to store the height of the image*/
-      &n  /*Number of channels in the image*/,
-      0   /*Force number of channels if > 0*/
-      );
-
+	{
       glTexImage2D(
             GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0,
-            GL_RGB, x, y, 0, GL_RGB, GL_UNSIGNED_BYTE, data
+            GL_RGB, decoded[i].x, decoded[i].y, 0, GL_RGB, GL_UNSIGNED_BYTE, decoded[i].data
         );
+      stbi_image_free(decoded[i].data);
 	}
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -154,3 +152,16 @@ GLuint Skybox::loadCubeTex(std::vector<const GLchar*> faces)
 	return textureID;
 
 }
+
+// Decodes a face of the cubemap
+// @input - the image file and the face to store it in
+void Skybox::DecodeFace(const GLchar * filename, CubeFace * face)
+{
+	face->data = stbi_load(
+      filename, /*char* filepath */
+      &face->x, /*The address to store the width of the image*/
+      &face->y, /*The address to store the height of the image*/
+      &face->n  /*Number of channels in the image*/,
+      0   /*Force number of channels if > 0*/
+      );
+}
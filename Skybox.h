@@ -15,6 +15,7 @@
 #define ASSIGN3_Skybox_H_
 
 #include <vector>
+#include <thread>
 #include "camera.h"
 #include "shaders/shaders.h"
 
@@ -43,13 +44,21 @@ class Skybox {
     inline GLuint skyboxtex() const;
 
     // Return the shader ID
-    inline const Shader shader() const;
+    inline const Shader &shader() const;
 
   private:
     // For more detailed comments so the implementation inside the implementation of this class (Skybox.cc)
     // Load in the textures
     GLuint loadCubeTex(std::vector<const GLchar*> faces);
 
+    // A decoded face of the cubemap
+    struct CubeFace {
+      int x, y, n;
+      unsigned char * data;
+    };
+    // Decodes a face, run on a thread per face
+    static void DecodeFace(const GLchar * filename, CubeFace * face);
+
     // Create the VAO
     GLuint CreateVao() const;
 
@@ -78,7 +87,7 @@ inline GLuint Skybox::skyboxvao() const {
 }
 
 // Return the skybox shader
-inline const Shader Skybox::shader() const {
+inline const Shader &Skybox::shader() const {
   return shader_;
 }
 
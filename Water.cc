@@ -115,19 +115,6 @@ Water::~Water()
   delete[] indices_;
 }
 
-// Send the updated time variable so the waves actually move
-void Water::SendTime(float dt)
-{
-  glUseProgram(shader_.Id);
-
-  int timeHandle = glGetUniformLocation(shader_.Id, "time");
-  if(timeHandle == -1)
-  {
-    fprintf(stderr,"Could not find uniform: 'time' In: Water - SendTime\n This may cause unexpected behaviour in the program\n");
-  }
-  glUniform1f(timeHandle, dt); 
-}
-
 unsigned int Water::CreateVao()
 {
   // Create the mesh for the 'water', stored into the 
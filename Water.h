@@ -40,14 +40,11 @@ class Water {
     // Destructor
     ~Water();
 
-    // Send the delat time
-    void SendTime(float dt);
-
     // Returns the VAO
     inline unsigned int watervao() const;
 
     // Return the shader
-    inline const Shader shader() const;
+    inline const Shader &shader() const;
 
     // Return the amount of indices   
     inline unsigned int water_index_count() const;
@@ -113,7 +110,7 @@ inline unsigned int Water::water_vertex_count() const {
 }
 
 // Return the Water shader
-inline const Shader Water::shader() const {
+inline const Shader &Water::shader() const {
   return shader_;
 }
 
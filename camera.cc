@@ -18,12 +18,10 @@
 #include "camera.h"
 
 // Default Constructor sets starting position of Camera at 0,5,-10 (Above Road)
-//   @param shaders, an object pointer containing all active shaders
 //   @param window_width, the width of the application window
 //   @param window_height, the height of the application window
 //   @param fov, the default field of view
-Camera::Camera(const Shaders * shaders, 
-    const int window_width, const int window_height, const float fov) :
+Camera::Camera(const int window_width, const int window_height, const float fov) :
   // Default Vars - VIEWING
   state_(kChase),
   cam_pos_(glm::vec3(0.0f,5.0f,-10.0f)),
@@ -31,9 +29,7 @@ Camera::Camera(const Shaders * shaders,
   cam_up_(glm::vec3(0.0f, 1.0f, 0.0f)),
   yaw_(kPi/2), pitch_(0.0f),
   // Default Vars - WINDOW
-  fov_(fov), width_(window_width), height_(window_height),
-  // Pointer to all Shaders
-  shaders_(shaders) {
+  fov_(fov), width_(window_width), height_(window_height) {
     // Setup view
     view_matrix_ = glm::lookAt(cam_pos_, cam_pos_ + cam_front_, cam_up_);
     // Setup projections
@@ -85,16 +81,10 @@ void Camera::Movement(float delta_time, const std::vector<bool> &is_key_pressed_
     }
 }
 
-// Updates all the currently loaded shaders' projection uniforms
+// Recalculates the projection matrix from the fov and window size
+//   Shaders read it from the FrameConstants block, see Renderer::UpdateFrameConstants
 void Camera::UpdateProjections() {
-  projection_matrix_ = glm::perspective(fov_, (float)width_ / (float)height_, 0.1f, 100.0f);
-  ShadersProjectionIterator iter(shaders_);
-  for (iter = iter.begin(); iter != iter.end(); ++iter) {
-    const Shader * shader = *(iter);
-    glUseProgram(shader->Id);
-    if (shader->projHandle != -1) // Only update found projections
-      glUniformMatrix4fv(shader->projHandle, 1, false, glm::value_ptr(projection_matrix_));
-  }
+  projection_matrix_ = glm::perspective(fov_, (float)width_ / (float)height_, 0.1f, kFarPlane);
 }
 
 // Changes Direction by X and Y mouse inputs
@@ -21,7 +21,6 @@
 #include "model_data.h"
 #include "model.h"
 #include "object.h"
-#include "shaders/shaders.h"
 
 #include "glm/glm.hpp"
 #include <GL/glew.h>
@@ -52,8 +51,7 @@ class Camera {
 
     // CONSTRUCTORS:
     // Default Constructor sets starting position of Camera at 0,0,3
-    Camera(const Shaders * shaders,
-        const int window_width, const int window_height,
+    Camera(const int window_width, const int window_height,
         const float fov = 55.0f);
 
     // MUTATORS:
@@ -85,7 +83,8 @@ class Camera {
     void UpdateCarTick(const Object * car);
     // Update the Camera Matrix
     void UpdateCamera();
-    // Updates all the currently loaded shaders' projection uniforms
+    // Recalculates the projection matrix from the fov and window size
+    //   Shaders read it from the FrameConstants block, see Renderer::UpdateFrameConstants
     void UpdateProjections();
     // Mutates the cameras position
     inline void ResetPosition(const glm::vec3 &camera_position);
@@ -134,6 +133,9 @@ class Camera {
     GLfloat pitch_;
 
     // WINDOW VARS
+    // The far clipping plane of the projection
+    //   Far enough to see the terrain horizon strip, fog hides the cut off
+    const float kFarPlane = 300.0f;
     // The field of view of the projection
     float fov_;
     // The width of the Window
@@ -147,9 +149,6 @@ class Camera {
     // The projection matrix for the world
     glm::mat4 projection_matrix_;
 
-    // SHADERS TO UPDATE PROJECTION
-    const Shaders * shaders_;
-
     // MOUSE SETTINGS:
     // Stores previous mouse X location on Window
     int prev_mouse_x_;
@@ -1,5 +1,29 @@
 #include "controller.h"
 
+// The passes of a frame and the resources they read and write, see FrameNode
+static_assert(kShadowCascades == 3, "kFrameNodes needs a pass per cascade");
+static const RenderGraphPass kFrameNodes[kFrameNodeCount] = {
+  {"static shadow 0", 0,                    kShadowLayerResource},
+  {"static shadow 1", 0,                    kShadowLayerResource},
+  {"static shadow 2", 0,                    kShadowLayerResource},
+  {"shadow 0",        kShadowLayerResource, kShadowMapResource},
+  {"shadow 1",        kShadowLayerResource, kShadowMapResource},
+  {"shadow 2",        kShadowLayerResource, kShadowMapResource},
+  {"opaque",          kShadowMapResource,   kScreenResource},
+  {"sky",             0,                    kScreenResource},
+  {"transparent",     kShadowMapResource,   kScreenResource},
+  {"rain",            0,                    kScreenResource},
+  {"overlay",         kShadowMapResource,   kScreenResource},
+  {"axis",            0,                    kScreenResource},
+};
+
+// The model of each ScatterKind
+static const char * kScatterModels[kScatterKinds] = {
+  "models/Scatter/rock.obj",
+  "models/Scatter/shrub.obj",
+  "models/Scatter/post.obj",
+};
+
 // Constructor
 //   Allows for Verbose Debugging Mode
 //   @param bool debug_flag, true will enable verbose debugging
@@ -7,18 +31,24 @@
 //   @note axis is rendered in debugging mode
 Controller::Controller(const int window_width, const int window_height, const bool debug_flag) :
   // Object construction
-  renderer_(Renderer(debug_flag)),
+  recording_backend_(&gl_backend_),
+  gl_state_(debug_flag ? static_cast<RenderBackend*>(&recording_backend_) : &gl_backend_),
+  renderer_(&gl_state_, debug_flag),
+  shadow_cache_(gl_state_.backend()),
+  render_graph_(kFrameNodes, kFrameNodeCount, kScreenResource),
   shaders_(renderer_.shaders()),
-  camera_(Camera(shaders_, window_width, window_height)),
+  texture_arrays_(gl_state_.backend()),
+  camera_(Camera(window_width, window_height)),
   sun_(Sun(camera(), debug_flag)),
-  light_controller_(new LightController()),
+  light_controller_(new LightController(gl_state_.backend())),
   collision_controller_(CollisionController()),
-  terrain_(new Terrain(shaders_->LightMappedGeneric)),
-  road_sign_(RoadSign(shaders_, terrain_)),
+  terrain_(new Terrain(shaders_->LightMappedGeneric, shaders_->DepthBuffer, gl_state_.backend(),
+        &texture_arrays_)),
+  road_sign_(RoadSign(shaders_, &texture_arrays_, terrain_)),
   car_(AddObject(shaders_->LightMappedGeneric, "models/Pick-up_Truck/pickup_wind_alpha.obj")),
   // State and var defaults
   game_state_(kAutoDrive), light_pos_(glm::vec4(0,0,0,0)),
-  frames_past_(0), frames_count_(0), delta_time_(18), is_debugging_(debug_flag) {
+  frames_past_(0), frames_count_(0), delta_time_(18), elapsed_time_(0), is_debugging_(debug_flag) {
 
     is_key_pressed_hash_.reserve(256);
     is_key_pressed_hash_.resize(256);
@@ -28,6 +58,14 @@ Controller::Controller(const int window_width, const int window_height, const bo
     water_ = new Water(shaders_->WaterGeneric);
     skybox_ = new Skybox(shaders_->SkyboxGeneric);
 
+    // Roadside props, their transforms come from the terrain's tiles
+    for (unsigned int x = 0; x < kScatterKinds; ++x)
+      scatter_props_.push_back(new Model(shaders_->LightMappedGeneric, &texture_arrays_, kScatterModels[x]));
+
+    // Every texture is loaded, the arrays are grey until their layers are
+    // decoded and uploaded by the ticks
+    texture_arrays_.Allocate();
+
   // Add starting models
   // AddModel(shaders_->LightMappedGeneric, "models/Pick-up_Truck/pickup.obj", true);
   // AddModel(shaders_->LightMappedGeneric, "models/Car/car-n.obj", true);
@@ -42,11 +80,12 @@ Controller::Controller(const int window_width, const int window_height, const bo
 //   @param model_filename, a string containing the path of the .obj file
 //   @warn the model is created on the heap and memory must be freed afterwards
 Object * Controller::AddObject(const Shader &shader, const std::string &model_filename) {
-  Object * object = new Model(shader, model_filename,
+  Object * object = new Model(shader, &texture_arrays_, model_filename,
       glm::vec3(0.95f, 0.55f, 35.0f),     // Translation  move behind first tile (i.e. start on 2nd tile)
       glm::vec3(0.0f, 20.0f, 0.0f),       // Rotation
       glm::vec3(0.4f,  0.4f*1.6f, 0.4f),  // Scale
-      60, false); // starting speed and debugging mode
+      60, false,  // starting speed and debugging mode
+      &shaders_->DepthBuffer, kShadowProxyCells); // casts a shadow through a low poly proxy
 
   return object;
 }
@@ -54,59 +93,170 @@ Object * Controller::AddObject(const Shader &shader, const std::string &model_fi
 // Renders all models in the vector member
 //   Should be called in the render loop
 void Controller::Draw() {
-  // Draw to shadow buffer
-  glBindFramebuffer(GL_FRAMEBUFFER, renderer_.fbo()->FrameBufferShadows);
-  glClear(GL_DEPTH_BUFFER_BIT);
-  glViewport(0, 0, renderer_.fbo()->textureX, renderer_.fbo()->textureY);
+  // Anything may have changed the GL state since last frame (uploads)
+  gl_state_.ResetFrame();
+  // The matrices shared by every draw, built once
+  FrameContext frame(camera_, sun_, elapsed_time_);
+  // The lights set by PositionLights, the shaders are compiled for the car's
+  frame.point_lights = light_controller_->point_light_count();
+  frame.spot_lights = light_controller_->spot_light_count();
+  // Shadows are only drawn by day, the cached terrain depth keeps the
+  // light it was rendered with until it is outdated
+  if (frame.is_day)
+    shadow_cache_.Update(&frame, terrain_->tile_version());
+  else
+    shadow_cache_.Invalidate();
+  // Camera, sun and time for every shader
+  renderer_.UpdateFrameConstants(frame);
+
+  // Cull the passes this frame doesn't need, e.g. the shadows at night
+  // or the rain at noon, together with their draws and updates
+  for (unsigned int x = 0; x < kFrameNodeCount; ++x)
+    render_graph_.Enable(x, IsNodeEnabled(static_cast<FrameNode>(x), frame));
+  render_graph_.Compile();
+
+  // Collect this frame's draws, they are sorted by state (and depth)
+  // so the submission order below is only that of the passes
+  render_queue_.Clear();
+  for (unsigned int x = 0; x < kFrameNodeCount; ++x) {
+    if (render_graph_.is_live(x))
+      QueueNode(static_cast<FrameNode>(x), frame);
+  }
+  render_queue_.Sort();
+
+  for (unsigned int x = 0; x < kFrameNodeCount; ++x) {
+    if (!render_graph_.is_live(x))
+      continue;
+    render_graph_.BeginPass(x);
+    ExecuteNode(static_cast<FrameNode>(x), frame);
+    render_graph_.EndPass(x);
+  }
+}
 
-  // Car with physics
-  renderer_.RenderDepthBuffer(car_, sun_);
-  // Road-signs
-  const std::vector<Object*> signs = road_sign_.signs();
-  const std::vector<int> active_signs = road_sign_.active_signs();
-
-  // Unfortunately this does not work
-  // for (unsigned int x = 0; x < signs.size(); ++x) {
-  //   // if (active_signs[x] >= 0) // no point
-  //   renderer_.RenderDepthBuffer(signs[x], sun_);
-  // }
-  // Terrain
-  renderer_.RenderDepthBuffer(terrain_, sun_);
-
-  // Draw to screen
-  glBindFramebuffer(GL_FRAMEBUFFER, 0);
-  // Bind shadow map texture
-  glBindTexture(GL_TEXTURE_2D, renderer_.fbo()->DepthTexture);
-  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-  glViewport(0, 0, camera_.width(), camera_.height());
-
-  // Ordering of renderering is very important due to transparency
-  renderer_.RenderSkybox(skybox_, camera_);
-  // Water
-  renderer_.RenderWater(water_, car_, skybox_, camera_);
-  // Terrain
-  renderer_.Render(terrain_, camera_, sun_);
-  // Road-signs
-  for (unsigned int x = 0; x < signs.size(); ++x) {
-    // if (active_signs[x] >= 0) // no point
-    renderer_.Render(signs[x], camera_, sun_);
+// The enable predicate of a pass
+//   A pass may still be culled when no live pass reads what it draws,
+//   e.g. the static shadows at night
+//   @param node, the pass
+//   @param frame, the frame about to be drawn
+//   @return  Whether the pass should be drawn this frame
+bool Controller::IsNodeEnabled(const FrameNode node, const FrameContext &frame) const {
+  if (node < kShadowNode)
+    return shadow_cache_.is_outdated(node - kStaticShadowNode);
+  if (node < kOpaqueNode)
+    return frame.is_day;
+  switch(node) {
+    case kRainNode:
+      return sun_.time_of_day() != 12;
+    case kOverlayNode:
+      // In first person the rain is drawn before the car around the camera
+      return camera_.state() == Camera::kFirstPerson && sun_.time_of_day() != 12;
+    case kAxisNode:
+      return is_debugging_;
+    default:
+      return true;
+  }
+}
+
+// Queues the draws of a live pass
+void Controller::QueueNode(const FrameNode node, const FrameContext &frame) {
+  // Terrain, only into the outdated cascades
+  if (node < kShadowNode) {
+    renderer_.QueueDepth(terrain_, frame, &render_queue_, node - kStaticShadowNode);
+    return;
   }
-  if (camera_.state() == Camera::kFirstPerson) {
-    // Rain (particles)
-    if (sun_.time_of_day() != 12)
-      rain_->Render(camera_, car_, skybox_);
   // Car with physics
-  renderer_.Render(car_, camera_, sun_);
-  } else {
-    // Car with physics
-    renderer_.Render(car_, camera_, sun_);
-    // Rain (particles)
-    if (sun_.time_of_day() != 12)
-      rain_->Render(camera_, car_, skybox_);
+  if (node < kOpaqueNode) {
+    renderer_.QueueDepth(car_, frame, &render_queue_, node - kShadowNode);
+    // Road-signs
+    //   Unfortunately this does not work
+    // for (unsigned int x = 0; x < signs.size(); ++x) {
+    //   // if (active_signs[x] >= 0) // no point
+    //   renderer_.QueueDepth(signs[x], frame, &render_queue_, node - kShadowNode);
+    // }
+    return;
+  }
+  switch(node) {
+    case kOpaqueNode: {
+      // Water
+      renderer_.Queue(water_, car_, skybox_, frame, &render_queue_);
+      // Terrain
+      renderer_.Queue(terrain_, frame, &render_queue_);
+      // Road-signs, every sign of a kind in one instanced draw
+      const std::vector<InstanceRing*> &signs = road_sign_.instances();
+      for (unsigned int x = 0; x < signs.size(); ++x)
+        renderer_.Queue(signs[x], frame, &render_queue_);
+      // Rocks, shrubs and posts, a tile's props of a kind in one instanced draw
+      renderer_.QueueScatter(terrain_, scatter_props_, frame, &render_queue_);
+      break;
+    }
+    case kSkyNode:
+      renderer_.Queue(skybox_, frame, &render_queue_);
+      break;
+    case kTransparentNode:
+      // Car with physics
+      renderer_.Queue(car_, frame, &render_queue_,
+          render_graph_.is_live(kOverlayNode) ? kOverlayPass : kTransparentPass);
+      break;
+    default:
+      break;
   }
+}
 
-  // Axis only renders in debugging mode
-  renderer_.RenderAxis(camera_);
+// Draws a live pass
+//   @warn requires the queue to be sorted
+void Controller::ExecuteNode(const FrameNode node, const FrameContext &frame) {
+  RenderBackend * backend = gl_state_.backend();
+  const FrameBufferObject * fbo = renderer_.fbo();
+  const FrameBufferObject * layer = shadow_cache_.layer();
+  // Draw the terrain to the cached layer
+  if (node < kShadowNode) {
+    const unsigned int cascade = node - kStaticShadowNode;
+    backend->BindFramebuffer(GL_FRAMEBUFFER, layer->FrameBufferShadows[cascade]);
+    backend->Viewport(0, 0, layer->textureX, layer->textureY);
+    backend->Clear(GL_DEPTH_BUFFER_BIT);
+    renderer_.Submit(&render_queue_, StaticShadowPass(cascade), frame);
+    return;
+  }
+  // Copy the layer to the shadow buffer and draw the car on top
+  if (node < kOpaqueNode) {
+    const unsigned int cascade = node - kShadowNode;
+    backend->BindFramebuffer(GL_READ_FRAMEBUFFER, layer->FrameBufferShadows[cascade]);
+    backend->BindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo->FrameBufferShadows[cascade]);
+    backend->BlitFramebuffer(0, 0, layer->textureX, layer->textureY,
+        0, 0, fbo->textureX, fbo->textureY, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    backend->BindFramebuffer(GL_FRAMEBUFFER, fbo->FrameBufferShadows[cascade]);
+    backend->Viewport(0, 0, fbo->textureX, fbo->textureY);
+    renderer_.Submit(&render_queue_, ShadowPass(cascade), frame);
+    return;
+  }
+  switch(node) {
+    case kOpaqueNode:
+      // Draw to screen
+      backend->BindFramebuffer(GL_FRAMEBUFFER, 0);
+      backend->Clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+      backend->Viewport(0, 0, camera_.width(), camera_.height());
+      renderer_.Submit(&render_queue_, kOpaquePass, frame);
+      break;
+    case kSkyNode:
+      renderer_.Submit(&render_queue_, kSkyPass, frame);
+      break;
+    case kTransparentNode:
+      renderer_.Submit(&render_queue_, kTransparentPass, frame);
+      break;
+    case kRainNode:
+      // Rain (particles)
+      rain_->Render(frame, &gl_state_, car_, skybox_);
+      break;
+    case kOverlayNode:
+      renderer_.Submit(&render_queue_, kOverlayPass, frame);
+      break;
+    case kAxisNode:
+      // Axis only renders in debugging mode
+      renderer_.RenderAxis(frame);
+      break;
+    default:
+      assert(false && "Unknown frame pass");
+  }
 }
 
 // Assumes SetupLighting() has been called, only updates essential light properties
@@ -177,12 +327,11 @@ void Controller::PositionLights() {
     spotLights.push_back(headlight);
   }
 
-  light_controller_->SetDirectionalLight(car_->shader()->Id, dirLight);
-  light_controller_->SetSpotLights(water_->shader().Id, spotLights.size(), &spotLights[0]);
-  light_controller_->SetDirectionalLight(water_->shader().Id, dirLight);
-
-  light_controller_->SetPointLights(car_->shader()->Id, pointLights.size(), &pointLights[0]);
-  light_controller_->SetSpotLights(car_->shader()->Id, spotLights.size(), &spotLights[0]);
+  // One Lights block update shared by the car, terrain and water shaders
+  light_controller_->SetDirectionalLight(dirLight);
+  light_controller_->SetPointLights(pointLights.size(), &pointLights[0]);
+  light_controller_->SetSpotLights(spotLights.size(), &spotLights[0]);
+  light_controller_->Upload();
 }
 
 // The main control tick
@@ -191,7 +340,9 @@ void Controller::UpdateGame() {
   // Lights need to be transformed with view/normal matrix
   PositionLights();
   // Update the position of the rain
-  rain_->UpdatePosition();
+  //   Only while it is drawn, it is culled with its pass at noon
+  if (render_graph_.is_live(kRainNode))
+    rain_->UpdatePosition();
 
   // FPS counter - also determine delta time
   long long current_frame = glutGet(GLUT_ELAPSED_TIME);
@@ -199,6 +350,18 @@ void Controller::UpdateGame() {
   if ((current_frame - frames_past_) > 1000) {
     const int fps = frames_count_ * 1000.0f / (current_frame - frames_past_);
       std::cout << "FPS: " << frames_count_ << std::endl;
+    if (is_debugging_) {
+      const GLStateStats &gl_stats = gl_state_.stats();
+      printf("Draws: %u, GL state calls - issued: %u, skipped: %u, switches - program: %u, texture: %u, VAO: %u\n",
+          render_queue_.stats()->draws, gl_state_.TotalIssued(), gl_state_.TotalSkipped(),
+          gl_stats.issued[kUseProgramCall], gl_stats.issued[kBindTextureCall],
+          gl_stats.issued[kBindVertexArrayCall]);
+      // The last frame's command stream per pass
+      recording_backend_.Print(stdout);
+      // The average time of every pass over the last second
+      render_graph_.Print(stdout);
+      render_graph_.ResetTimings();
+    }
     frames_count_ = 0;
     frames_past_ = current_frame;
 
@@ -214,9 +377,10 @@ void Controller::UpdateGame() {
   // Update Sun/Moon position
   sun_.Update();
 
-  // Send time for water
-  water_->SendTime(current_frame);
+  // Time for water, sent with the frame constants
+  elapsed_time_ = current_frame;
   terrain_->GenerationTick();
+  texture_arrays_.Update();
 
   // printf("mid = (%f,%f,%f)\n",left_lane_midpoint_.x,left_lane_midpoint_.y,left_lane_midpoint_.z);
   // printf("car = (%f,%f,%f)\n",car_->translation().x,car_->translation().y,car_->translation().z);
@@ -11,6 +11,9 @@
 #include "terrain.h"
 #include "object.h"
 #include "renderer.h"
+#include "gl_backend.h"
+#include "shadow_cache.h"
+#include "render_graph.h"
 #include "sun.h"
 #include "light_controller.h"
 #include "roadsign.h"
@@ -34,6 +37,26 @@
 #include <GL/glut.h>
 #endif
 
+// The passes of a frame, executed in this order
+//   Ordering of the passes is very important due to transparency
+//   The shadow passes are one per cascade, as the RenderPass they submit
+enum FrameNode {
+  // The terrain into the cached shadow layer, only when it is outdated
+  kStaticShadowNode = 0,
+  // The layer copied into the shadow map and the car drawn on top, by day
+  kShadowNode = kStaticShadowNode + kShadowCascades,
+  kOpaqueNode = kShadowNode + kShadowCascades,
+  kSkyNode,
+  kTransparentNode,
+  // Except at noon
+  kRainNode,
+  // The car around the first person camera, drawn after the rain
+  kOverlayNode,
+  // Debugging mode only
+  kAxisNode,
+  kFrameNodeCount,
+};
+
 class Controller {
   public:
 
@@ -44,6 +67,7 @@ class Controller {
     //   @param shader, a shader class holding shader to use and uniforms
     //   @param model_filename, a string containing the path of the .obj file
     //   @warn the model is created on the heap and memory must be freed afterwards
+    //   The object casts a shadow, see kShadowProxyCells
     Object * AddObject(const Shader & shader, const std::string &model_filename);
 
     // Render the scene (all member models)
@@ -67,11 +91,32 @@ class Controller {
     inline void KeyReleased(const int &key);
 
   private:
+    // The cells along the car's longest side its shadow proxy is clustered into
+    //   See Model::CreateShadowProxy, 0 draws the full shapes into the shadow map
+    static const unsigned int kShadowProxyCells = 24;
+
     // OBJECTS
+    // Issues the frame's commands to GL
+    GLBackend gl_backend_;
+    // Records the frame's commands per pass before forwarding them to GL
+    //   Only used in debugging mode
+    RecordingBackend recording_backend_;
+    // The shadow of the GL state, shared by all render code
+    //   @warn declared before the renderer which keeps a pointer to it
+    GLState gl_state_;
     // The renderer reference
     const Renderer renderer_;
+    // The draws of the current frame, sorted by state before submitting
+    RenderQueue render_queue_;
+    // The terrain's depth, kept until a tile changes or the sun moves
+    ShadowCache shadow_cache_;
+    // The passes of a frame, culled every frame with the work they need
+    RenderGraph render_graph_;
     // The shaders object (holds and compiles all shaders)
     const Shaders * shaders_;
+    // The texture arrays every loaded texture is a layer of
+    //   @warn declared before the terrain, signs and models loading into it
+    TextureArrays texture_arrays_;
     // The camera object
     Camera camera_;
     // The Sun object to control environment lighting
@@ -97,6 +142,9 @@ class Controller {
     Object * car_;
     // All the static models and their transforms in the scene
     std::vector<Object *> objects_;
+    // The props scattered beside the road, one per ScatterKind
+    //   Placed per tile by the terrain, see ScatterWorker
+    std::vector<Object *> scatter_props_;
     // The skybox object
     Skybox * skybox_;
     // The water object
@@ -121,6 +169,18 @@ class Controller {
 
     void PositionLights();
 
+    // FRAME PASSES
+    // The enable predicate of a pass
+    //   @param node, the pass
+    //   @param frame, the frame about to be drawn
+    //   @return  Whether the pass should be drawn this frame
+    bool IsNodeEnabled(const FrameNode node, const FrameContext &frame) const;
+    // Queues the draws of a live pass
+    void QueueNode(const FrameNode node, const FrameContext &frame);
+    // Draws a live pass
+    //   @warn requires the queue to be sorted
+    void ExecuteNode(const FrameNode node, const FrameContext &frame);
+
     // The shader to use to render Axis Coordinates
     GLuint axis_program_id;
 
@@ -131,6 +191,8 @@ class Controller {
     unsigned long long frames_past_;
     int frames_count_;
     GLfloat delta_time_;
+    // The elapsed time of the current tick in milliseconds (moves the water)
+    GLfloat elapsed_time_;
 
     // Hash representing keys pressed
     std::vector<bool> is_key_pressed_hash_;
@@ -0,0 +1,144 @@
+#include "frame_context.h"
+
+// The view depth past which nothing is shadowed, the fog hides it
+static const float kShadowDistance = 90.0f;
+// The view depth the logarithmic split scheme starts from
+static const float kShadowNear = 1.0f;
+// The blend of the logarithmic (1) and uniform (0) split schemes
+static const float kSplitBlend = 0.75f;
+// The distance towards the light casters outside a cascade are still drawn from
+static const float kCasterReach = 100.0f;
+// The texels a cascade moves by at once
+//   Snapping to whole texels stops the shadow edges shimmering, snapping to
+//   many keeps a cascade still for several frames so its cache stays valid
+static const float kSnapTexels = 32.0f;
+
+// Builds every shared matrix of the frame
+//   @param camera, the viewing camera
+//   @param sun, the sun (or moon) casting the shadows
+//   @param time, the elapsed time in milliseconds
+FrameContext::FrameContext(const Camera &camera, const Sun &sun, const float time) :
+  view(camera.view_matrix()),
+  projection(camera.projection_matrix()),
+  view_projection(projection * view),
+  view_normal(glm::transpose(glm::inverse(glm::mat3(view)))),
+  cam_pos(camera.cam_pos()),
+  sun_direction(sun.sun_direction()),
+  is_day(sun.IsDay()),
+  point_lights(0), spot_lights(0),
+  time(time) {
+    ExtractPlanes(view_projection, frustum);
+
+    // Split the frustum up to kShadowDistance, then bound every slice by a
+    // sphere along the view direction
+    //   k2 is the squared distance from the view axis to a frustum corner per
+    //   unit of depth
+    const glm::vec3 forward = -glm::vec3(view[0][2], view[1][2], view[2][2]);
+    const float tan_half_fov = tan(glm::radians(camera.fov() / 2.0f));
+    const float aspect = float(camera.width()) / float(camera.height());
+    const float k2 = tan_half_fov * tan_half_fov * (1.0f + aspect * aspect);
+    float split_start = 0.0f;
+    for (unsigned int x = 0; x < kShadowCascades; ++x) {
+      ShadowCascade &cascade = cascades[x];
+      const float ratio = float(x + 1) / kShadowCascades;
+      const float log_split = kShadowNear * pow(kShadowDistance / kShadowNear, ratio);
+      const float uniform_split = kShadowDistance * ratio;
+      cascade.split = kSplitBlend * log_split + (1.0f - kSplitBlend) * uniform_split;
+      // The center is equally far from the corners of both ends of the slice
+      const float d0 = split_start;
+      const float d1 = cascade.split;
+      const float depth = std::min((d0 + d1) * (1.0f + k2) / 2.0f, d1);
+      cascade.radius = sqrt((d1 - depth) * (d1 - depth) + k2 * d1 * d1);
+      cascade.center = cam_pos + forward * depth;
+      split_start = cascade.split;
+    }
+
+    // The light's point of view
+    // const glm::vec2 texel_size = glm::vec2(1.0f/1024.0f, 1.0f/1024.0f);
+    // const glm::vec3 snapped_cam_pos = glm::vec3(
+    //     floor(camera.cam_pos().x / texel_size.x) * texel_size.x,
+    //     float(),
+    //     floor(camera.cam_pos().z / texel_size.y) * texel_size.y);
+    // const glm::vec3 light_start = glm::vec3(snapped_cam_pos.x+35.0f,10.0f,snapped_cam_pos.z);
+    // const glm::vec3 light_end = glm::vec3(snapped_cam_pos.x-00.0f,-10.0f,snapped_cam_pos.z);
+    const glm::vec3 light_start = glm::vec3(sun.sun_start(), sun.sun_height(), sun.sun_target_z());
+    const glm::vec3 light_end = glm::vec3(sun.sun_target_x(),-10.0f, sun.sun_target_z());
+    SetLight(glm::normalize(light_end - light_start));
+}
+
+// Rebuilds the cascades' matrices to look along direction
+//   Every cascade is a square orthographic projection around its sphere
+//   whose center is snapped to kSnapTexels in light space
+//   @param direction, the normalized direction the shadow map is looked at
+void FrameContext::SetLight(const glm::vec3 &direction) {
+  const glm::mat4 BIAS = glm::mat4(0.5f, 0.0f, 0.0f, 0.0f,
+      0.0f, 0.5f, 0.0f, 0.0f,
+      0.0f, 0.0f, 0.5f, 0.0f,
+      0.5f, 0.5f, 0.5f, 1.0f);
+  light_direction = direction;
+  // Looks from the origin so the light space only changes with the direction
+  const glm::vec3 up = std::abs(direction.y) > 0.99f ? glm::vec3(0,0,1) : glm::vec3(0,1,0);
+  const glm::mat4 light_view = glm::lookAt(glm::vec3(0,0,0), direction, up);
+  for (unsigned int x = 0; x < kShadowCascades; ++x) {
+    ShadowCascade &cascade = cascades[x];
+    // Grown by a snap step so the sphere still fits once the center is snapped
+    const float half_size = cascade.radius / (1.0f - 2.0f * kSnapTexels / kShadowMapSize);
+    const float step = 2.0f * half_size / kShadowMapSize * kSnapTexels;
+    const glm::vec3 center = glm::vec3(light_view * glm::vec4(cascade.center, 1.0f));
+    const glm::vec3 snapped = glm::floor(center / step) * step;
+    const glm::mat4 light_projection = glm::ortho<float>(
+        snapped.x - half_size, snapped.x + half_size,
+        snapped.y - half_size, snapped.y + half_size,
+        -snapped.z - half_size - kCasterReach, -snapped.z + half_size);
+    cascade.view_projection = light_projection * light_view;
+    cascade.bias_view_projection = BIAS * cascade.view_projection;
+    ExtractPlanes(cascade.view_projection, cascade.frustum);
+  }
+}
+
+// Whether an axis aligned box is (at least partly) inside the frustum
+//   @param min, the lowest corner of the box
+//   @param max, the highest corner of the box
+bool FrameContext::IsBoxVisible(const glm::vec3 &min, const glm::vec3 &max) const {
+  return IsBoxInside(frustum, min, max);
+}
+
+// Whether an axis aligned box is (at least partly) inside a cascade
+//   @param cascade, the index of the cascade
+//   @param min, the lowest corner of the box
+//   @param max, the highest corner of the box
+bool FrameContext::IsBoxInCascade(const unsigned int cascade, const glm::vec3 &min, const glm::vec3 &max) const {
+  return IsBoxInside(cascades[cascade].frustum, min, max);
+}
+
+// The planes of the volume a view projection matrix clips to
+//   From the rows of the matrix (Gribb/Hartmann)
+//   @param m, the view projection matrix
+//   @param planes, filled with 6 planes ordered as frustum
+void FrameContext::ExtractPlanes(const glm::mat4 &m, glm::vec4 * planes) {
+  const glm::vec4 row_x = glm::vec4(m[0][0], m[1][0], m[2][0], m[3][0]);
+  const glm::vec4 row_y = glm::vec4(m[0][1], m[1][1], m[2][1], m[3][1]);
+  const glm::vec4 row_z = glm::vec4(m[0][2], m[1][2], m[2][2], m[3][2]);
+  const glm::vec4 row_w = glm::vec4(m[0][3], m[1][3], m[2][3], m[3][3]);
+  planes[0] = row_w + row_x;
+  planes[1] = row_w - row_x;
+  planes[2] = row_w + row_y;
+  planes[3] = row_w - row_y;
+  planes[4] = row_w + row_z;
+  planes[5] = row_w - row_z;
+}
+
+// Whether an axis aligned box is (at least partly) inside 6 planes
+//   Tests the corner furthest along each plane normal
+bool FrameContext::IsBoxInside(const glm::vec4 * planes, const glm::vec3 &min, const glm::vec3 &max) {
+  for (unsigned int x = 0; x < 6; ++x) {
+    const glm::vec4 &plane = planes[x];
+    const glm::vec3 corner = glm::vec3(
+        plane.x > 0.0f ? max.x : min.x,
+        plane.y > 0.0f ? max.y : min.y,
+        plane.z > 0.0f ? max.z : min.z);
+    if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f)
+      return false;
+  }
+  return true;
+}
@@ -0,0 +1,100 @@
+#ifndef ASSIGN3_FRAME_CONTEXT_H_
+#define ASSIGN3_FRAME_CONTEXT_H_
+
+#include <cmath>
+#include <algorithm>
+#include "camera.h"
+#include "sun.h"
+#include "shaders/uniform_blocks.h"
+
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+// The width and height of every shadow cascade
+const unsigned int kShadowMapSize = 512;
+
+// One cascade of the shadow map
+//   Covers the slice of the camera frustum between the previous cascade's
+//   split and its own, nearer cascades are smaller and hence sharper
+struct ShadowCascade {
+  // The view depth the cascade ends at
+  float split;
+  // The bounding sphere of its frustum slice
+  //   The radius only depends on the fov and aspect so it doesn't change
+  //   when the camera turns
+  glm::vec3 center;
+  float radius;
+  // The light's orthographic projection and view of the cascade
+  glm::mat4 view_projection;
+  // The above mapped from clip space [-1,1] to texture space [0,1]
+  glm::mat4 bias_view_projection;
+  // The world space planes of its volume, ordered as FrameContext::frustum
+  glm::vec4 frustum[6];
+};
+
+// The matrices and frustum shared by every draw of a frame
+//   Built once per frame from the Camera and Sun then passed to every render
+//   call, so the light's projection, view and bias and the camera's
+//   view projection are no longer rebuilt per draw
+struct FrameContext {
+  // CAMERA
+  glm::mat4 view;
+  glm::mat4 projection;
+  glm::mat4 view_projection;
+  // The normal matrix of the view
+  //   An object's modelview normal matrix is view_normal * object->normal_matrix()
+  glm::mat3 view_normal;
+  glm::vec3 cam_pos;
+  // The world space frustum planes, xyz is the inwards normal and w the distance
+  //   Ordered left, right, bottom, top, near, far
+  glm::vec4 frustum[6];
+
+  // SUN
+  // The direction the shadow map is looked at
+  glm::vec3 light_direction;
+  // The cascades of the shadow map, nearest first
+  ShadowCascade cascades[kShadowCascades];
+  glm::vec3 sun_direction;
+  bool is_day;
+
+  // LIGHTS
+  // The amount of each local light in the Lights block, 0 until set by the
+  // controller, picks the shaded variant, see Renderer::ShadedVariant
+  unsigned int point_lights;
+  unsigned int spot_lights;
+
+  // The elapsed time in milliseconds (moves the water)
+  float time;
+
+  // Builds every shared matrix of the frame
+  //   @param camera, the viewing camera
+  //   @param sun, the sun (or moon) casting the shadows
+  //   @param time, the elapsed time in milliseconds
+  FrameContext(const Camera &camera, const Sun &sun, const float time);
+
+  // Rebuilds the cascades' matrices to look along direction
+  //   e.g. to keep the light the cached shadow map was rendered with
+  //   @param direction, the normalized direction the shadow map is looked at
+  void SetLight(const glm::vec3 &direction);
+
+  // Whether an axis aligned box is (at least partly) inside the frustum
+  //   Conservative, boxes near the frustum corners may pass
+  //   @param min, the lowest corner of the box
+  //   @param max, the highest corner of the box
+  bool IsBoxVisible(const glm::vec3 &min, const glm::vec3 &max) const;
+  // Whether an axis aligned box is (at least partly) inside a cascade
+  //   i.e. it may cast a shadow into it
+  //   @param cascade, the index of the cascade
+  //   @param min, the lowest corner of the box
+  //   @param max, the highest corner of the box
+  bool IsBoxInCascade(const unsigned int cascade, const glm::vec3 &min, const glm::vec3 &max) const;
+
+  // The planes of the volume a view projection matrix clips to
+  //   @param m, the view projection matrix
+  //   @param planes, filled with 6 planes ordered as frustum
+  static void ExtractPlanes(const glm::mat4 &m, glm::vec4 * planes);
+  // Whether an axis aligned box is (at least partly) inside 6 planes
+  static bool IsBoxInside(const glm::vec4 * planes, const glm::vec3 &min, const glm::vec3 &max);
+};
+
+#endif
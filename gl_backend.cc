@@ -0,0 +1,255 @@
+#include "gl_backend.h"
+
+#include "shaders/shader_compiler/shader.hpp"
+
+// Nothing to do, GL has no notion of frames
+void GLBackend::BeginFrame() {
+}
+
+// Nothing to do, the label is only used when recording
+void GLBackend::BeginPass(const char * name) {
+}
+
+void GLBackend::BindFramebuffer(GLenum target, GLuint framebuffer) {
+  glBindFramebuffer(target, framebuffer);
+}
+
+void GLBackend::Viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+  glViewport(x, y, width, height);
+}
+
+void GLBackend::Clear(GLbitfield mask) {
+  glClear(mask);
+}
+
+void GLBackend::BlitFramebuffer(GLint src_x0, GLint src_y0, GLint src_x1, GLint src_y1,
+    GLint dst_x0, GLint dst_y0, GLint dst_x1, GLint dst_y1, GLbitfield mask, GLenum filter) {
+  glBlitFramebuffer(src_x0, src_y0, src_x1, src_y1, dst_x0, dst_y0, dst_x1, dst_y1, mask, filter);
+}
+
+void GLBackend::GenFramebuffers(GLsizei count, GLuint * framebuffers) {
+  glGenFramebuffers(count, framebuffers);
+}
+
+void GLBackend::FramebufferTextureLayer(GLenum target, GLenum attachment, GLuint texture,
+    GLint level, GLint layer) {
+  glFramebufferTextureLayer(target, attachment, texture, level, layer);
+}
+
+void GLBackend::DrawBuffer(GLenum buffer) {
+  glDrawBuffer(buffer);
+}
+
+void GLBackend::ReadBuffer(GLenum buffer) {
+  glReadBuffer(buffer);
+}
+
+GLenum GLBackend::CheckFramebufferStatus(GLenum target) {
+  return glCheckFramebufferStatus(target);
+}
+
+void GLBackend::UseProgram(GLuint program) {
+  glUseProgram(program);
+}
+
+void GLBackend::ActiveTexture(GLenum unit) {
+  glActiveTexture(unit);
+}
+
+void GLBackend::BindTexture(GLenum target, GLuint texture) {
+  glBindTexture(target, texture);
+}
+
+void GLBackend::BindVertexArray(GLuint vao) {
+  glBindVertexArray(vao);
+}
+
+void GLBackend::Enable(GLenum capability) {
+  glEnable(capability);
+}
+
+void GLBackend::Disable(GLenum capability) {
+  glDisable(capability);
+}
+
+void GLBackend::CullFace(GLenum mode) {
+  glCullFace(mode);
+}
+
+void GLBackend::PolygonMode(GLenum face, GLenum mode) {
+  glPolygonMode(face, mode);
+}
+
+void GLBackend::BlendFunc(GLenum source, GLenum destination) {
+  glBlendFunc(source, destination);
+}
+
+void GLBackend::DepthFunc(GLenum func) {
+  glDepthFunc(func);
+}
+
+void GLBackend::DepthMask(GLboolean flag) {
+  glDepthMask(flag);
+}
+
+void GLBackend::LineWidth(GLfloat width) {
+  glLineWidth(width);
+}
+
+void GLBackend::PixelStorei(GLenum name, GLint value) {
+  glPixelStorei(name, value);
+}
+
+void GLBackend::Uniform1i(GLint location, GLint value) {
+  glUniform1i(location, value);
+}
+
+void GLBackend::Uniform1f(GLint location, GLfloat value) {
+  glUniform1f(location, value);
+}
+
+void GLBackend::Uniform3f(GLint location, GLfloat x, GLfloat y, GLfloat z) {
+  glUniform3f(location, x, y, z);
+}
+
+void GLBackend::Uniform3fv(GLint location, GLsizei count, const GLfloat * value) {
+  glUniform3fv(location, count, value);
+}
+
+void GLBackend::UniformMatrix3fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat * value) {
+  glUniformMatrix3fv(location, count, transpose, value);
+}
+
+void GLBackend::UniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat * value) {
+  glUniformMatrix4fv(location, count, transpose, value);
+}
+
+void GLBackend::GenBuffers(GLsizei count, GLuint * buffers) {
+  glGenBuffers(count, buffers);
+}
+
+void GLBackend::DeleteBuffers(GLsizei count, const GLuint * buffers) {
+  glDeleteBuffers(count, buffers);
+}
+
+void GLBackend::GenVertexArrays(GLsizei count, GLuint * vaos) {
+  glGenVertexArrays(count, vaos);
+}
+
+void GLBackend::DeleteVertexArrays(GLsizei count, const GLuint * vaos) {
+  glDeleteVertexArrays(count, vaos);
+}
+
+void GLBackend::BindBuffer(GLenum target, GLuint buffer) {
+  glBindBuffer(target, buffer);
+}
+
+void GLBackend::BindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+  glBindBufferBase(target, index, buffer);
+}
+
+void GLBackend::BufferData(GLenum target, GLsizeiptr size, const GLvoid * data, GLenum usage) {
+  glBufferData(target, size, data, usage);
+}
+
+void GLBackend::BufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const GLvoid * data) {
+  glBufferSubData(target, offset, size, data);
+}
+
+void GLBackend::EnableVertexAttribArray(GLuint index) {
+  glEnableVertexAttribArray(index);
+}
+
+void GLBackend::VertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized,
+    GLsizei stride, const GLvoid * pointer) {
+  glVertexAttribPointer(index, size, type, normalized, stride, pointer);
+}
+
+void GLBackend::VertexAttribDivisor(GLuint index, GLuint divisor) {
+  glVertexAttribDivisor(index, divisor);
+}
+
+void GLBackend::GenTextures(GLsizei count, GLuint * textures) {
+  glGenTextures(count, textures);
+}
+
+void GLBackend::DeleteTextures(GLsizei count, const GLuint * textures) {
+  glDeleteTextures(count, textures);
+}
+
+void GLBackend::TexParameteri(GLenum target, GLenum name, GLint value) {
+  glTexParameteri(target, name, value);
+}
+
+void GLBackend::TexImage3D(GLenum target, GLint level, GLint internal_format, GLsizei width,
+    GLsizei height, GLsizei depth, GLint border, GLenum format, GLenum type, const GLvoid * pixels) {
+  glTexImage3D(target, level, internal_format, width, height, depth, border, format, type, pixels);
+}
+
+void GLBackend::TexSubImage3D(GLenum target, GLint level, GLint x, GLint y, GLint z,
+    GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const GLvoid * pixels) {
+  glTexSubImage3D(target, level, x, y, z, width, height, depth, format, type, pixels);
+}
+
+bool GLBackend::HasSamplerObjects() {
+  return GLEW_ARB_sampler_objects;
+}
+
+void GLBackend::GenSamplers(GLsizei count, GLuint * samplers) {
+  glGenSamplers(count, samplers);
+}
+
+void GLBackend::SamplerParameteri(GLuint sampler, GLenum name, GLint value) {
+  glSamplerParameteri(sampler, name, value);
+}
+
+void GLBackend::BindSampler(GLuint unit, GLuint sampler) {
+  glBindSampler(unit, sampler);
+}
+
+GLuint GLBackend::LoadProgram(const char * vertex_path, const char * fragment_path,
+    const char * defines, bool is_verbose) {
+  return LoadShaders(vertex_path, fragment_path, defines, is_verbose);
+}
+
+GLint GLBackend::GetUniformLocation(GLuint program, const GLchar * name) {
+  return glGetUniformLocation(program, name);
+}
+
+GLint GLBackend::GetAttribLocation(GLuint program, const GLchar * name) {
+  return glGetAttribLocation(program, name);
+}
+
+void GLBackend::GetProgramiv(GLuint program, GLenum name, GLint * value) {
+  glGetProgramiv(program, name, value);
+}
+
+void GLBackend::GetActiveUniform(GLuint program, GLuint index, GLsizei size, GLsizei * length,
+    GLint * uniform_size, GLenum * type, GLchar * name) {
+  glGetActiveUniform(program, index, size, length, uniform_size, type, name);
+}
+
+GLuint GLBackend::GetUniformBlockIndex(GLuint program, const GLchar * name) {
+  return glGetUniformBlockIndex(program, name);
+}
+
+void GLBackend::UniformBlockBinding(GLuint program, GLuint index, GLuint binding) {
+  glUniformBlockBinding(program, index, binding);
+}
+
+void GLBackend::DrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid * indices) {
+  glDrawElements(mode, count, type, indices);
+}
+
+void GLBackend::DrawArrays(GLenum mode, GLint first, GLsizei count) {
+  glDrawArrays(mode, first, count);
+}
+
+void GLBackend::DrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances) {
+  glDrawArraysInstanced(mode, first, count, instances);
+}
+
+void GLBackend::DrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const GLvoid * indices,
+    GLsizei instances) {
+  glDrawElementsInstanced(mode, count, type, indices, instances);
+}
@@ -0,0 +1,88 @@
+#ifndef ASSIGN3_GL_BACKEND_H_
+#define ASSIGN3_GL_BACKEND_H_
+
+#include <GL/glew.h>
+#include "render_backend.h"
+
+// Issues every command to the current GL context
+class GLBackend : public RenderBackend {
+  public:
+    void BeginFrame();
+    void BeginPass(const char * name);
+    void BindFramebuffer(GLenum target, GLuint framebuffer);
+    void Viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+    void Clear(GLbitfield mask);
+    void BlitFramebuffer(GLint src_x0, GLint src_y0, GLint src_x1, GLint src_y1,
+        GLint dst_x0, GLint dst_y0, GLint dst_x1, GLint dst_y1, GLbitfield mask, GLenum filter);
+    void GenFramebuffers(GLsizei count, GLuint * framebuffers);
+    void FramebufferTextureLayer(GLenum target, GLenum attachment, GLuint texture,
+        GLint level, GLint layer);
+    void DrawBuffer(GLenum buffer);
+    void ReadBuffer(GLenum buffer);
+    GLenum CheckFramebufferStatus(GLenum target);
+
+    void UseProgram(GLuint program);
+    void ActiveTexture(GLenum unit);
+    void BindTexture(GLenum target, GLuint texture);
+    void BindVertexArray(GLuint vao);
+    void Enable(GLenum capability);
+    void Disable(GLenum capability);
+    void CullFace(GLenum mode);
+    void PolygonMode(GLenum face, GLenum mode);
+    void BlendFunc(GLenum source, GLenum destination);
+    void DepthFunc(GLenum func);
+    void DepthMask(GLboolean flag);
+    void LineWidth(GLfloat width);
+    void PixelStorei(GLenum name, GLint value);
+
+    void Uniform1i(GLint location, GLint value);
+    void Uniform1f(GLint location, GLfloat value);
+    void Uniform3f(GLint location, GLfloat x, GLfloat y, GLfloat z);
+    void Uniform3fv(GLint location, GLsizei count, const GLfloat * value);
+    void UniformMatrix3fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat * value);
+    void UniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat * value);
+
+    void GenBuffers(GLsizei count, GLuint * buffers);
+    void DeleteBuffers(GLsizei count, const GLuint * buffers);
+    void GenVertexArrays(GLsizei count, GLuint * vaos);
+    void DeleteVertexArrays(GLsizei count, const GLuint * vaos);
+    void BindBuffer(GLenum target, GLuint buffer);
+    void BindBufferBase(GLenum target, GLuint index, GLuint buffer);
+    void BufferData(GLenum target, GLsizeiptr size, const GLvoid * data, GLenum usage);
+    void BufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const GLvoid * data);
+    void EnableVertexAttribArray(GLuint index);
+    void VertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized,
+        GLsizei stride, const GLvoid * pointer);
+    void VertexAttribDivisor(GLuint index, GLuint divisor);
+
+    void GenTextures(GLsizei count, GLuint * textures);
+    void DeleteTextures(GLsizei count, const GLuint * textures);
+    void TexParameteri(GLenum target, GLenum name, GLint value);
+    void TexImage3D(GLenum target, GLint level, GLint internal_format, GLsizei width,
+        GLsizei height, GLsizei depth, GLint border, GLenum format, GLenum type, const GLvoid * pixels);
+    void TexSubImage3D(GLenum target, GLint level, GLint x, GLint y, GLint z,
+        GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const GLvoid * pixels);
+
+    bool HasSamplerObjects();
+    void GenSamplers(GLsizei count, GLuint * samplers);
+    void SamplerParameteri(GLuint sampler, GLenum name, GLint value);
+    void BindSampler(GLuint unit, GLuint sampler);
+
+    GLuint LoadProgram(const char * vertex_path, const char * fragment_path,
+        const char * defines, bool is_verbose);
+    GLint GetUniformLocation(GLuint program, const GLchar * name);
+    GLint GetAttribLocation(GLuint program, const GLchar * name);
+    void GetProgramiv(GLuint program, GLenum name, GLint * value);
+    void GetActiveUniform(GLuint program, GLuint index, GLsizei size, GLsizei * length,
+        GLint * uniform_size, GLenum * type, GLchar * name);
+    GLuint GetUniformBlockIndex(GLuint program, const GLchar * name);
+    void UniformBlockBinding(GLuint program, GLuint index, GLuint binding);
+
+    void DrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid * indices);
+    void DrawArrays(GLenum mode, GLint first, GLsizei count);
+    void DrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances);
+    void DrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const GLvoid * indices,
+        GLsizei instances);
+};
+
+#endif
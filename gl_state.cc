@@ -0,0 +1,182 @@
+#include "gl_state.h"
+
+// Construct with the whole state unknown
+//   @param backend, the backend the changes are issued to
+GLState::GLState(RenderBackend * backend) :
+  backend_(backend) {
+    ResetFrame();
+  }
+
+// Forgets the shadowed state and resets the counters
+//   Should be called at the start of every frame, starts the backend's frame
+void GLState::ResetFrame() {
+  backend_->BeginFrame();
+  program_ = kUnknown;
+  active_unit_ = kUnknown;
+  for (unsigned int x = 0; x < kTextureUnits; ++x) {
+    for (unsigned int y = 0; y < kTextureTargets; ++y)
+      textures_[x][y] = kUnknown;
+  }
+  vao_ = kUnknown;
+  for (unsigned int x = 0; x < kCapabilities; ++x)
+    capabilities_[x] = kUnknown;
+  cull_face_ = kUnknown;
+  polygon_mode_ = kUnknown;
+  blend_source_ = kUnknown;
+  blend_destination_ = kUnknown;
+  depth_func_ = kUnknown;
+  depth_mask_ = kUnknown;
+
+  for (unsigned int x = 0; x < kStateCallCount; ++x) {
+    stats_.issued[x] = 0;
+    stats_.skipped[x] = 0;
+  }
+}
+
+// glUseProgram
+void GLState::UseProgram(const GLuint program) {
+  if (Change(kUseProgramCall, &program_, program))
+    backend_->UseProgram(program);
+}
+
+// glActiveTexture
+//   @param unit, GL_TEXTURE0 + n
+void GLState::ActiveTexture(const GLenum unit) {
+  if (Change(kActiveTextureCall, &active_unit_, unit))
+    backend_->ActiveTexture(unit);
+}
+
+// glBindTexture on the active texture unit
+//   Unknown units and targets always go to GL
+void GLState::BindTexture(const GLenum target, const GLuint texture) {
+  const int target_index = TargetIndex(target);
+  const unsigned int unit = active_unit_ - GL_TEXTURE0;
+  if (target_index < 0 || active_unit_ == kUnknown || unit >= kTextureUnits) {
+    ++stats_.issued[kBindTextureCall];
+    backend_->BindTexture(target, texture);
+    return;
+  }
+  if (Change(kBindTextureCall, &textures_[unit][target_index], texture))
+    backend_->BindTexture(target, texture);
+}
+
+// Binds a texture to a unit, only activating the unit if it needs a change
+//   @param unit, the unit number n (not GL_TEXTURE0 + n)
+void GLState::BindTexture(const unsigned int unit, const GLenum target, const GLuint texture) {
+  assert(unit < kTextureUnits && "texture unit not shadowed");
+  const int target_index = TargetIndex(target);
+  if (target_index >= 0 && textures_[unit][target_index] == texture) {
+    ++stats_.skipped[kBindTextureCall];
+    return;
+  }
+  ActiveTexture(GL_TEXTURE0 + unit);
+  BindTexture(target, texture);
+}
+
+// glBindVertexArray
+void GLState::BindVertexArray(const GLuint vao) {
+  if (Change(kBindVertexArrayCall, &vao_, vao))
+    backend_->BindVertexArray(vao);
+}
+
+// glEnable
+void GLState::Enable(const GLenum capability) {
+  const int index = CapabilityIndex(capability);
+  if (index < 0) {
+    ++stats_.issued[kCapabilityCall];
+    backend_->Enable(capability);
+  } else if (Change(kCapabilityCall, &capabilities_[index], GL_TRUE)) {
+    backend_->Enable(capability);
+  }
+}
+
+// glDisable
+void GLState::Disable(const GLenum capability) {
+  const int index = CapabilityIndex(capability);
+  if (index < 0) {
+    ++stats_.issued[kCapabilityCall];
+    backend_->Disable(capability);
+  } else if (Change(kCapabilityCall, &capabilities_[index], GL_FALSE)) {
+    backend_->Disable(capability);
+  }
+}
+
+// glCullFace
+void GLState::CullFace(const GLenum mode) {
+  if (Change(kCullFaceCall, &cull_face_, mode))
+    backend_->CullFace(mode);
+}
+
+// glPolygonMode for GL_FRONT_AND_BACK
+void GLState::PolygonMode(const GLenum mode) {
+  if (Change(kPolygonModeCall, &polygon_mode_, mode))
+    backend_->PolygonMode(GL_FRONT_AND_BACK, mode);
+}
+
+// glBlendFunc
+void GLState::BlendFunc(const GLenum source, const GLenum destination) {
+  if (blend_source_ == source && blend_destination_ == destination) {
+    ++stats_.skipped[kBlendFuncCall];
+    return;
+  }
+  blend_source_ = source;
+  blend_destination_ = destination;
+  ++stats_.issued[kBlendFuncCall];
+  backend_->BlendFunc(source, destination);
+}
+
+// glDepthFunc
+void GLState::DepthFunc(const GLenum func) {
+  if (Change(kDepthFuncCall, &depth_func_, func))
+    backend_->DepthFunc(func);
+}
+
+// glDepthMask
+void GLState::DepthMask(const GLboolean flag) {
+  if (Change(kDepthMaskCall, &depth_mask_, flag))
+    backend_->DepthMask(flag);
+}
+
+// The total calls issued to GL this frame
+unsigned int GLState::TotalIssued() const {
+  unsigned int total = 0;
+  for (unsigned int x = 0; x < kStateCallCount; ++x)
+    total += stats_.issued[x];
+  return total;
+}
+
+// The total calls skipped this frame
+unsigned int GLState::TotalSkipped() const {
+  unsigned int total = 0;
+  for (unsigned int x = 0; x < kStateCallCount; ++x)
+    total += stats_.skipped[x];
+  return total;
+}
+
+// The index of a texture target into textures_, -1 if not shadowed
+int GLState::TargetIndex(const GLenum target) {
+  switch (target) {
+    case GL_TEXTURE_2D:
+      return 0;
+    case GL_TEXTURE_2D_ARRAY:
+      return 1;
+    case GL_TEXTURE_CUBE_MAP:
+      return 2;
+    default:
+      return -1;
+  }
+}
+
+// The index of a capability into capabilities_, -1 if not shadowed
+int GLState::CapabilityIndex(const GLenum capability) {
+  switch (capability) {
+    case GL_BLEND:
+      return 0;
+    case GL_CULL_FACE:
+      return 1;
+    case GL_DEPTH_TEST:
+      return 2;
+    default:
+      return -1;
+  }
+}
@@ -0,0 +1,141 @@
+#ifndef ASSIGN3_GL_STATE_H_
+#define ASSIGN3_GL_STATE_H_
+
+#include <cassert>
+#include <GL/glew.h>
+#include "render_backend.h"
+
+// The calls a GLState shadows, indexes its counters
+enum GLStateCall {
+  kUseProgramCall = 0,
+  kActiveTextureCall,
+  kBindTextureCall,
+  kBindVertexArrayCall,
+  kCapabilityCall,      // glEnable and glDisable
+  kCullFaceCall,
+  kPolygonModeCall,
+  kBlendFuncCall,
+  kDepthFuncCall,
+  kDepthMaskCall,
+  kStateCallCount,
+};
+
+// The calls issued to and skipped from GL since the last ResetFrame
+struct GLStateStats {
+  unsigned int issued[kStateCallCount];
+  unsigned int skipped[kStateCallCount];
+};
+
+// A shadow of the GL state the render code changes
+//   Every call goes to the backend only when it changes the state, e.g. the same
+//   program or cull face twice in a row is only set once
+//   State changed by code not using the cache (loading, uploads) is
+//   forgotten once per frame by ResetFrame
+//   @warn one per GL context, only to be used from the GL thread
+class GLState {
+  public:
+    // Construct with the whole state unknown
+    //   @param backend, the backend the changes are issued to
+    explicit GLState(RenderBackend * backend);
+
+    // Forgets the shadowed state and resets the counters
+    //   Should be called at the start of every frame
+    void ResetFrame();
+
+    // glUseProgram
+    void UseProgram(const GLuint program);
+    // glActiveTexture
+    //   @param unit, GL_TEXTURE0 + n
+    void ActiveTexture(const GLenum unit);
+    // glBindTexture on the active texture unit
+    void BindTexture(const GLenum target, const GLuint texture);
+    // Binds a texture to a unit, only activating the unit if it needs a change
+    //   @param unit, the unit number n (not GL_TEXTURE0 + n)
+    void BindTexture(const unsigned int unit, const GLenum target, const GLuint texture);
+    // glBindVertexArray
+    void BindVertexArray(const GLuint vao);
+    // glEnable and glDisable
+    //   Only GL_BLEND, GL_CULL_FACE and GL_DEPTH_TEST are shadowed,
+    //   other capabilities always go to GL
+    void Enable(const GLenum capability);
+    void Disable(const GLenum capability);
+    // glCullFace
+    void CullFace(const GLenum mode);
+    // glPolygonMode for GL_FRONT_AND_BACK
+    void PolygonMode(const GLenum mode);
+    // glBlendFunc
+    void BlendFunc(const GLenum source, const GLenum destination);
+    // glDepthFunc
+    void DepthFunc(const GLenum func);
+    // glDepthMask
+    void DepthMask(const GLboolean flag);
+
+    // The total calls issued to GL this frame
+    unsigned int TotalIssued() const;
+    // The total calls skipped this frame
+    unsigned int TotalSkipped() const;
+
+    // Accessor for the counters of this frame
+    inline const GLStateStats &stats() const;
+    // Accessor for the backend, for the commands which aren't state
+    inline RenderBackend * backend() const;
+
+  private:
+    // The backend the changes are issued to
+    RenderBackend * const backend_;
+
+    // The texture units shadowed, the shadow map uses unit 20
+    static const unsigned int kTextureUnits = 21;
+    // The texture targets shadowed per unit
+    static const unsigned int kTextureTargets = 3;
+    // The shadowed capabilities
+    static const unsigned int kCapabilities = 3;
+    // The value of state which hasn't been set since ResetFrame
+    static const GLuint kUnknown = ~0u;
+
+    GLuint program_;
+    GLenum active_unit_;
+    GLuint textures_[kTextureUnits][kTextureTargets];
+    GLuint vao_;
+    // kUnknown, GL_FALSE or GL_TRUE
+    GLuint capabilities_[kCapabilities];
+    GLenum cull_face_;
+    GLenum polygon_mode_;
+    GLenum blend_source_;
+    GLenum blend_destination_;
+    GLenum depth_func_;
+    GLuint depth_mask_;
+
+    GLStateStats stats_;
+
+    // Counts a call, issued if the state changes
+    //   @return  Whether the call should be issued
+    inline bool Change(const GLStateCall call, GLuint * current, const GLuint value);
+    // The index of a texture target into textures_, -1 if not shadowed
+    static int TargetIndex(const GLenum target);
+    // The index of a capability into capabilities_, -1 if not shadowed
+    static int CapabilityIndex(const GLenum capability);
+};
+
+// Counts a call, issued if the state changes
+//   @return  Whether the call should be issued
+inline bool GLState::Change(const GLStateCall call, GLuint * current, const GLuint value) {
+  if (*current == value) {
+    ++stats_.skipped[call];
+    return false;
+  }
+  *current = value;
+  ++stats_.issued[call];
+  return true;
+}
+
+// Accessor for the counters of this frame
+inline const GLStateStats &GLState::stats() const {
+  return stats_;
+}
+// Accessor for the backend, for the commands which aren't state
+inline RenderBackend * GLState::backend() const {
+  return backend_;
+}
+
+#endif
@@ -0,0 +1,170 @@
+#include "horizon.h"
+
+// Construct with the shader used to render the terrain
+//   The strip is flat until the first Update
+//   @param shader, the shader to get the attribute locations from
+//   @param seed, the seed of the terrain generation
+//   @param backend, the backend the buffers are created and refilled through
+Horizon::Horizon(const Shader &shader, const unsigned int seed, RenderBackend * backend) :
+  shader_(shader), seed_(seed), backend_(backend),
+  indice_count_((kColumns - 1) * (kRows - 1) * 2 * 3) {
+    vertices_.resize(kColumns * kRows);
+    normals_.assign(kColumns * kRows, glm::vec3(0,1,0));
+    vao_handle_ = CreateVao();
+}
+
+// Deletes the VAO and its VBOs through the backend
+Horizon::~Horizon() {
+  backend_->DeleteVertexArrays(1, &vao_handle_);
+  const GLuint buffers[4] = { vbo_vertices_, vbo_normals_, vbo_uv_, vbo_indices_ };
+  backend_->DeleteBuffers(4, buffers);
+}
+
+// Rebuilds the strip to continue on from the end of the loaded tiles
+//   Only the vertice and normal VBOs are refilled, UV and indices never change
+//   @param start, the X/Z position the next tile will start from (road pivot)
+//   @param rotation, the heading of the next tile in degrees from positive z
+//   @param cliff_height, the cubic base height of the cliff side
+//   @param water_height, the cubic base height of the water side
+void Horizon::Update(const glm::vec2 &start, const float rotation,
+    const float cliff_height, const float water_height) {
+  // Same orientation as a rotated tile, i.e. glm::rotateY of the X and Z axis
+  const float cos_rot = cos(DEG2RAD(rotation));
+  const float sin_rot = sin(DEG2RAD(rotation));
+  const glm::vec3 right = glm::vec3(cos_rot, 0.0f, -sin_rot);
+  const glm::vec3 forward = glm::vec3(sin_rot, 0.0f, cos_rot);
+  const glm::vec3 origin = glm::vec3(start.x, 0.0f, start.y);
+
+  for (int z = 0; z < kRows; ++z) {
+    const float t = z / float(kRows - 1) * kLength;
+    for (int x = 0; x < kColumns; ++x) {
+      const float s = x / float(kColumns - 1) * (kWaterWidth + kCliffWidth) - kWaterWidth;
+      glm::vec3 &vertex = vertices_.at(x + z*kColumns);
+      vertex = origin + s * right + t * forward;
+      // Height modelled using X^3 like the tiles
+      if (s < 0) {
+        const float norm_s = s / kWaterWidth;
+        vertex.y = water_height * norm_s*norm_s*norm_s;
+      } else {
+        const float norm_s = s / kCliffWidth;
+        vertex.y = kCliffScale * cliff_height * norm_s*norm_s*norm_s
+          + norm_s * kNoiseHeight * Noise(vertex.x, vertex.z);
+      }
+    }
+  }
+
+  // Normals from the neighbouring vertices (clamped at the edges)
+  for (int z = 0; z < kRows; ++z) {
+    for (int x = 0; x < kColumns; ++x) {
+      const glm::vec3 &left = vertices_.at(std::max(x-1, 0) + z*kColumns);
+      const glm::vec3 &right = vertices_.at(std::min(x+1, kColumns-1) + z*kColumns);
+      const glm::vec3 &back = vertices_.at(x + std::max(z-1, 0)*kColumns);
+      const glm::vec3 &front = vertices_.at(x + std::min(z+1, kRows-1)*kColumns);
+      normals_.at(x + z*kColumns) = glm::normalize(glm::cross(front - back, right - left));
+    }
+  }
+
+  backend_->BindBuffer(GL_ARRAY_BUFFER, vbo_vertices_);
+  backend_->BufferSubData(GL_ARRAY_BUFFER, 0, sizeof(glm::vec3)*vertices_.size(), &vertices_[0]);
+  backend_->BindBuffer(GL_ARRAY_BUFFER, vbo_normals_);
+  backend_->BufferSubData(GL_ARRAY_BUFFER, 0, sizeof(glm::vec3)*normals_.size(), &normals_[0]);
+  backend_->BindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Deterministic value noise in the range [0,1]
+//   Bilinear interpolation of hashed lattice points with smoothstep weights
+//   @param x, the world x position
+//   @param z, the world z position
+float Horizon::Noise(const float x, const float z) const {
+  const float lattice_x = x / kNoiseSpacing;
+  const float lattice_z = z / kNoiseSpacing;
+  const int x0 = floor(lattice_x);
+  const int z0 = floor(lattice_z);
+  float u = lattice_x - x0;
+  float v = lattice_z - z0;
+  u = u*u*(3.0f - 2.0f*u);
+  v = v*v*(3.0f - 2.0f*v);
+  const float bot = Hash(x0, z0)   * (1-u) + Hash(x0+1, z0)   * u;
+  const float top = Hash(x0, z0+1) * (1-u) + Hash(x0+1, z0+1) * u;
+  return bot * (1-v) + top * v;
+}
+
+// Hashes a lattice point with the seed
+//   @return  A value in the range [0,1]
+float Horizon::Hash(const int x, const int z) const {
+  unsigned int h = seed_ ^ (unsigned int)(x) * 374761393u ^ (unsigned int)(z) * 668265263u;
+  h = (h ^ (h >> 13)) * 1274126177u;
+  h ^= h >> 16;
+  return (h & 0xffff) / 65535.0f;
+}
+
+// Creates the VAO with the constant UV and indices
+//   Vertices and normals are allocated here and filled by Update
+//   @return vao_handle, the vao handle
+GLuint Horizon::CreateVao() {
+  // Same winding as the terrain tiles
+  std::vector<int> indices;
+  indices.reserve(indice_count_);
+  for (int z = 0; z < kRows - 1; ++z) {
+    for (int x = 0; x < kColumns - 1; ++x) {
+      int vertex_index = z*kColumns + x;
+      // Top triangle (T0)
+      indices.push_back(vertex_index);                  // V0
+      indices.push_back(vertex_index + kColumns + 1);   // V3
+      indices.push_back(vertex_index + 1);              // V1
+      // Bottom triangle (T1)
+      indices.push_back(vertex_index);                  // V0
+      indices.push_back(vertex_index + kColumns);       // V2
+      indices.push_back(vertex_index + kColumns + 1);   // V3
+    }
+  }
+  // Texture repeats less than the tiles, it is only seen through fog
+  std::vector<glm::vec2> texture_coordinates_uv;
+  texture_coordinates_uv.reserve(kColumns * kRows);
+  for (int z = 0; z < kRows; ++z) {
+    for (int x = 0; x < kColumns; ++x) {
+      texture_coordinates_uv.push_back(glm::vec2(x, z*kLength/(kWaterWidth+kCliffWidth)));
+    }
+  }
+
+  GLuint vao_handle;
+  backend_->UseProgram(shader_.Id);
+  backend_->GenVertexArrays(1, &vao_handle);
+  backend_->BindVertexArray(vao_handle);
+
+  GLuint buffer[4];
+  backend_->GenBuffers(4, buffer);
+  vbo_vertices_ = buffer[0];
+  vbo_normals_ = buffer[1];
+  vbo_uv_ = buffer[2];
+  vbo_indices_ = buffer[3];
+
+  // Set vertex position
+  backend_->BindBuffer(GL_ARRAY_BUFFER, vbo_vertices_);
+  backend_->BufferData(GL_ARRAY_BUFFER,
+      sizeof(glm::vec3)*vertices_.size(), &vertices_[0], GL_DYNAMIC_DRAW);
+  backend_->VertexAttribPointer(shader_.vertLoc, 3, GL_FLOAT, GL_FALSE, 0, 0);
+  backend_->EnableVertexAttribArray(shader_.vertLoc);
+  // Normal attributes
+  backend_->BindBuffer(GL_ARRAY_BUFFER, vbo_normals_);
+  backend_->BufferData(GL_ARRAY_BUFFER,
+      sizeof(glm::vec3)*normals_.size(), &normals_[0], GL_DYNAMIC_DRAW);
+  backend_->VertexAttribPointer(shader_.normLoc, 3, GL_FLOAT, GL_FALSE, 0, 0);
+  backend_->EnableVertexAttribArray(shader_.normLoc);
+  // UV
+  backend_->BindBuffer(GL_ARRAY_BUFFER, vbo_uv_);
+  backend_->BufferData(GL_ARRAY_BUFFER,
+      sizeof(glm::vec2)*texture_coordinates_uv.size(), &texture_coordinates_uv[0], GL_STATIC_DRAW);
+  backend_->VertexAttribPointer(shader_.textureLoc, 2, GL_FLOAT, GL_FALSE, 0, 0);
+  backend_->EnableVertexAttribArray(shader_.textureLoc);
+  // Indices
+  backend_->BindBuffer(GL_ELEMENT_ARRAY_BUFFER, vbo_indices_);
+  backend_->BufferData(GL_ELEMENT_ARRAY_BUFFER,
+      sizeof(int)*indices.size(), &indices[0], GL_STATIC_DRAW);
+
+  // Un-bind
+  backend_->BindVertexArray(0);
+  backend_->BindBuffer(GL_ARRAY_BUFFER, 0);
+  backend_->BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+  return vao_handle;
+}
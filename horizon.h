@@ -0,0 +1,108 @@
+#ifndef ASSIGN3_HORIZON_H_
+#define ASSIGN3_HORIZON_H_
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include "camera.h"
+#include "shaders/shaders.h"
+#include "render_backend.h"
+
+#include "glm/glm.hpp"
+#include <GL/glew.h>
+
+// A cheap low resolution heightfield strip drawn past the end of the loaded tiles
+//   Continues on from where the next terrain tile will start, following its heading
+//   Heights use the same cubic base model as the tiles plus value noise keyed on the
+//   world position and the terrain seed, so the shapes don't pop when it moves on
+//   Is rendered in one draw call and relies on the terrain fog to blend it in
+class Horizon {
+  public:
+    // Construct with the shader used to render the terrain
+    //   @param shader, the shader to get the attribute locations from
+    //   @param seed, the seed of the terrain generation
+    //   @param backend, the backend the buffers are created and refilled through
+    Horizon(const Shader &shader, const unsigned int seed, RenderBackend * backend);
+    // Deletes the VAO and its VBOs through the backend
+    ~Horizon();
+
+    // Rebuilds the strip to continue on from the end of the loaded tiles
+    //   @param start, the X/Z position the next tile will start from (road pivot)
+    //   @param rotation, the heading of the next tile in degrees from positive z
+    //   @param cliff_height, the cubic base height of the cliff side
+    //   @param water_height, the cubic base height of the water side
+    void Update(const glm::vec2 &start, const float rotation,
+        const float cliff_height, const float water_height);
+
+    // Accessor for the VAO
+    inline GLuint vao_handle() const;
+    // Accessor for the amount of indices
+    //   Used in render to efficiently draw triangles
+    inline unsigned int indice_count() const;
+
+  private:
+    // CONSTANTS
+    // The amount of vertices across the strip
+    const unsigned char kColumns = 17;
+    // The amount of vertices along the strip
+    const unsigned char kRows = 13;
+    // The distance the strip covers along the heading
+    const float kLength = 180.0f;
+    // The distance the strip covers on the water side of the road
+    const float kWaterWidth = 20.0f;
+    // The distance the strip covers on the cliff side of the road
+    const float kCliffWidth = 120.0f;
+    // The scale of the cliff cubic compared to a tile
+    //   The strip is much wider than a tile so the cliffs are raised to match
+    const float kCliffScale = 4.0f;
+    // The height of the value noise at the outer cliff edge
+    const float kNoiseHeight = 25.0f;
+    // The spacing of the value noise lattice
+    const float kNoiseSpacing = 30.0f;
+
+    // The shader to get attribute locations from
+    const Shader shader_;
+    // The seed of the terrain generation
+    const unsigned int seed_;
+    // The backend the buffers are created and refilled through
+    RenderBackend * const backend_;
+    // The VAO handle for the strip
+    GLuint vao_handle_;
+    // The vertices and normals VBOs which are rebuilt on update
+    GLuint vbo_vertices_;
+    GLuint vbo_normals_;
+    // The UV and indice VBOs which never change
+    GLuint vbo_uv_;
+    GLuint vbo_indices_;
+    // The amount of indices, used to render the strip efficiently
+    unsigned int indice_count_;
+
+    // Vertices generated for the strip
+    std::vector<glm::vec3> vertices_;
+    // Normals generated for the strip
+    std::vector<glm::vec3> normals_;
+
+    // Deterministic value noise in the range [0,1]
+    //   @param x, the world x position
+    //   @param z, the world z position
+    float Noise(const float x, const float z) const;
+    // Hashes a lattice point with the seed
+    //   @return  A value in the range [0,1]
+    float Hash(const int x, const int z) const;
+    // Creates the VAO with the constant UV and indices
+    //   @return vao_handle, the vao handle
+    GLuint CreateVao();
+};
+
+// Accessor for the VAO
+inline GLuint Horizon::vao_handle() const {
+  return vao_handle_;
+}
+// Accessor for the amount of indices
+//   Used in render to efficiently draw triangles
+inline unsigned int Horizon::indice_count() const {
+  return indice_count_;
+}
+
+#endif
@@ -0,0 +1,48 @@
+#include "instance_ring.h"
+
+// Construct with an empty ring
+//   @param object, the geometry of every instance, must outlive the ring
+//   @param capacity, the amount of instance slots
+//   @warn requires a GL context
+InstanceRing::InstanceRing(const Object * object, const unsigned int capacity) :
+  object_(object), capacity_(capacity),
+  tiles_(capacity, -1), first_(0), count_(0) {
+    glGenBuffers(1, &buffer_);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer_);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(glm::mat4) * capacity_, NULL, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+  }
+
+InstanceRing::~InstanceRing() {
+  glDeleteBuffers(1, &buffer_);
+}
+
+// Adds an instance, replacing the oldest if the ring is full
+//   Only the slot written is uploaded
+//   @param model, the model matrix of the instance
+//   @param tile, the index of the tile it stands on
+void InstanceRing::Push(const glm::mat4 &model, const int tile) {
+  if (count_ == capacity_) {
+    first_ = (first_ + 1) % capacity_;
+    --count_;
+  }
+  const unsigned int slot = (first_ + count_) % capacity_;
+  tiles_[slot] = tile;
+  ++count_;
+
+  glBindBuffer(GL_ARRAY_BUFFER, buffer_);
+  glBufferSubData(GL_ARRAY_BUFFER, sizeof(glm::mat4) * slot, sizeof(glm::mat4), glm::value_ptr(model));
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Moves the tile of every instance back by one
+//   Drops the instances whose tile is no longer loaded, they are always
+//   the oldest as tiles are only added at the front
+void InstanceRing::ShiftTiles() {
+  for (unsigned int x = 0; x < count_; ++x)
+    --tiles_[(first_ + x) % capacity_];
+  while (count_ > 0 && tiles_[first_] < 0) {
+    first_ = (first_ + 1) % capacity_;
+    --count_;
+  }
+}
@@ -0,0 +1,95 @@
+#ifndef ASSIGN3_INSTANCE_RING_H_
+#define ASSIGN3_INSTANCE_RING_H_
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cassert>
+#include "object.h"
+
+#include "glm/glm.hpp"
+#include <GL/glew.h>
+#include "glm/gtc/type_ptr.hpp"
+
+// The placements of an object drawn with instanced draws
+//   The object's geometry is uploaded once, every placement is only a model
+//   matrix in a ring of instance slots. Each placement is tagged with the
+//   tile it stands on and dropped, oldest first, once that tile is passed
+//   The live slots are at most two runs of the ring, see run_at, so every
+//   draw of the object costs at most two instanced draws however many
+//   placements there are
+//   @usage InstanceRing * signs = new InstanceRing(sign_model, 32)
+class InstanceRing {
+  public:
+    // Construct with an empty ring
+    //   @param object, the geometry of every instance, must outlive the ring
+    //   @param capacity, the amount of instance slots
+    //   @warn requires a GL context
+    InstanceRing(const Object * object, const unsigned int capacity);
+    ~InstanceRing();
+
+    // Adds an instance, replacing the oldest if the ring is full
+    //   @param model, the model matrix of the instance
+    //   @param tile, the index of the tile it stands on
+    void Push(const glm::mat4 &model, const int tile);
+    // Moves the tile of every instance back by one
+    //   Drops the instances whose tile is no longer loaded
+    //   Should be called with Terrain::ProceedTiles
+    void ShiftTiles();
+
+    // The amount of runs of live slots, 0, 1 or 2
+    inline unsigned int run_count() const;
+    // The [first, first + count) slots of a run
+    //   @param index of run
+    //   @return  The first slot and the amount of slots
+    inline std::pair<unsigned int, unsigned int> run_at(const unsigned int x) const;
+    // Accessor for the object of every instance
+    inline const Object * object() const;
+    // Accessor for the buffer of model matrices, one per slot
+    inline GLuint buffer() const;
+    // Accessor for the amount of live instances
+    inline unsigned int count() const;
+
+  private:
+    const Object * const object_;
+    const unsigned int capacity_;
+    // The model matrix of every slot
+    GLuint buffer_;
+    // The tile of every slot
+    std::vector<int> tiles_;
+    // The oldest live slot
+    unsigned int first_;
+    // The amount of live slots from first_, wrapping around
+    unsigned int count_;
+};
+
+// The amount of runs of live slots, 0, 1 or 2
+inline unsigned int InstanceRing::run_count() const {
+  if (count_ == 0)
+    return 0;
+  return first_ + count_ > capacity_ ? 2 : 1;
+}
+// The [first, first + count) slots of a run
+//   The first run starts at the oldest instance, the second at slot 0
+//   @param index of run
+//   @return  The first slot and the amount of slots
+inline std::pair<unsigned int, unsigned int> InstanceRing::run_at(const unsigned int x) const {
+  assert(x < run_count() && "Trying to access a run out of bounds");
+  if (x == 0)
+    return std::make_pair(first_, std::min(count_, capacity_ - first_));
+  return std::make_pair(0u, first_ + count_ - capacity_);
+}
+// Accessor for the object of every instance
+inline const Object * InstanceRing::object() const {
+  return object_;
+}
+// Accessor for the buffer of model matrices, one per slot
+inline GLuint InstanceRing::buffer() const {
+  return buffer_;
+}
+// Accessor for the amount of live instances
+inline unsigned int InstanceRing::count() const {
+  return count_;
+}
+
+#endif
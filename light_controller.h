@@ -20,6 +20,8 @@
 #include <GL/glew.h>
 #include "glm/glm.hpp"
 #include "glm/gtc/type_ptr.hpp"
+#include "shaders/uniform_blocks.h"
+#include "render_backend.h"
 
 #ifdef __APPLE__
 #include <GLUT/glut.h>
@@ -86,14 +88,54 @@ struct SpotLight : PointLight
 };
 
 // Class to take care of sending light data into shader program
+//   The lights are packed into the std140 Lights block, one buffer update
+//   per tick is shared by every shader declaring the block
 
 class LightController
 {
 public:
+  // Creates the uniform buffer for the Lights block
+  //   @param backend, the backend every buffer command goes through
+  explicit LightController(RenderBackend * backend);
+  // Frees the uniform buffer
+  ~LightController();
+
   // Sets light properties
-  void SetDirectionalLight(GLuint program_id, const DirectionalLight& light);
-  void SetPointLights(GLuint program_id, unsigned int numLights, const PointLight* lights);
-  void SetSpotLights(GLuint program_id, unsigned int numLights, const SpotLight* lights);
+  //   Only stored until the next Upload
+  void SetDirectionalLight(const DirectionalLight& light);
+  void SetPointLights(unsigned int numLights, const PointLight* lights);
+  void SetSpotLights(unsigned int numLights, const SpotLight* lights);
+  // Uploads the stored lights and binds the Lights block
+  //   Should be called once per tick after the lights are set
+  void Upload() const;
+
+  // Accessors for the amount of stored lights
+  inline unsigned int point_light_count() const;
+  inline unsigned int spot_light_count() const;
+
+private:
+  // The backend every buffer command goes through
+  RenderBackend * const backend_;
+  // The std140 image of the Lights block
+  LightsBlock block_;
+  // The uniform buffer backing the Lights block
+  GLuint buffer_;
+  // Packs the base of a light into its std140 image
+  static void PackBase(const BaseLight& light, BaseLightBlock * base);
+  // Packs a point light into its std140 image
+  static void PackPoint(const PointLight& light, PointLightBlock * point);
 };
 
+// Accessor for the amount of stored point lights
+inline unsigned int LightController::point_light_count() const
+{
+  return block_.NumPointLights;
+}
+
+// Accessor for the amount of stored spot lights
+inline unsigned int LightController::spot_light_count() const
+{
+  return block_.NumSpotLights;
+}
+
 #endif
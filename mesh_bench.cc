@@ -0,0 +1,158 @@
+/**
+ * mesh_bench, a headless load time benchmark for the shipped models
+ *
+ * Times parsing every model the game loads from its OBJ file against mapping
+ * it from the MeshCache, checks the mapped mesh matches the parsed one and
+ * prints the timings as JSON. Needs no OpenGL, the upload is stood in for by
+ * reading every byte the model's buffers would be filled with
+ *
+ * Usage: ./mesh_bench [repeats = 5]
+ *   Exits with 1 if a mapped mesh differs from its parsed one
+ *   Exits with 2 if the argument isn't a positive whole number
+ *   Leaves the cache of every model filled, as the game would
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <chrono>
+
+#include "mesh_cache.h"
+
+// The directory the game caches its meshes in, see model.cc
+static const char * const kMeshCacheDirectory = "models/cache";
+// Every model the game loads, see controller.cc and roadsign.cc
+static const char * kModels[] = {
+  "models/Pick-up_Truck/pickup_wind_alpha.obj",
+  "models/Signs_OBJ/working/60.obj",
+  "models/Signs_OBJ/working/curve_left.obj",
+  "models/Signs_OBJ/working/curve_right.obj",
+  "models/Scatter/rock.obj",
+  "models/Scatter/shrub.obj",
+  "models/Scatter/post.obj",
+};
+static const unsigned int kModelCount = sizeof(kModels) / sizeof(kModels[0]);
+
+// The milliseconds since a time point
+static double ElapsedMs(const std::chrono::steady_clock::time_point &start) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Reads every byte of a mesh's buffers, as the upload would
+//   @return  A checksum, so the reads aren't optimised away
+static unsigned int Touch(const MappedMesh &mesh) {
+  unsigned int sum = 0;
+  const unsigned char * bytes = reinterpret_cast<const unsigned char *>(mesh.positions);
+  for (size_t x = 0; x < sizeof(glm::vec3) * mesh.vertex_count; ++x)
+    sum += bytes[x];
+  bytes = reinterpret_cast<const unsigned char *>(mesh.attributes);
+  for (size_t x = 0; x < sizeof(VertexAttributes) * mesh.vertex_count; ++x)
+    sum += bytes[x];
+  for (unsigned int x = 0; x < mesh.index_count; ++x)
+    sum += mesh.indices[x];
+  return sum;
+}
+
+// Whether a mapped mesh holds the same mesh as a parsed one
+static bool IsEqual(const MappedMesh &mapped, const MeshBuffers &parsed) {
+  MappedMesh view;
+  MeshCache::View(parsed, &view);
+  return mapped.min == view.min && mapped.max == view.max
+    && mapped.material_count == view.material_count
+    && mapped.shape_count == view.shape_count
+    && mapped.vertex_count == view.vertex_count
+    && mapped.index_count == view.index_count
+    && memcmp(mapped.materials, view.materials, sizeof(MeshMaterial) * view.material_count) == 0
+    && memcmp(mapped.shapes, view.shapes, sizeof(MeshShape) * view.shape_count) == 0
+    && memcmp(mapped.positions, view.positions, sizeof(glm::vec3) * view.vertex_count) == 0
+    && memcmp(mapped.attributes, view.attributes, sizeof(VertexAttributes) * view.vertex_count) == 0
+    && memcmp(mapped.indices, view.indices, sizeof(unsigned int) * view.index_count) == 0;
+}
+
+// Parses an argument as a count
+//   @param count, set to the count
+//   @return  false if it isn't a whole number above 0
+static bool ParseCount(const char * argument, unsigned int * count) {
+  char * end;
+  errno = 0;
+  const long value = strtol(argument, &end, 10);
+  if (end == argument || *end != '\0' || errno == ERANGE || value <= 0 || value > INT_MAX)
+    return false;
+  *count = value;
+  return true;
+}
+
+// The median of the samples
+static double Median(std::vector<double> samples) {
+  if (samples.empty())
+    return 0.0;
+  std::sort(samples.begin(), samples.end());
+  return samples[samples.size() / 2];
+}
+
+int main(int argc, char **argv) {
+  unsigned int repeats = 5;
+  if (argc > 2 || (argc == 2 && !ParseCount(argv[1], &repeats))) {
+    fprintf(stderr, "Usage: %s [repeats = 5]\n", argv[0]);
+    return 2;
+  }
+  const MeshCache cache(kMeshCacheDirectory);
+  unsigned int failures = 0;
+  unsigned int checksum = 0;
+
+  printf("{\n");
+  printf("  \"repeats\": %u,\n", repeats);
+  printf("  \"models\": {\n");
+  for (unsigned int model = 0; model < kModelCount; ++model) {
+    std::vector<double> parse_ms, map_ms;
+    MeshBuffers parsed;
+    for (unsigned int x = 0; x < repeats; ++x) {
+      // Cold, parsed from the OBJ as on the first run
+      MeshBuffers buffers;
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      MeshCache::Build(kModels[model], &buffers);
+      MappedMesh view;
+      MeshCache::View(buffers, &view);
+      checksum += Touch(view);
+      parse_ms.push_back(ElapsedMs(start));
+      if (x == 0) {
+        cache.Store(kModels[model], buffers);
+        parsed = buffers;
+      }
+    }
+    for (unsigned int x = 0; x < repeats; ++x) {
+      // Warm, mapped from the cache as on later runs
+      MappedMesh mesh;
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      if (!cache.Map(kModels[model], &mesh)) {
+        fprintf(stderr, "mesh_bench - %s: could not map its cache file\n", kModels[model]);
+        ++failures;
+        break;
+      }
+      checksum += Touch(mesh);
+      map_ms.push_back(ElapsedMs(start));
+      if (x == 0 && !IsEqual(mesh, parsed)) {
+        fprintf(stderr, "mesh_bench - %s: mapped mesh differs from the parsed one\n", kModels[model]);
+        ++failures;
+      }
+      MeshCache::Unmap(&mesh);
+    }
+
+    const double parse = Median(parse_ms);
+    const double map = Median(map_ms);
+    printf("    \"%s\": { \"vertices\": %zu, \"indices\": %zu, \"parse_ms\": %.3f, \"map_ms\": %.3f, \"speedup\": %.1f }%s\n",
+        kModels[model], parsed.positions.size(), parsed.indices.size(), parse, map,
+        map > 0.0 ? parse / map : 0.0, model == kModelCount - 1 ? "" : ",");
+  }
+  printf("  },\n");
+  printf("  \"checksum\": %u,\n", checksum);
+  printf("  \"failures\": %u\n", failures);
+  printf("}\n");
+
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,274 @@
+#include "mesh_cache.h"
+
+#include <map>
+#include <cassert>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include "model_data.h"
+
+// The file of the texture a material samples
+//   Materials without a texture sample the default texture
+//   @param subdir, the directory of the OBJ file
+//   @return  The path of the texture
+static std::string TextureFilename(const RawModelData::Material *material, const std::string &subdir) {
+  const std::string& ambient_texture = material->ambient_texture;
+  const std::string& diffuse_texture = material->diffuse_texture;
+  const std::string& specular_texture = material->specular_texture;
+  const std::string& normal_texture = material->normal_texture;
+
+  //Check 0 or 1 texture in material
+  //assert(texture_count <= 1 && "More than 1 texture found in material");
+  if (ambient_texture.size() > 0)
+    return subdir + ambient_texture;
+  if (specular_texture.size() > 0)
+    return subdir + specular_texture;
+  if (normal_texture.size() > 0)
+    return subdir + normal_texture;
+  if (diffuse_texture.size() > 0)
+    return subdir + diffuse_texture;
+  return "textures/default.png";
+}
+
+// Construct with the directory the files are kept in
+MeshCache::MeshCache(const std::string &directory) : directory_(directory) {
+}
+
+// Maps a source's cache file
+//   The pages are read as they are uploaded, nothing is parsed
+//   @param mesh, set to the mapping, see Unmap
+//   @return  false if there is no file or it is stale
+bool MeshCache::Map(const std::string &source, MappedMesh * mesh) const {
+  MeshCacheHeader expected = MeshCacheHeader();
+  if (!SourceHeader(source, &expected))
+    return false;
+  const int descriptor = open(CachePath(source).c_str(), O_RDONLY);
+  if (descriptor == -1)
+    return false;
+  struct stat status;
+  if (fstat(descriptor, &status) != 0 || size_t(status.st_size) < sizeof(MeshCacheHeader)) {
+    close(descriptor);
+    return false;
+  }
+  void * base = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+  // The mapping holds its own reference to the file
+  close(descriptor);
+  if (base == MAP_FAILED)
+    return false;
+
+  mesh->base = base;
+  mesh->length = status.st_size;
+  const MeshCacheHeader &header = *static_cast<const MeshCacheHeader *>(base);
+  if (memcmp(header.magic, expected.magic, 4) != 0
+      || header.version != expected.version
+      || header.source_mtime != expected.source_mtime
+      || header.source_size != expected.source_size
+      || header.shape_count == 0
+      || mesh->length != FileLength(header)) {
+    Unmap(mesh);
+    return false;
+  }
+  mesh->min = header.min;
+  mesh->max = header.max;
+  const char * next = static_cast<const char *>(base) + sizeof(MeshCacheHeader);
+  mesh->materials = reinterpret_cast<const MeshMaterial *>(next);
+  mesh->material_count = header.material_count;
+  next += sizeof(MeshMaterial) * header.material_count;
+  mesh->shapes = reinterpret_cast<const MeshShape *>(next);
+  mesh->shape_count = header.shape_count;
+  next += sizeof(MeshShape) * header.shape_count;
+  mesh->positions = reinterpret_cast<const glm::vec3 *>(next);
+  next += sizeof(glm::vec3) * header.vertex_count;
+  mesh->attributes = reinterpret_cast<const VertexAttributes *>(next);
+  mesh->vertex_count = header.vertex_count;
+  next += sizeof(VertexAttributes) * header.vertex_count;
+  mesh->indices = reinterpret_cast<const unsigned int *>(next);
+  mesh->index_count = header.index_count;
+  // The texture names are passed on as strings, one without its terminator
+  // would be read past its end
+  for (unsigned int x = 0; x < mesh->material_count; ++x) {
+    if (!memchr(mesh->materials[x].texture, 0, sizeof(mesh->materials[x].texture))) {
+      Unmap(mesh);
+      return false;
+    }
+  }
+  // The shapes are uploaded by range, a corrupt range must not reach GL
+  for (unsigned int x = 0; x < mesh->shape_count; ++x) {
+    const MeshShape &shape = mesh->shapes[x];
+    if (shape.material >= mesh->material_count || shape.first_index > mesh->index_count
+        || shape.index_count > mesh->index_count - shape.first_index) {
+      Unmap(mesh);
+      return false;
+    }
+  }
+  return true;
+}
+
+// Writes a source's mesh, replacing its file
+//   Written to a temporary file first, so a reader never sees half a file
+void MeshCache::Store(const std::string &source, const MeshBuffers &buffers) const {
+  MeshCacheHeader header = MeshCacheHeader();
+  if (!SourceHeader(source, &header) || buffers.shapes.empty())
+    return;
+  header.min = buffers.min;
+  header.max = buffers.max;
+  header.material_count = buffers.materials.size();
+  header.shape_count = buffers.shapes.size();
+  header.vertex_count = buffers.positions.size();
+  header.index_count = buffers.indices.size();
+
+  // Fails harmlessly if it exists
+  mkdir(directory_.c_str(), 0755);
+  const std::string path = CachePath(source);
+  const std::string temporary = path + ".tmp";
+  FILE * file = fopen(temporary.c_str(), "wb");
+  if (!file) {
+    fprintf(stderr, "MeshCache - could not write %s\n", temporary.c_str());
+    return;
+  }
+  // Empty vectors write nothing, fwrite of 0 items is not an error
+  bool is_written = fwrite(&header, sizeof(header), 1, file) == 1;
+  is_written = is_written && fwrite(buffers.materials.data(), sizeof(MeshMaterial),
+      header.material_count, file) == header.material_count;
+  is_written = is_written && fwrite(buffers.shapes.data(), sizeof(MeshShape),
+      header.shape_count, file) == header.shape_count;
+  is_written = is_written && fwrite(buffers.positions.data(), sizeof(glm::vec3),
+      header.vertex_count, file) == header.vertex_count;
+  is_written = is_written && fwrite(buffers.attributes.data(), sizeof(VertexAttributes),
+      header.vertex_count, file) == header.vertex_count;
+  is_written = is_written && fwrite(buffers.indices.data(), sizeof(unsigned int),
+      header.index_count, file) == header.index_count;
+  fclose(file);
+  if (!is_written || rename(temporary.c_str(), path.c_str()) != 0) {
+    fprintf(stderr, "MeshCache - could not write %s\n", path.c_str());
+    remove(temporary.c_str());
+  }
+}
+
+// Unmaps a mapping of Map, does nothing to a view
+void MeshCache::Unmap(MappedMesh * mesh) {
+  if (mesh->base != NULL)
+    munmap(mesh->base, mesh->length);
+  mesh->base = NULL;
+  mesh->length = 0;
+}
+
+// Parses an OBJ file into a mesh
+//   Every used material gets a slot in order of first use, each vertex keeps
+//   its slot in its attributes. Shapes without normals or UVs get defaults
+//   @param source, the OBJ file
+//   @param buffers, set to the mesh
+void MeshCache::Build(const std::string &source, MeshBuffers * buffers) {
+  ModelData model_data(source);
+  const std::string subdir = source.substr(0, source.find_last_of('/') + 1);
+  buffers->min = glm::vec3(model_data.GetMin(ModelData::kX), model_data.GetMin(ModelData::kY),
+      model_data.GetMin(ModelData::kZ));
+  buffers->max = glm::vec3(model_data.GetMax(ModelData::kX), model_data.GetMax(ModelData::kY),
+      model_data.GetMax(ModelData::kZ));
+
+  // Parse Materials to material_container
+  std::vector<RawModelData::Material*> material_container;
+  RawModelData::Material* next_material = model_data.material_at(0);
+  assert(next_material != NULL && "There are no materials");
+  unsigned int material_index = 0;
+  while (next_material != NULL) {
+    material_container.push_back(next_material);
+    material_index++;
+    next_material = model_data.material_at(material_index);
+  }
+
+  std::map<int, unsigned int> material_slot;
+  RawModelData::Shape* next_shape = model_data.shape_at(0);
+  assert(next_shape != NULL && "There are no shapes");
+  unsigned int shape_index = 0;
+  while (next_shape != NULL) {
+    const RawModelData::Material *working_material = material_container.at(next_shape->material_id);
+    std::map<int, unsigned int>::iterator slot = material_slot.find(next_shape->material_id);
+    if (slot == material_slot.end()) {
+      slot = material_slot.insert(std::make_pair(next_shape->material_id, buffers->materials.size())).first;
+      MeshMaterial material = {};
+      material.ambient = working_material->ambient;
+      material.diffuse = working_material->diffuse;
+      material.specular = working_material->specular;
+      material.shininess = working_material->shininess;
+      material.dissolve = working_material->dissolve;
+      const std::string texture = TextureFilename(working_material, subdir);
+      assert(texture.size() < sizeof(material.texture) && "Texture path too long for the mesh cache");
+      strncpy(material.texture, texture.c_str(), sizeof(material.texture) - 1);
+      buffers->materials.push_back(material);
+    }
+
+    assert(next_shape->indices.size() % 3 == 0);
+    MeshShape shape;
+    shape.material = slot->second;
+    shape.first_index = buffers->indices.size();
+    shape.index_count = next_shape->indices.size();
+    buffers->shapes.push_back(shape);
+    const unsigned int base = buffers->positions.size();
+    for (unsigned int z = 0; z < next_shape->vertices.size(); ++z) {
+      buffers->positions.push_back(next_shape->vertices[z]);
+      VertexAttributes attribute;
+      attribute.normal = z < next_shape->normals.size() ? next_shape->normals[z] : glm::vec3(0,1,0);
+      attribute.uv = z < next_shape->texture_coordinates_uv.size() ? next_shape->texture_coordinates_uv[z] : glm::vec2(0,0);
+      attribute.material = slot->second;
+      buffers->attributes.push_back(attribute);
+    }
+    for (unsigned int z = 0; z < next_shape->indices.size(); ++z)
+      buffers->indices.push_back(base + next_shape->indices[z]);
+
+    shape_index++;
+    next_shape = model_data.shape_at(shape_index);
+  }
+}
+
+// Points a mesh at buffers, valid while they are
+void MeshCache::View(const MeshBuffers &buffers, MappedMesh * mesh) {
+  mesh->base = NULL;
+  mesh->length = 0;
+  mesh->min = buffers.min;
+  mesh->max = buffers.max;
+  mesh->materials = buffers.materials.data();
+  mesh->material_count = buffers.materials.size();
+  mesh->shapes = buffers.shapes.data();
+  mesh->shape_count = buffers.shapes.size();
+  mesh->positions = buffers.positions.data();
+  mesh->attributes = buffers.attributes.data();
+  mesh->vertex_count = buffers.positions.size();
+  mesh->indices = buffers.indices.data();
+  mesh->index_count = buffers.indices.size();
+}
+
+// The cache file of a source, named by the FNV-1a hash of its path
+std::string MeshCache::CachePath(const std::string &source) const {
+  unsigned long long hash = 14695981039346656037ull;
+  for (unsigned int x = 0; x < source.size(); ++x)
+    hash = (hash ^ static_cast<unsigned char>(source[x])) * 1099511628211ull;
+  char name[32];
+  snprintf(name, sizeof(name), "/%016llx.mesh", hash);
+  return directory_ + name;
+}
+
+// The header a source's file must have, without its bounds and counts
+//   @return  false if the source doesn't exist
+bool MeshCache::SourceHeader(const std::string &source, MeshCacheHeader * header) {
+  struct stat status;
+  if (stat(source.c_str(), &status) != 0)
+    return false;
+  *header = MeshCacheHeader();
+  memcpy(header->magic, "A3MS", 4);
+  header->version = kVersion;
+  header->source_mtime = status.st_mtime;
+  header->source_size = status.st_size;
+  return true;
+}
+
+// The bytes of a file with the header's counts
+size_t MeshCache::FileLength(const MeshCacheHeader &header) {
+  return sizeof(MeshCacheHeader)
+    + sizeof(MeshMaterial) * size_t(header.material_count)
+    + sizeof(MeshShape) * size_t(header.shape_count)
+    + (sizeof(glm::vec3) + sizeof(VertexAttributes)) * size_t(header.vertex_count)
+    + sizeof(unsigned int) * size_t(header.index_count);
+}
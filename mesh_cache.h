@@ -0,0 +1,134 @@
+#ifndef ASSIGN3_MESH_CACHE_H_
+#define ASSIGN3_MESH_CACHE_H_
+
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstring>
+#include <cstddef>
+
+#include "glm/glm.hpp"
+
+// The attributes of a vertex besides its position, interleaved
+struct VertexAttributes {
+  glm::vec3 normal;
+  glm::vec2 uv;
+  // The material slot, a float as it is a vertex attribute
+  float material;
+};
+static_assert(sizeof(VertexAttributes) == 24, "VertexAttributes must be tightly packed");
+
+// A material slot of a mesh, slots are numbered in order of first use
+struct MeshMaterial {
+  glm::vec3 ambient;
+  glm::vec3 diffuse;
+  glm::vec3 specular;
+  float shininess;
+  float dissolve;
+  // The path of the texture it samples, see MeshCache::Build
+  char texture[244];
+};
+static_assert(sizeof(MeshMaterial) == 288, "MeshMaterial must be tightly packed");
+
+// A shape of a mesh, its triangles are a range of the indices
+struct MeshShape {
+  // The material slot
+  unsigned int material;
+  unsigned int first_index;
+  unsigned int index_count;
+};
+
+// The header of a cache file, followed by the materials, shapes, positions,
+//   attributes and indices
+//   @warn  bump kVersion when the layout or the contents change
+struct MeshCacheHeader {
+  // "A3MS"
+  char magic[4];
+  unsigned int version;
+  // The source file the mesh was parsed from, stale if either differs
+  long long source_mtime;
+  long long source_size;
+  // The bounds of the vertices
+  glm::vec3 min;
+  glm::vec3 max;
+  unsigned int material_count;
+  unsigned int shape_count;
+  unsigned int vertex_count;
+  unsigned int index_count;
+};
+static_assert(sizeof(MeshCacheHeader) == 64, "MeshCacheHeader must be tightly packed");
+
+// A mesh as it is built from an OBJ file
+struct MeshBuffers {
+  glm::vec3 min;
+  glm::vec3 max;
+  std::vector<MeshMaterial> materials;
+  std::vector<MeshShape> shapes;
+  std::vector<glm::vec3> positions;
+  std::vector<VertexAttributes> attributes;
+  // Every shape's indices, into the positions and attributes of every shape
+  std::vector<unsigned int> indices;
+};
+
+// A mesh mapped from a cache file, or a view of MeshBuffers
+struct MappedMesh {
+  // The mapping, the header included, NULL for a view
+  void * base;
+  size_t length;
+  glm::vec3 min;
+  glm::vec3 max;
+  const MeshMaterial * materials;
+  unsigned int material_count;
+  const MeshShape * shapes;
+  unsigned int shape_count;
+  const glm::vec3 * positions;
+  const VertexAttributes * attributes;
+  unsigned int vertex_count;
+  const unsigned int * indices;
+  unsigned int index_count;
+};
+
+// A directory of meshes parsed from OBJ files, one file per source
+//   Filled the first time a source is parsed, later runs map the mesh and
+//   upload it straight from the mapping instead of parsing. A file is stale
+//   once its source's modification time or size changes
+//   @warn  only the OBJ is checked, clear the directory after editing a material
+class MeshCache {
+  public:
+    // Construct with the directory the files are kept in
+    explicit MeshCache(const std::string &directory);
+
+    // Maps a source's cache file
+    //   @param mesh, set to the mapping, see Unmap
+    //   @return  false if there is no file or it is stale
+    bool Map(const std::string &source, MappedMesh * mesh) const;
+    // Writes a source's mesh, replacing its file
+    void Store(const std::string &source, const MeshBuffers &buffers) const;
+    // Unmaps a mapping of Map, does nothing to a view
+    static void Unmap(MappedMesh * mesh);
+
+    // Parses an OBJ file into a mesh
+    //   Shapes are kept in file order, their indices offset to the shared vertices
+    //   @param source, the OBJ file
+    //   @param buffers, set to the mesh
+    static void Build(const std::string &source, MeshBuffers * buffers);
+    // Points a mesh at buffers, valid while they are
+    static void View(const MeshBuffers &buffers, MappedMesh * mesh);
+
+  private:
+    // CONSTANTS
+    static const unsigned int kVersion = 1;
+
+    // The directory the files are kept in
+    const std::string directory_;
+
+    // The cache file of a source
+    std::string CachePath(const std::string &source) const;
+    // The header a source's file must have, without its bounds and counts
+    //   @return  false if the source doesn't exist
+    static bool SourceHeader(const std::string &source, MeshCacheHeader * header);
+    // The bytes of a file with the header's counts
+    static size_t FileLength(const MeshCacheHeader &header);
+};
+
+#endif
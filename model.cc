@@ -1,19 +1,37 @@
 #include "model.h"
 
-Model::Model(const Shader &shader, const std::string &model_filename,
+// Where the parsed meshes are cached
+static const char * const kMeshCacheDirectory = "models/cache";
+
+Model::Model(const Shader &shader, TextureArrays * textures, const std::string &model_filename,
     // Next line of parameters are optional variables for object (parent) construction
     const glm::vec3 &position, const glm::vec3 &rotation, const glm::vec3 &scale,
-    float speed, bool debug)
-: Object(position, rotation, scale, speed, debug), shader_(shader), amount_points_(0) {
-
-  model_data_ = new ModelData( model_filename );
-  subdir_ = model_filename.substr(0, model_filename.find_last_of('/') + 1);
-  max_x_ = model_data_->GetMax( ModelData::kX );
-  max_y_ = model_data_->GetMax( ModelData::kY );
-  max_z_ = model_data_->GetMax( ModelData::kZ );
-  min_x_ = model_data_->GetMin( ModelData::kX );
-  min_y_ = model_data_->GetMin( ModelData::kY );
-  min_z_ = model_data_->GetMin( ModelData::kZ );
+    float speed, bool debug,
+    // Next line of parameters are optional variables for shadow casting models
+    const Shader * depth_shader, const unsigned int shadow_proxy_cells)
+: Object(position, rotation, scale, speed, debug), shader_(shader), depth_shader_(depth_shader),
+  depth_vao_(0), material_block_(0), shadow_proxy_vao_(0), shadow_proxy_points_(0), amount_points_(0) {
+
+  // Map the parsed mesh, or parse the OBJ file and cache it for the next run
+  const MeshCache cache(kMeshCacheDirectory);
+  MeshBuffers buffers;
+  MappedMesh mesh;
+  if (!cache.Map(model_filename, &mesh)) {
+    MeshCache::Build(model_filename, &buffers);
+    cache.Store(model_filename, buffers);
+    MeshCache::View(buffers, &mesh);
+  }
+  if (mesh.material_count > kMaxMaterials) {
+    fprintf(stderr, "Model - %s uses %u materials, the Materials block holds %u\n",
+        model_filename.c_str(), mesh.material_count, kMaxMaterials);
+    exit(1);
+  }
+  max_x_ = mesh.max.x;
+  max_y_ = mesh.max.y;
+  max_z_ = mesh.max.z;
+  min_x_ = mesh.min.x;
+  min_y_ = mesh.min.y;
+  min_z_ = mesh.min.z;
   max_ = max_x_;
   if (max_y_ > max_)
     max_ = max_y_;
@@ -25,198 +43,241 @@ Model::Model(const Shader &shader, const std::string &model_filename,
   if (min_z_ < min_)
     min_ = min_z_;
 
-  ConstructShadedModel();
+  ConstructShadedModel(textures, mesh);
+  if (depth_shader_ != NULL && shadow_proxy_cells > 0)
+    CreateShadowProxy(mesh, shadow_proxy_cells);
 
-  delete model_data_;
+  MeshCache::Unmap(&mesh);
 }
 
-void Model::ConstructShadedModel() {
-  // Parse Materials to material_container
-  std::vector<RawModelData::Material*> material_container;
-  RawModelData::Material* next_material = model_data_->material_at(0);
-  assert(next_material != NULL && "There are no materials");
-  unsigned int material_index = 0;
-  while (next_material != NULL) {
-    material_container.push_back(next_material);
-    material_index++;
-    next_material = model_data_->material_at(material_index);
+// Merges every shape into one VAO, drawn once per texture array and transparency
+//   Shapes whose textures share an array are concatenated into one index
+//   range, each vertex keeps its material, and so its layer, through
+//   a_material and the Materials block
+//   A shape is transparent if its material dissolves or its texture has
+//   alpha, the opaque draws come first
+//   @param textures, the arrays the textures are loaded into
+//   @param mesh, the mapped or built mesh
+void Model::ConstructShadedModel(TextureArrays * textures, const MappedMesh &mesh) {
+  // Load the texture and create the Surface Colours of every material slot
+  std::vector<TextureLayer> slot_textures;
+  for (unsigned int x = 0; x < mesh.material_count; ++x) {
+    const MeshMaterial &material = mesh.materials[x];
+    slot_textures.push_back(textures->Load(material.texture));
+    ambient_surface_colours_.push_back(material.ambient);
+    diffuse_surface_colours_.push_back(material.diffuse);
+    specular_surface_colours_.push_back(material.specular);
+    shininess_.push_back(material.shininess);
+    dissolve_.push_back(material.dissolve);
+    texture_layers_.push_back(slot_textures.back().layer);
   }
-  // Add VAO for every shape
-  RawModelData::Shape* next_shape = model_data_->shape_at(0);
-  assert(next_shape != NULL && "There are no shapes");  
-  unsigned int shape_index = 0;
-  std::pair<unsigned int, GLuint> next_handle;
-  while (next_shape != NULL) {
-    RawModelData::Material *working_material = material_container.at(next_shape->material_id);
-    // Pair VAO and Texture into vao_texture_handle_
-    next_handle.first = CreateVao( next_shape );
-    next_handle.second = CreateTextures(working_material);
-    vao_texture_handle_.push_back( next_handle );
-    // Create Surface Colours Corresponding to vao_texture_handle_ indexes
-    ambient_surface_colours_.push_back(working_material->ambient);
-    diffuse_surface_colours_.push_back(working_material->diffuse);
-    specular_surface_colours_.push_back(working_material->specular);
-    shininess_.push_back(working_material->shininess);
-    dissolve_.push_back(working_material->dissolve);
-
-    shape_index++;
-    next_shape = model_data_->shape_at(shape_index);
+
+  // Group the shapes by transparency and texture array
+  std::map<std::pair<bool, GLuint>, std::vector<unsigned int> > draw_shapes;
+  assert(mesh.shape_count > 0 && "There are no shapes");
+  for (unsigned int x = 0; x < mesh.shape_count; ++x) {
+    const unsigned int slot = mesh.shapes[x].material;
+    const bool is_transparent = dissolve_[slot] < 1.0f || slot_textures[slot].has_alpha;
+    draw_shapes[std::make_pair(is_transparent, slot_textures[slot].texture)].push_back(x);
   }
-}
 
-// Creates a new vertex array object and loads in data into a vertex attribute buffer
-//   Now we are associating two attributes with our VAO
-//   @return vao_handle, the vao handle
-unsigned int Model::CreateVao ( const RawModelData::Shape *shape ) {
-  glUseProgram(shader()->Id);
-  const std::vector<unsigned int>& indices = shape->indices;
-  const std::vector<glm::vec3>& vertices = shape->vertices;
-  const std::vector<glm::vec3>& normals = shape->normals;
-  std::vector<glm::vec2> texture_coordinates_uv = shape->texture_coordinates_uv;
-  if ( texture_coordinates_uv.size() == 0 ) {
-    std::vector<glm::vec2> dummy_uv;
-    dummy_uv.push_back( glm::vec2(0,0) );
-    dummy_uv.push_back( glm::vec2(0,1) );
-    dummy_uv.push_back( glm::vec2(1,1) );
-    dummy_uv.push_back( glm::vec2(1,0) );
-    texture_coordinates_uv = dummy_uv;
+  // Order the shapes draw by draw
+  std::vector<unsigned int> shape_order;
+  for (std::map<std::pair<bool, GLuint>, std::vector<unsigned int> >::const_iterator draw = draw_shapes.begin();
+      draw != draw_shapes.end(); ++draw) {
+    vao_texture_handle_.push_back(std::make_pair(0u, draw->first.second));
+    is_transparent_.push_back(draw->first.first);
+    first_point_per_shape_.push_back(amount_points_);
+    for (unsigned int y = 0; y < draw->second.size(); ++y) {
+      shape_order.push_back(draw->second[y]);
+      amount_points_ += mesh.shapes[draw->second[y]].index_count;
+    }
+    points_per_shape_.push_back(amount_points_ - first_point_per_shape_.back());
   }
 
-  assert( indices.size() % 3 == 0 );
-  amount_points_ += indices.size();
-  points_per_shape_.push_back(indices.size());
+  const GLuint vao = CreateVao(mesh, shape_order);
+  for (unsigned int x = 0; x < vao_texture_handle_.size(); ++x)
+    vao_texture_handle_[x].first = vao;
+  material_block_ = CreateMaterialBlock();
+}
 
+// Creates the VAO of the merged shapes
+//   Positions are a VBO of their own so the depth VAO only fetches them,
+//   the rest of each vertex is interleaved in a second VBO
+//   Every buffer is filled straight from the mesh, the indices a shape at a time
+//   @param mesh, the mapped or built mesh
+//   @param shape_order, every shape in draw order
+//   @return vao_handle, the vao handle
+//   @warn also creates depth_vao_ if the model has a depth shader
+GLuint Model::CreateVao(const MappedMesh &mesh, const std::vector<unsigned int> &shape_order) {
   assert(sizeof(glm::vec3) == sizeof(GLfloat) * 3); //Vec3 cannot be loaded to buffer this way
 
-  unsigned int vao_handle;
+  GLuint vao_handle;
   glGenVertexArrays(1, &vao_handle);
   glBindVertexArray(vao_handle);
 
-  int vertLoc = glGetAttribLocation(shader()->Id, "a_vertex");
-  int textureLoc = glGetAttribLocation(shader()->Id, "a_texture");
-  int normLoc = glGetAttribLocation(shader()->Id, "a_normal");
-
-  // Buffers to store position, colour and index data
-  unsigned int buffer[4];
-  glGenBuffers(4, buffer);
+  // Buffers to store position, attribute and index data
+  GLuint buffer[3];
+  glGenBuffers(3, buffer);
 
   // Set vertex position
   glBindBuffer(GL_ARRAY_BUFFER, buffer[0]);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * vertices.size() , &vertices[0], GL_STATIC_DRAW);
-  glEnableVertexAttribArray(vertLoc);
-  glVertexAttribPointer(vertLoc, 3, GL_FLOAT, GL_FALSE, 0, 0);
-  // Normal attributes
+  glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * mesh.vertex_count, mesh.positions, GL_STATIC_DRAW);
+  glEnableVertexAttribArray(shader_.vertLoc);
+  glVertexAttribPointer(shader_.vertLoc, 3, GL_FLOAT, GL_FALSE, 0, 0);
+  // Normal, texture and material attributes
+  const GLsizei stride = sizeof(VertexAttributes);
   glBindBuffer(GL_ARRAY_BUFFER, buffer[1]);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * normals.size(), &normals[0], GL_STATIC_DRAW);
-  glEnableVertexAttribArray(normLoc);
-  glVertexAttribPointer(normLoc, 3, GL_FLOAT, GL_FALSE, 0, 0);
-  // Texture attributes
-  glBindBuffer(GL_ARRAY_BUFFER, buffer[2]);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec2) * texture_coordinates_uv.size(), &texture_coordinates_uv[0], GL_STATIC_DRAW);
-  glEnableVertexAttribArray(textureLoc);
-  glVertexAttribPointer(textureLoc, 2, GL_FLOAT, GL_FALSE, 0, 0);
+  glBufferData(GL_ARRAY_BUFFER, stride * mesh.vertex_count, mesh.attributes, GL_STATIC_DRAW);
+  glEnableVertexAttribArray(shader_.normLoc);
+  glVertexAttribPointer(shader_.normLoc, 3, GL_FLOAT, GL_FALSE, stride,
+      (const GLvoid *) offsetof(VertexAttributes, normal));
+  glEnableVertexAttribArray(shader_.textureLoc);
+  glVertexAttribPointer(shader_.textureLoc, 2, GL_FLOAT, GL_FALSE, stride,
+      (const GLvoid *) offsetof(VertexAttributes, uv));
+  glEnableVertexAttribArray(shader_.materialLoc);
+  glVertexAttribPointer(shader_.materialLoc, 1, GL_FLOAT, GL_FALSE, stride,
+      (const GLvoid *) offsetof(VertexAttributes, material));
   // Set element attributes. Notice the change to using GL_ELEMENT_ARRAY_BUFFER
   // We don't attach this to a shader label, instead it controls how rendering is performed
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer[3]);
+  //   The shapes are in file order, each is copied to its draw's range
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer[2]);
   glBufferData(GL_ELEMENT_ARRAY_BUFFER, 
-      sizeof(unsigned int) * indices.size(), &indices[0], GL_STATIC_DRAW);   
+      sizeof(unsigned int) * amount_points_, NULL, GL_STATIC_DRAW);   
+  GLintptr offset = 0;
+  for (unsigned int x = 0; x < shape_order.size(); ++x) {
+    const MeshShape &shape = mesh.shapes[shape_order[x]];
+    const GLsizeiptr length = sizeof(unsigned int) * shape.index_count;
+    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, offset, length, mesh.indices + shape.first_index);
+    offset += length;
+  }
   // Un-bind
   glBindVertexArray(0);
   glBindBuffer(GL_ARRAY_BUFFER, 0);
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
+  // Position only VAO for the shadow map
+  //   Shares the position and index VBOs, the depth shader reads nothing else
+  if (depth_shader_ != NULL) {
+    glGenVertexArrays(1, &depth_vao_);
+    glBindVertexArray(depth_vao_);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer[0]);
+    glEnableVertexAttribArray(depth_shader_->vertLoc);
+    glVertexAttribPointer(depth_shader_->vertLoc, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer[2]);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+  }
+
   return vao_handle;
 }
 
-// Creates a texture pointer from file
-//   @return new_texture, a GLuint texture pointer
-GLuint Model::CreateTextures( const RawModelData::Material *material ) {
-  const std::string& ambient_texture = material->ambient_texture;
-  const std::string& diffuse_texture = material->diffuse_texture;
-  const std::string& specular_texture = material->specular_texture;
-  const std::string& normal_texture = material->normal_texture;
-
-  // A shader program has many texture units, slots in which a texture can be bound, available to
-  // it and this function defines which unit we are working with currently
-  // We will only use unit 0 until later in the course. This is the default.
-  glActiveTexture(GL_TEXTURE0);
-
-  glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT );
-  glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT );
-
-  GLuint new_texture;
-
-  //Check 0 or 1 texture in material
-  unsigned int texture_count = 0;
-  if (ambient_texture.size() > 0)
-    texture_count++;
-  if (diffuse_texture.size() > 0)
-    texture_count++;
-  if (specular_texture.size() > 0)
-    texture_count++;
-  if (normal_texture.size() > 0)
-    texture_count++;
-  //assert(texture_count <= 1 && "More than 1 texture found in material");
-  glGenTextures( 1, &new_texture );
-  glBindTexture( GL_TEXTURE_2D, new_texture );
-
-  // load an image from file as texture 1
-  int x, y, n;
-  unsigned char *data;
-  if (texture_count == 0) {
-    data = stbi_load(
-        "textures/default.png", /*char* filepath */
-        &x, /*The address to store the width of the image*/
-        &y, /*The address to store the height of the image*/
-        &n,  /*Number of channels in the image*/
-        0   /*Force number of channels if > 0*/
-        );
-    assert(data != NULL && "Error loading default texture");
-
-    if (n == 3) {
-      glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, x, y, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-    }
-    else if (n == 4) {
-      glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, x, y, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-    } else {
-      fprintf(stderr, "Image pixels are not RGB/RBGA. You will need to change the glTexImage2D command.");
-      exit(0);
-    }
-  } 
-  else {
-    std::string filename = subdir_;
-    if (ambient_texture.size() > 0) {
-      filename += ambient_texture;
-    } else if (specular_texture.size() > 0) {
-      filename += specular_texture;
-    } else if (normal_texture.size() > 0) {
-      filename += normal_texture;
-    } else if (diffuse_texture.size() > 0) {
-      filename += diffuse_texture;
-    }
-    data = stbi_load(
-        filename.c_str(), /*char* filepath */
-        &x, /*The address to store the width of the image*/
-        &y, /*The address to store the height of the image*/
-        &n,  /*Number of channels in the image*/
-        0   /*Force number of channels if > 0*/
-        );
-    assert(data != NULL && "Error loading texture");
-
-    if (n == 3) {
-      glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, x, y, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
+// Creates the uniform buffer for the Materials block
+//   Filled with every material slot, the rest is left zero
+//   @return  The buffer handle, sized for kMaxMaterials
+GLuint Model::CreateMaterialBlock() const {
+  MaterialBlock block[kMaxMaterials] = {};
+  for (unsigned int x = 0; x < ambient_surface_colours_.size(); ++x) {
+    block[x].ambient = ambient_surface_colours_[x];
+    block[x].diffuse = diffuse_surface_colours_[x];
+    block[x].specular = specular_surface_colours_[x];
+    block[x].shininess = shininess_[x];
+    block[x].dissolve = dissolve_[x];
+    block[x].layer = texture_layers_[x];
+  }
+  GLuint buffer;
+  glGenBuffers(1, &buffer);
+  glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+  glBufferData(GL_UNIFORM_BUFFER, sizeof(block), block, GL_STATIC_DRAW);
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  return buffer;
+}
+
+// Merges every shape into a low poly proxy by vertex clustering
+//   Vertices are snapped into cubic cells, each cell becomes the average of
+//   its vertices and triangles which collapse or repeat are dropped
+//   The winding is kept so the proxy can be front face culled like the shapes
+//   @param mesh, the mapped or built mesh
+//   @param cells, the amount of cells along the longest side of the model
+//   @warn requires depth_shader_
+void Model::CreateShadowProxy(const MappedMesh &mesh, const unsigned int cells) {
+  const glm::vec3 min(min_x_, min_y_, min_z_);
+  const glm::vec3 max(max_x_, max_y_, max_z_);
+  const glm::vec3 extent = max - min;
+  const float cell_size = std::max(extent.x, std::max(extent.y, extent.z)) / cells;
+  assert(cell_size > 0 && "The model has no extent");
+  // The cells per axis, the last one holds the maximum
+  const unsigned int row = cells + 1;
+
+  // The cluster (proxy vertex) of every occupied cell
+  std::map<unsigned int, unsigned int> cell_cluster;
+  std::vector<glm::vec3> sums;
+  std::vector<unsigned int> counts;
+  // Every kept triangle, rotated to start at its lowest cluster
+  std::set<unsigned long long> triangles;
+  std::vector<unsigned int> indices;
+  std::vector<unsigned int> vertex_clusters;
+  vertex_clusters.reserve(mesh.vertex_count);
+
+  // Cluster the vertices
+  for (unsigned int x = 0; x < mesh.vertex_count; ++x) {
+    const glm::vec3 &vertex = mesh.positions[x];
+    const glm::vec3 cell = glm::min(glm::floor((vertex - min) / cell_size), glm::vec3(cells));
+    const unsigned int key = unsigned(cell.x) + unsigned(cell.y)*row + unsigned(cell.z)*row*row;
+    std::map<unsigned int, unsigned int>::iterator it = cell_cluster.find(key);
+    if (it == cell_cluster.end()) {
+      it = cell_cluster.insert(std::make_pair(key, sums.size())).first;
+      sums.push_back(glm::vec3(0,0,0));
+      counts.push_back(0);
     }
-    else if (n == 4) {
-      glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, x, y, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-    } else {
-      fprintf(stderr, "Image pixels are not RGB/RBGA. You will need to change the glTexImage2D command.");
-      exit(0);
+    sums[it->second] += vertex;
+    ++counts[it->second];
+    vertex_clusters.push_back(it->second);
+  }
+  // Remap the triangles, shape by shape
+  for (unsigned int y = 0; y < mesh.shape_count; ++y) {
+    const unsigned int * shape_indices = mesh.indices + mesh.shapes[y].first_index;
+    for (unsigned int x = 0; x + 2 < mesh.shapes[y].index_count; x += 3) {
+      unsigned long long a = vertex_clusters[shape_indices[x]];
+      unsigned long long b = vertex_clusters[shape_indices[x+1]];
+      unsigned long long c = vertex_clusters[shape_indices[x+2]];
+      if (a == b || b == c || c == a)
+        continue;
+      // Rotate (not sort) to keep the winding
+      while (a > b || a > c) {
+        const unsigned long long t = a;
+        a = b; b = c; c = t;
+      }
+      if (!triangles.insert(a | b << 21 | c << 42).second)
+        continue;
+      indices.push_back(a);
+      indices.push_back(b);
+      indices.push_back(c);
     }
   }
+  assert(sums.size() < (1u << 21) && "Too many cells for the triangle keys");
 
-  stbi_image_free(data);
-
-  glGenerateMipmap(GL_TEXTURE_2D); 
+  std::vector<glm::vec3> vertices;
+  vertices.reserve(sums.size());
+  for (unsigned int x = 0; x < sums.size(); ++x)
+    vertices.push_back(sums[x] / float(counts[x]));
+  shadow_proxy_points_ = indices.size();
+  if (indices.empty())
+    return;
 
-  return new_texture;
+  glGenVertexArrays(1, &shadow_proxy_vao_);
+  glBindVertexArray(shadow_proxy_vao_);
+  unsigned int buffer[2];
+  glGenBuffers(2, buffer);
+  glBindBuffer(GL_ARRAY_BUFFER, buffer[0]);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * vertices.size(), &vertices[0], GL_STATIC_DRAW);
+  glEnableVertexAttribArray(depth_shader_->vertLoc);
+  glVertexAttribPointer(depth_shader_->vertLoc, 3, GL_FLOAT, GL_FALSE, 0, 0);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer[1]);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * indices.size(), &indices[0], GL_STATIC_DRAW);
+  // Un-bind
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
@@ -3,10 +3,18 @@
 
 #include <vector>
 #include <string>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <set>
+#include <map>
+#include <algorithm>
 #include <cassert>
-#include "model_data.h"
+#include "mesh_cache.h"
 #include "object.h"
+#include "texture_arrays.h"
 #include "shaders/shaders.h"
+#include "shaders/uniform_blocks.h"
 
 #include "glm/glm.hpp"
 #include <GL/glew.h>
@@ -22,7 +30,10 @@
 
 // Is a child of Object, inherits extra transformation members and methods
 //   Creates and stores VAO and Material data for rendering
-//   @usage Object * car = new model(program_id, "car-n.obj")
+//   Its textures are layers of the shared TextureArrays
+//   The OBJ file is parsed once into a MeshCache, later runs upload the
+//   buffers straight from the mapped mesh
+//   @usage Object * car = new model(program_id, textures, "car-n.obj")
 class Model : public Object {
   public:
     // Enum for vertex coordinates
@@ -38,17 +49,21 @@ class Model : public Object {
       kMax = 3,
     };  
 
-    Model(const Shader & shader, const std::string &model_filename, 
+    Model(const Shader & shader, TextureArrays * textures, const std::string &model_filename, 
         // Below are optional variables for object (parent) construction
         const glm::vec3 &position = glm::vec3(0,0,0), const glm::vec3 &rotation = glm::vec3(0,0,0), const glm::vec3 &scale = glm::vec3(1,1,1),
-        float starting_speed = 0, bool debugging_on = false);
+        float starting_speed = 0, bool debugging_on = false,
+        // Below are optional variables for shadow casting models
+        //   depth_shader makes a position only VAO, shadow_proxy_cells
+        //   (along the longest side) also makes a merged low poly proxy
+        const Shader * depth_shader = NULL, const unsigned int shadow_proxy_cells = 0);
 
     // Accessor for current shader program.
     //   @return program_id_, the shader used by the model
     inline const Shader * shader() const;
 
-    // Accessor for each shapes VAO and it's corresponding texture
-    //   Each VAO includes indices, vertices and UV coordinates
+    // Accessor for each draw's VAO and it's corresponding texture
+    //   Every draw shares one VAO, see first_point_at for its range
     //   @return vao_texture_handle_, a container for all VAOs and their corresponding textures
     inline const std::vector<std::pair<GLuint, GLuint> > * vao_texture_handle() const;
 
@@ -62,12 +77,40 @@ class Model : public Object {
     //   @return min_$_, the minimum cartesian coordinate of given input
     inline float GetMin( int e_numb ) const;
 
-    // Accessor for the points of a given VAO shape
-    //   @param index of shape
-    //   @return unsigned int, amount of points in the VAO shape
+    // Accessor for the points of a given draw
+    //   @param index of draw
+    //   @return unsigned int, amount of points in the draw
     //   @warn throws exception on error
     inline unsigned int points_per_shape_at(unsigned int x) const;
 
+    // Accessor for the first point of a given draw
+    //   @param index of draw
+    //   @return unsigned int, the offset of the draw into the shared indices
+    //   @warn throws exception on error
+    inline unsigned int first_point_at(unsigned int x) const;
+
+    // Accessor for whether a given draw must be blended
+    //   @param index of draw
+    //   @return bool, true if it dissolves or its texture has alpha
+    //   @warn throws exception on error
+    inline bool is_transparent_at(unsigned int x) const;
+
+    // Accessor for the position only VAO of every draw
+    //   @return depth_vao_, the VAO drawn into the shadow map, 0 if it has none
+    inline GLuint depth_vao() const;
+
+    // Accessor for the uniform buffer of the Materials block
+    //   @return material_block_, a MaterialBlock per material slot
+    inline GLuint material_block() const;
+
+    // Accessor for the low poly stand in drawn into the shadow map instead of the shapes
+    //   @return shadow_proxy_vao_, 0 if it has none
+    inline GLuint shadow_proxy_vao() const;
+
+    // Accessor for the points of the shadow proxy
+    //   @return shadow_proxy_points_, the amount of indices in the proxy
+    inline unsigned int shadow_proxy_points() const;
+
     // Accessor for the Ambient Surface Colours vector
     //   @param index of colour
     //   @return ambient_surface_colours_, a vector of vec3 corresponding to the vao_texture_handle index
@@ -105,24 +148,35 @@ class Model : public Object {
   private:
     // Shader program
     const Shader &shader_;
-    // RawModelData
-    ModelData *model_data_;
-    // The file path to the mtl file (and hopefully the textures)
-    std::string subdir_;
-    // Each pair is a VAO with its texture
+    // The shader drawing into the shadow map, NULL if the model casts no shadow
+    const Shader * depth_shader_;
+    // Each pair is a draw's VAO with its texture array, one per array
     std::vector<std::pair<GLuint, GLuint> > vao_texture_handle_;
-    // Each index represents the points per shape in vao_texture_handle_
+    // Each index represents the points per draw in vao_texture_handle_
     std::vector<unsigned int> points_per_shape_;
-    // The Ambient Surface Colour per vao_texture_handle_
+    // Each index represents the first point per draw in vao_texture_handle_
+    std::vector<unsigned int> first_point_per_shape_;
+    // Whether each draw in vao_texture_handle_ must be blended, the opaque draws come first
+    std::vector<bool> is_transparent_;
+    // The position only VAO, sharing the position and index VBOs
+    GLuint depth_vao_;
+    // The uniform buffer of the Materials block
+    GLuint material_block_;
+    // The merged low poly stand in for the shadow map, 0 if none
+    GLuint shadow_proxy_vao_;
+    unsigned int shadow_proxy_points_;
+    // The Ambient Surface Colour per material slot
     std::vector<glm::vec3> ambient_surface_colours_;
-    // The Diffuse Surface Colours per vao_texture_handle_
+    // The Diffuse Surface Colours per material slot
     std::vector<glm::vec3> diffuse_surface_colours_;
-    // The Specular Surface Colours per vao_texture_handle_
+    // The Specular Surface Colours per material slot
     std::vector<glm::vec3> specular_surface_colours_;
-    // The Shininess of the normal per vao_texture_handle_
+    // The Shininess of the normal per material slot
     std::vector<float> shininess_;
-    // The Dissolve of the texture per vao_texture_handle_
+    // The Dissolve of the texture per material slot
     std::vector<float> dissolve_;
+    // The layer of the texture in its array per material slot
+    std::vector<float> texture_layers_;
     // Amount of points of shape in total
     unsigned int amount_points_;
     // Members contain min/max of the cartesian coordinates of the model
@@ -137,9 +191,14 @@ class Model : public Object {
     float max_;
 
     //Constructor Helpers
-    void ConstructShadedModel();
-    unsigned int CreateVao(const RawModelData::Shape *shape);
-    GLuint CreateTextures(const RawModelData::Material *material);
+    void ConstructShadedModel(TextureArrays * textures, const MappedMesh &mesh);
+    // Merges every shape into a low poly proxy by vertex clustering
+    //   Vertices are snapped into cubic cells, each cell becomes the average of
+    //   its vertices and triangles which collapse or repeat are dropped
+    //   @param cells, the amount of cells along the longest side of the model
+    void CreateShadowProxy(const MappedMesh &mesh, const unsigned int cells);
+    GLuint CreateVao(const MappedMesh &mesh, const std::vector<unsigned int> &shape_order);
+    GLuint CreateMaterialBlock() const;
 };
 
 // Returns the program_id_ (i.e. the shader) that the model uses
@@ -192,16 +251,60 @@ inline float Model::GetMin( int e_numb ) const {
   }
 }
 
-// Accessor for the points of a given VAO shape. Sample Usage:
+// Accessor for the points of a given draw. Sample Usage:
 //   unsigned int points_to_render = model->pointers_per_shape_at(0)
-//   @param index of shape
-//   @return unsigned int, amount of points in the VAO shape
+//   @param index of draw
+//   @return unsigned int, amount of points in the draw
 //   @warn throws exception on error
 inline unsigned int Model::points_per_shape_at(unsigned int x) const {
   assert(x < points_per_shape_.size() && "Trying to access vector out of bounds, this shape didn't push into points_per_shape");
   return points_per_shape_.at(x);
 }
 
+// Accessor for the first point of a given draw. Sample Usage:
+//   unsigned int first = model->first_point_at(0)
+//   @param index of draw
+//   @return unsigned int, the offset of the draw into the shared indices
+//   @warn throws exception on error
+inline unsigned int Model::first_point_at(unsigned int x) const {
+  assert(x < first_point_per_shape_.size() && "Trying to access vector out of bounds");
+  return first_point_per_shape_.at(x);
+}
+
+// Accessor for whether a given draw must be blended. Sample Usage:
+//   bool is_blended = model->is_transparent_at(0)
+//   @param index of draw
+//   @return bool, true if it dissolves or its texture has alpha
+//   @warn throws exception on error
+inline bool Model::is_transparent_at(unsigned int x) const {
+  assert(x < is_transparent_.size() && "Trying to access vector out of bounds");
+  return is_transparent_.at(x);
+}
+
+// Accessor for the position only VAO of every draw
+//   @return depth_vao_, the VAO drawn into the shadow map, 0 if it has none
+inline GLuint Model::depth_vao() const {
+  return depth_vao_;
+}
+
+// Accessor for the uniform buffer of the Materials block
+//   @return material_block_, a MaterialBlock per material slot
+inline GLuint Model::material_block() const {
+  return material_block_;
+}
+
+// Accessor for the low poly stand in drawn into the shadow map instead of the shapes
+//   @return shadow_proxy_vao_, 0 if it has none
+inline GLuint Model::shadow_proxy_vao() const {
+  return shadow_proxy_vao_;
+}
+
+// Accessor for the points of the shadow proxy
+//   @return shadow_proxy_points_, the amount of indices in the proxy
+inline unsigned int Model::shadow_proxy_points() const {
+  return shadow_proxy_points_;
+}
+
 // Accessor for the Ambient Surface Colours vector. Sample Usage:
 //   glm::vec3 ambient = model->ambient_surface_colours_at(3)
 //   @param index of colour
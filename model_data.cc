@@ -1,6 +1,7 @@
 #include "model_data.h"
 
-ModelData::ModelData(const std::string& inputfile) : max_x_(0), max_y_(0), max_z_(0) {
+ModelData::ModelData(const std::string& inputfile) : max_x_(0), max_y_(0), max_z_(0),
+  min_x_(0), min_y_(0), min_z_(0) {
 
   AddData(inputfile);
 
@@ -272,6 +272,8 @@ void Object::UpdateModelMatrix() {
       glm::vec3(translation_.x, translation_.y, translation_.z));
 
   model_matrix_ = translate * rotate * scale;
+  // Only changes with the model matrix, cached for every render
+  normal_matrix_ = glm::transpose(glm::inverse(glm::mat3(model_matrix_)));
 }
 
 // Accessor for the direction vector
@@ -51,6 +51,9 @@ class Object {
     // ACCESSORS:
     // Accessor for the current model matrix
     inline glm::mat4 model_matrix() const;
+    // Accessor for the normal matrix of the model matrix
+    //   Cached with the model matrix, see FrameContext::view_normal
+    inline const glm::mat3 &normal_matrix() const;
     // Accessor for the position vector
     inline glm::vec3 translation() const;
     // Accessor for the rotation vector
@@ -104,8 +107,8 @@ class Object {
     // Accessor for current shader program.
     //   @return program_id_, the shader used by the model
     virtual const Shader * shader() const = 0;
-    // Accessor for each shapes VAO and it's corresponding texture
-    //   Each VAO includes indices, vertices and UV coordinates
+    // Accessor for each draw's VAO and it's corresponding texture
+    //   Every draw shares one VAO, see first_point_at for its range
     //   @return vao_texture_handle_, a container for all VAOs and their corresponding textures
     virtual const std::vector<std::pair<unsigned int, GLuint> > * vao_texture_handle() const = 0;
     // Accessor for largest vertex
@@ -116,34 +119,55 @@ class Object {
     //   @param enum value
     //   @return min_$_, the minimum cartesian coordinate of given input
     virtual float GetMin( int e_numb ) const = 0;
-    // Accessor for the points of a given VAO shape
-    //   @param index of shape
-    //   @return unsigned int, amount of points in the VAO shape
+    // Accessor for the points of a given draw
+    //   @param index of draw
+    //   @return unsigned int, amount of points in the draw
     //   @warn throws exception on error
     virtual unsigned int points_per_shape_at(unsigned int x) const = 0;
+    // Accessor for the first point of a given draw
+    //   @param index of draw
+    //   @return unsigned int, the offset of the draw into the shared indices
+    //   @warn throws exception on error
+    virtual unsigned int first_point_at(unsigned int x) const = 0;
+    // Accessor for whether a given draw must be blended
+    //   @param index of draw
+    //   @return bool, true if it dissolves or its texture has alpha
+    //   @warn throws exception on error
+    virtual bool is_transparent_at(unsigned int x) const = 0;
+    // Accessor for the position only VAO of every draw
+    //   @return GLuint, the VAO drawn into the shadow map, 0 if it has none
+    virtual GLuint depth_vao() const = 0;
+    // Accessor for the uniform buffer of the Materials block
+    //   @return GLuint, a MaterialBlock per material slot
+    virtual GLuint material_block() const = 0;
+    // Accessor for the low poly stand in drawn into the shadow map instead of the shapes
+    //   @return GLuint, the position only VAO of every shape merged, 0 if it has none
+    virtual GLuint shadow_proxy_vao() const = 0;
+    // Accessor for the points of the shadow proxy
+    virtual unsigned int shadow_proxy_points() const = 0;
     // Accessor for the Ambient Surface Colours vector
     //   @param index of colour
-    //   @return ambient_surface_colours_, a vector of vec3 corresponding to the vao_texture_handle index
+    //   @return ambient_surface_colours_, a vector of vec3 corresponding to the material slot
     //   @warn throws exception on error
     virtual glm::vec3 ambient_surface_colours_at(unsigned int index) const = 0;
     // Accessor for the Diffuse Surface Colours vector
     //   @param index of colour
-    //   @return diffuse_surface_colours_, a vector of vec3 corresponding to the vao_texture_handle index
+    //   @return diffuse_surface_colours_, a vector of vec3 corresponding to the material slot
     //   @warn throws exception on error
     virtual glm::vec3 diffuse_surface_colours_at(unsigned int index) const = 0;
     // Accessor for the Specular Surface Colours vector
     //   @param index of colour
-    //   @return glm::vec3, a vec3 corresponding to the vao_texture_handle index
+    //   @return glm::vec3, a vec3 corresponding to the material slot
     //   @warn throws exception on error
     virtual glm::vec3 specular_surface_colours_at(unsigned int index) const = 0;
     // Accessor for the Shininess vector
     //   @param index of shininess
-    //   @return float, a float corresponding to the vao_texture_handle index
+    //   @return float, a float corresponding to the material slot
     //   @warn throws exception on error
     virtual float shininess_at(unsigned int index) const = 0;
     // Accessor for the Dissolve vector
     //   @param index of dissolve vector
-    //   @return float, a float corresponding to the vao_texture_handle index
+    //   @return float, a float corresponding to the material slot
     //   @warn throws exception on error
     virtual float dissolve_at(unsigned int index) const = 0;
     // Accessor for all of the points in the shape
@@ -155,6 +179,9 @@ class Object {
     //   Use UpdateModelMatrix() to update
     //   @warn Needs to be updated everytime glLookAt vectors (below) are changed
     glm::mat4 model_matrix_;
+    // The transpose of the inverse of the model matrix's upper 3x3
+    //   Updated with the model matrix
+    glm::mat3 normal_matrix_;
 
     // World transformations
     // The position of the object in the world
@@ -207,6 +234,10 @@ class Object {
 inline glm::mat4 Object::model_matrix() const {
   return model_matrix_;
 }
+// Accessor for the normal matrix of the model matrix
+inline const glm::mat3 &Object::normal_matrix() const {
+  return normal_matrix_;
+}
 // Accessor for the position vector
 inline glm::vec3 Object::translation() const {
   return translation_;
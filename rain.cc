@@ -171,27 +171,29 @@ void Rain::UpdatePosition()
   }
 }
 
-void Rain::Render(Camera &camera, Object * car, Skybox * skybox) const
+void Rain::Render(const FrameContext &frame, GLState * gl_state, Object * car, Skybox * skybox) const
 {
-  glUseProgram(shader_.Id);
+  RenderBackend * backend = gl_state->backend();
+  gl_state->UseProgram(shader_.Id);
 
   // Enable blending so that rain is slightly transparent, transparency is set in the frag shader
-  glEnable(GL_BLEND);
-  glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+  gl_state->Enable(GL_BLEND);
+  gl_state->BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
   // Cull Appropriately
-  glCullFace(GL_BACK);
+  gl_state->Enable(GL_CULL_FACE);
+  gl_state->CullFace(GL_BACK);
 
-  glBindVertexArray(rain_vao_);
+  gl_state->BindVertexArray(rain_vao_);
 
   // Set the Buffer subdata to be the positions array that we filled in UpdatePosition()
-  glBindBuffer(GL_ARRAY_BUFFER, particle_position_buffer_);
-  glBufferData(GL_ARRAY_BUFFER, MAX_PARTICLES_ * 3 * sizeof(GLfloat), NULL, GL_STREAM_DRAW);
-  glBufferSubData(GL_ARRAY_BUFFER, 0, MAX_PARTICLES_ * 3 * sizeof(GLfloat), particle_position_buffer_data_);
+  backend->BindBuffer(GL_ARRAY_BUFFER, particle_position_buffer_);
+  backend->BufferData(GL_ARRAY_BUFFER, MAX_PARTICLES_ * 3 * sizeof(GLfloat), NULL, GL_STREAM_DRAW);
+  backend->BufferSubData(GL_ARRAY_BUFFER, 0, MAX_PARTICLES_ * 3 * sizeof(GLfloat), particle_position_buffer_data_);
 
   // Set the colour subdata to be the positions array that we filled in UpdatePosition()
-  glBindBuffer(GL_ARRAY_BUFFER, particle_colour_buffer_);
-  glBufferData(GL_ARRAY_BUFFER, MAX_PARTICLES_ * 4 * sizeof(GLfloat), NULL, GL_STREAM_DRAW);
-  glBufferSubData(GL_ARRAY_BUFFER, 0, MAX_PARTICLES_ * 4 * sizeof(GLfloat), particle_colour_buffer_data_);
+  backend->BindBuffer(GL_ARRAY_BUFFER, particle_colour_buffer_);
+  backend->BufferData(GL_ARRAY_BUFFER, MAX_PARTICLES_ * 4 * sizeof(GLfloat), NULL, GL_STREAM_DRAW);
+  backend->BufferSubData(GL_ARRAY_BUFFER, 0, MAX_PARTICLES_ * 4 * sizeof(GLfloat), particle_colour_buffer_data_);
 
   // Translate based on the car, so the rain follows the car
   const glm::mat4 object_translate = glm::translate(glm::mat4(1.0f), 
@@ -200,44 +202,41 @@ void Rain::Render(Camera &camera, Object * car, Skybox * skybox) const
   // Translate the rain so its centre is roughly around the centre of the car
   const glm::mat4 rain_translate = glm::translate(glm::mat4(1.0f), glm::vec3(-maxx_ / 2.0f, 0.0f, -maxz_ / 2.0f));
 
-  // Get the view and projection matrices from the camera
-  const glm::mat4 &VIEW       = camera.view_matrix();
-  const glm::mat4 &PROJECTION = camera.projection_matrix();
+  // Get the view and projection matrices of the frame
+  const glm::mat4 &VIEW       = frame.view;
+  const glm::mat4 &PROJECTION = frame.projection;
   // Calculate MVP
   const glm::mat4 MODELVIEW   = VIEW * object_translate * rain_translate;
   const glm::mat4 MVP         = PROJECTION * MODELVIEW;
 
-  glUniformMatrix4fv(shader_.mvpHandle, 1, false, glm::value_ptr(MVP));
+  backend->UniformMatrix4fv(shader_.mvpHandle, 1, false, glm::value_ptr(MVP));
 
   // The cameras up vector is (0,1,0) transform it to world space by
   // by multiplying my camera->world (view) matrix inverse
-  glUniform3f(camRightHandle_, VIEW[0][0], VIEW[1][0], VIEW[2][0]);
-  glUniform3f(camUpHandle_   , VIEW[0][1], VIEW[1][1], VIEW[2][1]);
+  backend->Uniform3f(camRightHandle_, VIEW[0][0], VIEW[1][0], VIEW[2][0]);
+  backend->Uniform3f(camUpHandle_   , VIEW[0][1], VIEW[1][1], VIEW[2][1]);
 
-  glBindBuffer(GL_ARRAY_BUFFER, particle_instance_buffer_);
-  glEnableVertexAttribArray(initialVerticesLoc_);
-  glVertexAttribPointer(initialVerticesLoc_, 3, GL_FLOAT, GL_FALSE, 0, 0);
+  backend->BindBuffer(GL_ARRAY_BUFFER, particle_instance_buffer_);
+  backend->EnableVertexAttribArray(initialVerticesLoc_);
+  backend->VertexAttribPointer(initialVerticesLoc_, 3, GL_FLOAT, GL_FALSE, 0, 0);
 
-  glBindBuffer(GL_ARRAY_BUFFER, particle_position_buffer_);
-  glEnableVertexAttribArray(positionsLoc_);
-  glVertexAttribPointer(positionsLoc_, 3, GL_FLOAT, GL_FALSE, 0, 0);
+  backend->BindBuffer(GL_ARRAY_BUFFER, particle_position_buffer_);
+  backend->EnableVertexAttribArray(positionsLoc_);
+  backend->VertexAttribPointer(positionsLoc_, 3, GL_FLOAT, GL_FALSE, 0, 0);
 
-  glBindBuffer(GL_ARRAY_BUFFER, particle_colour_buffer_);
-  glEnableVertexAttribArray(colourLoc_);
-  glVertexAttribPointer(colourLoc_, 4, GL_FLOAT, GL_FALSE, 0, 0);
+  backend->BindBuffer(GL_ARRAY_BUFFER, particle_colour_buffer_);
+  backend->EnableVertexAttribArray(colourLoc_);
+  backend->VertexAttribPointer(colourLoc_, 4, GL_FLOAT, GL_FALSE, 0, 0);
 
   // Needed for instanced draws
-  glVertexAttribDivisor(initialVerticesLoc_, 0);    // Same every particle
-  glVertexAttribDivisor(positionsLoc_, 1);          // One per particle
-  glVertexAttribDivisor(colourLoc_, 1);             // One per particle
+  backend->VertexAttribDivisor(initialVerticesLoc_, 0);    // Same every particle
+  backend->VertexAttribDivisor(positionsLoc_, 1);          // One per particle
+  backend->VertexAttribDivisor(colourLoc_, 1);             // One per particle
 
   // Equivalent to looping over all particles (with 4 vertices)
-  glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, MAX_PARTICLES_);
-
-  // Unbind
-  glBindVertexArray(0);
+  backend->DrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, MAX_PARTICLES_);
 
-  glDisable(GL_BLEND);
+  gl_state->Disable(GL_BLEND);
 
 }
 
@@ -15,6 +15,8 @@
 #include <vector>
 #include "Skybox.h"
 #include "camera.h"
+#include "frame_context.h"
+#include "gl_state.h"
 #include "object.h"
 #include "shaders/shaders.h"
 #include <stdlib.h>
@@ -47,7 +49,10 @@ class Rain {
     // Destructor - Free memory allocated from constructor
     ~Rain();
 
-    void Render(Camera &camera, Object * car, Skybox * skybox) const;
+    // Renders the rain around the car
+    //   @param frame, the shared matrices of this frame
+    //   @param gl_state, the GL state cache
+    void Render(const FrameContext &frame, GLState * gl_state, Object * car, Skybox * skybox) const;
     
     // Updates the position of each particles
     void UpdatePosition();
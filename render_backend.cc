@@ -0,0 +1,543 @@
+#include "render_backend.h"
+
+// Construct with the backend to forward every command to
+//   @param next, the backend to forward to, NULL for none
+RecordingBackend::RecordingBackend(RenderBackend * next) :
+  next_(next), last_name_(0), unpack_buffer_(0) {
+    BeginFrame();
+  }
+
+// Clears the recording, commands before the first pass go to "frame"
+void RecordingBackend::BeginFrame() {
+  commands_.clear();
+  passes_.clear();
+  BeginPass("frame");
+  if (next_)
+    next_->BeginFrame();
+}
+
+// Labels the commands which follow
+//   @param name, a string literal
+void RecordingBackend::BeginPass(const char * name) {
+  passes_.push_back(EmptyRecord(name));
+  if (next_)
+    next_->BeginPass(name);
+}
+
+// Appends a command to the current pass
+void RecordingBackend::Record(const RecordedCommandType type, const GLenum mode, const GLsizei count,
+    const GLsizei instances, const GLsizeiptr bytes) {
+  RecordedCommand command;
+  command.type = type;
+  command.pass = passes_.size() - 1;
+  command.mode = mode;
+  command.count = count;
+  command.instances = instances;
+  command.bytes = bytes;
+  commands_.push_back(command);
+
+  PassRecord &pass = passes_.back();
+  ++pass.commands;
+  switch (type) {
+    case kStateCommand:
+      ++pass.state_changes;
+      break;
+    case kUniformCommand:
+      ++pass.uniforms;
+      break;
+    case kUploadCommand:
+      pass.bytes_uploaded += bytes;
+      break;
+    case kDrawCommand:
+      ++pass.draws;
+      if (mode == GL_TRIANGLES)
+        pass.triangles += (unsigned long)(count / 3) * instances;
+      else if ((mode == GL_TRIANGLE_STRIP || mode == GL_TRIANGLE_FAN) && count > 2)
+        pass.triangles += (unsigned long)(count - 2) * instances;
+      break;
+    default:
+      break;
+  }
+}
+
+// Hands out names when nothing is forwarded
+void RecordingBackend::MakeNames(GLsizei count, GLuint * names) {
+  for (GLsizei x = 0; x < count; ++x)
+    names[x] = ++last_name_;
+}
+
+// The totals of a pass
+//   Passes submitted more than once a frame are summed
+//   @return  All zero if no pass of that name was recorded
+PassRecord RecordingBackend::Pass(const std::string &name) const {
+  PassRecord sum = EmptyRecord(name);
+  for (unsigned int x = 0; x < passes_.size(); ++x) {
+    if (passes_[x].name == name)
+      Accumulate(passes_[x], &sum);
+  }
+  return sum;
+}
+
+// The totals over every pass
+PassRecord RecordingBackend::Total() const {
+  PassRecord total = EmptyRecord("total");
+  for (unsigned int x = 0; x < passes_.size(); ++x)
+    Accumulate(passes_[x], &total);
+  return total;
+}
+
+// The bytes of a pixel, rows are counted without GL_UNPACK_ALIGNMENT padding
+GLsizeiptr RecordingBackend::PixelBytes(GLenum format, GLenum type) {
+  GLsizeiptr components = 4;
+  switch (format) {
+    case GL_RED:
+    case GL_DEPTH_COMPONENT:
+      components = 1;
+      break;
+    case GL_RG:
+      components = 2;
+      break;
+    case GL_RGB:
+    case GL_BGR:
+      components = 3;
+      break;
+    default:
+      break;
+  }
+  switch (type) {
+    case GL_UNSIGNED_SHORT:
+    case GL_HALF_FLOAT:
+      return components * 2;
+    case GL_UNSIGNED_INT:
+    case GL_FLOAT:
+      return components * 4;
+    default:
+      return components;
+  }
+}
+
+// A record with every count zero
+PassRecord RecordingBackend::EmptyRecord(const std::string &name) {
+  PassRecord record;
+  record.name = name;
+  record.commands = 0;
+  record.state_changes = 0;
+  record.uniforms = 0;
+  record.draws = 0;
+  record.triangles = 0;
+  record.bytes_uploaded = 0;
+  return record;
+}
+
+// Adds the counts of a record to a sum
+void RecordingBackend::Accumulate(const PassRecord &record, PassRecord * sum) {
+  sum->commands += record.commands;
+  sum->state_changes += record.state_changes;
+  sum->uniforms += record.uniforms;
+  sum->draws += record.draws;
+  sum->triangles += record.triangles;
+  sum->bytes_uploaded += record.bytes_uploaded;
+}
+
+// Prints a line per pass
+void RecordingBackend::Print(FILE * file) const {
+  const PassRecord total = Total();
+  for (unsigned int x = 0; x <= passes_.size(); ++x) {
+    const PassRecord &pass = x < passes_.size() ? passes_[x] : total;
+    if (pass.commands == 0)
+      continue;
+    fprintf(file, "  %-12s commands: %5u, state: %4u, uniforms: %4u, draws: %3u, triangles: %7lu, uploaded: %lu bytes\n",
+        pass.name.c_str(), pass.commands, pass.state_changes, pass.uniforms,
+        pass.draws, pass.triangles, pass.bytes_uploaded);
+  }
+}
+
+void RecordingBackend::BindFramebuffer(GLenum target, GLuint framebuffer) {
+  Record(kFramebufferCommand);
+  if (next_)
+    next_->BindFramebuffer(target, framebuffer);
+}
+
+void RecordingBackend::Viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+  Record(kFramebufferCommand);
+  if (next_)
+    next_->Viewport(x, y, width, height);
+}
+
+void RecordingBackend::Clear(GLbitfield mask) {
+  Record(kFramebufferCommand);
+  if (next_)
+    next_->Clear(mask);
+}
+
+void RecordingBackend::BlitFramebuffer(GLint src_x0, GLint src_y0, GLint src_x1, GLint src_y1,
+    GLint dst_x0, GLint dst_y0, GLint dst_x1, GLint dst_y1, GLbitfield mask, GLenum filter) {
+  Record(kFramebufferCommand);
+  if (next_)
+    next_->BlitFramebuffer(src_x0, src_y0, src_x1, src_y1, dst_x0, dst_y0, dst_x1, dst_y1, mask, filter);
+}
+
+void RecordingBackend::GenFramebuffers(GLsizei count, GLuint * framebuffers) {
+  Record(kFramebufferCommand);
+  if (next_)
+    next_->GenFramebuffers(count, framebuffers);
+  else
+    MakeNames(count, framebuffers);
+}
+
+void RecordingBackend::FramebufferTextureLayer(GLenum target, GLenum attachment, GLuint texture,
+    GLint level, GLint layer) {
+  Record(kFramebufferCommand);
+  if (next_)
+    next_->FramebufferTextureLayer(target, attachment, texture, level, layer);
+}
+
+void RecordingBackend::DrawBuffer(GLenum buffer) {
+  Record(kFramebufferCommand);
+  if (next_)
+    next_->DrawBuffer(buffer);
+}
+
+void RecordingBackend::ReadBuffer(GLenum buffer) {
+  Record(kFramebufferCommand);
+  if (next_)
+    next_->ReadBuffer(buffer);
+}
+
+// Without a next backend every framebuffer is complete
+GLenum RecordingBackend::CheckFramebufferStatus(GLenum target) {
+  Record(kFramebufferCommand);
+  return next_ ? next_->CheckFramebufferStatus(target) : GL_FRAMEBUFFER_COMPLETE;
+}
+
+void RecordingBackend::UseProgram(GLuint program) {
+  Record(kStateCommand);
+  if (next_)
+    next_->UseProgram(program);
+}
+
+void RecordingBackend::ActiveTexture(GLenum unit) {
+  Record(kStateCommand);
+  if (next_)
+    next_->ActiveTexture(unit);
+}
+
+void RecordingBackend::BindTexture(GLenum target, GLuint texture) {
+  Record(kStateCommand);
+  if (next_)
+    next_->BindTexture(target, texture);
+}
+
+void RecordingBackend::BindVertexArray(GLuint vao) {
+  Record(kStateCommand);
+  if (next_)
+    next_->BindVertexArray(vao);
+}
+
+void RecordingBackend::Enable(GLenum capability) {
+  Record(kStateCommand);
+  if (next_)
+    next_->Enable(capability);
+}
+
+void RecordingBackend::Disable(GLenum capability) {
+  Record(kStateCommand);
+  if (next_)
+    next_->Disable(capability);
+}
+
+void RecordingBackend::CullFace(GLenum mode) {
+  Record(kStateCommand);
+  if (next_)
+    next_->CullFace(mode);
+}
+
+void RecordingBackend::PolygonMode(GLenum face, GLenum mode) {
+  Record(kStateCommand);
+  if (next_)
+    next_->PolygonMode(face, mode);
+}
+
+void RecordingBackend::BlendFunc(GLenum source, GLenum destination) {
+  Record(kStateCommand);
+  if (next_)
+    next_->BlendFunc(source, destination);
+}
+
+void RecordingBackend::DepthFunc(GLenum func) {
+  Record(kStateCommand);
+  if (next_)
+    next_->DepthFunc(func);
+}
+
+void RecordingBackend::DepthMask(GLboolean flag) {
+  Record(kStateCommand);
+  if (next_)
+    next_->DepthMask(flag);
+}
+
+void RecordingBackend::LineWidth(GLfloat width) {
+  Record(kStateCommand);
+  if (next_)
+    next_->LineWidth(width);
+}
+
+void RecordingBackend::PixelStorei(GLenum name, GLint value) {
+  Record(kStateCommand);
+  if (next_)
+    next_->PixelStorei(name, value);
+}
+
+void RecordingBackend::Uniform1i(GLint location, GLint value) {
+  Record(kUniformCommand);
+  if (next_)
+    next_->Uniform1i(location, value);
+}
+
+void RecordingBackend::Uniform1f(GLint location, GLfloat value) {
+  Record(kUniformCommand);
+  if (next_)
+    next_->Uniform1f(location, value);
+}
+
+void RecordingBackend::Uniform3f(GLint location, GLfloat x, GLfloat y, GLfloat z) {
+  Record(kUniformCommand);
+  if (next_)
+    next_->Uniform3f(location, x, y, z);
+}
+
+void RecordingBackend::Uniform3fv(GLint location, GLsizei count, const GLfloat * value) {
+  Record(kUniformCommand);
+  if (next_)
+    next_->Uniform3fv(location, count, value);
+}
+
+void RecordingBackend::UniformMatrix3fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat * value) {
+  Record(kUniformCommand);
+  if (next_)
+    next_->UniformMatrix3fv(location, count, transpose, value);
+}
+
+void RecordingBackend::UniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat * value) {
+  Record(kUniformCommand);
+  if (next_)
+    next_->UniformMatrix4fv(location, count, transpose, value);
+}
+
+void RecordingBackend::GenBuffers(GLsizei count, GLuint * buffers) {
+  Record(kBufferCommand);
+  if (next_)
+    next_->GenBuffers(count, buffers);
+  else
+    MakeNames(count, buffers);
+}
+
+void RecordingBackend::DeleteBuffers(GLsizei count, const GLuint * buffers) {
+  Record(kBufferCommand);
+  if (next_)
+    next_->DeleteBuffers(count, buffers);
+}
+
+void RecordingBackend::GenVertexArrays(GLsizei count, GLuint * vaos) {
+  Record(kBufferCommand);
+  if (next_)
+    next_->GenVertexArrays(count, vaos);
+  else
+    MakeNames(count, vaos);
+}
+
+void RecordingBackend::DeleteVertexArrays(GLsizei count, const GLuint * vaos) {
+  Record(kBufferCommand);
+  if (next_)
+    next_->DeleteVertexArrays(count, vaos);
+}
+
+void RecordingBackend::BindBuffer(GLenum target, GLuint buffer) {
+  Record(kBufferCommand);
+  if (target == GL_PIXEL_UNPACK_BUFFER)
+    unpack_buffer_ = buffer;
+  if (next_)
+    next_->BindBuffer(target, buffer);
+}
+
+void RecordingBackend::BindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+  Record(kBufferCommand);
+  if (next_)
+    next_->BindBufferBase(target, index, buffer);
+}
+
+// Without data the buffer is only allocated, nothing is copied
+void RecordingBackend::BufferData(GLenum target, GLsizeiptr size, const GLvoid * data, GLenum usage) {
+  Record(kUploadCommand, 0, 0, 1, data ? size : 0);
+  if (next_)
+    next_->BufferData(target, size, data, usage);
+}
+
+void RecordingBackend::BufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const GLvoid * data) {
+  Record(kUploadCommand, 0, 0, 1, size);
+  if (next_)
+    next_->BufferSubData(target, offset, size, data);
+}
+
+void RecordingBackend::EnableVertexAttribArray(GLuint index) {
+  Record(kBufferCommand);
+  if (next_)
+    next_->EnableVertexAttribArray(index);
+}
+
+void RecordingBackend::VertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized,
+    GLsizei stride, const GLvoid * pointer) {
+  Record(kBufferCommand);
+  if (next_)
+    next_->VertexAttribPointer(index, size, type, normalized, stride, pointer);
+}
+
+void RecordingBackend::VertexAttribDivisor(GLuint index, GLuint divisor) {
+  Record(kBufferCommand);
+  if (next_)
+    next_->VertexAttribDivisor(index, divisor);
+}
+
+void RecordingBackend::GenTextures(GLsizei count, GLuint * textures) {
+  Record(kResourceCommand);
+  if (next_)
+    next_->GenTextures(count, textures);
+  else
+    MakeNames(count, textures);
+}
+
+void RecordingBackend::DeleteTextures(GLsizei count, const GLuint * textures) {
+  Record(kResourceCommand);
+  if (next_)
+    next_->DeleteTextures(count, textures);
+}
+
+void RecordingBackend::TexParameteri(GLenum target, GLenum name, GLint value) {
+  Record(kResourceCommand);
+  if (next_)
+    next_->TexParameteri(target, name, value);
+}
+
+// Without pixels, or from a pixel unpack buffer, the storage is only allocated
+void RecordingBackend::TexImage3D(GLenum target, GLint level, GLint internal_format, GLsizei width,
+    GLsizei height, GLsizei depth, GLint border, GLenum format, GLenum type, const GLvoid * pixels) {
+  const GLsizeiptr bytes = !pixels || unpack_buffer_ ? 0
+    : GLsizeiptr(width) * height * depth * PixelBytes(format, type);
+  Record(kUploadCommand, 0, 0, 1, bytes);
+  if (next_)
+    next_->TexImage3D(target, level, internal_format, width, height, depth, border, format, type, pixels);
+}
+
+// From a pixel unpack buffer the pixels are an offset, nothing is copied
+void RecordingBackend::TexSubImage3D(GLenum target, GLint level, GLint x, GLint y, GLint z,
+    GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const GLvoid * pixels) {
+  const GLsizeiptr bytes = unpack_buffer_ ? 0 : GLsizeiptr(width) * height * depth * PixelBytes(format, type);
+  Record(kUploadCommand, 0, 0, 1, bytes);
+  if (next_)
+    next_->TexSubImage3D(target, level, x, y, z, width, height, depth, format, type, pixels);
+}
+
+// Without a next backend sampler objects are recorded as supported
+bool RecordingBackend::HasSamplerObjects() {
+  return next_ ? next_->HasSamplerObjects() : true;
+}
+
+void RecordingBackend::GenSamplers(GLsizei count, GLuint * samplers) {
+  Record(kResourceCommand);
+  if (next_)
+    next_->GenSamplers(count, samplers);
+  else
+    MakeNames(count, samplers);
+}
+
+void RecordingBackend::SamplerParameteri(GLuint sampler, GLenum name, GLint value) {
+  Record(kResourceCommand);
+  if (next_)
+    next_->SamplerParameteri(sampler, name, value);
+}
+
+void RecordingBackend::BindSampler(GLuint unit, GLuint sampler) {
+  Record(kStateCommand);
+  if (next_)
+    next_->BindSampler(unit, sampler);
+}
+
+// Without a next backend the program is only named, nothing is read or compiled
+GLuint RecordingBackend::LoadProgram(const char * vertex_path, const char * fragment_path,
+    const char * defines, bool is_verbose) {
+  Record(kResourceCommand);
+  if (next_)
+    return next_->LoadProgram(vertex_path, fragment_path, defines, is_verbose);
+  GLuint program;
+  MakeNames(1, &program);
+  return program;
+}
+
+GLint RecordingBackend::GetUniformLocation(GLuint program, const GLchar * name) {
+  Record(kResourceCommand);
+  return next_ ? next_->GetUniformLocation(program, name) : -1;
+}
+
+GLint RecordingBackend::GetAttribLocation(GLuint program, const GLchar * name) {
+  Record(kResourceCommand);
+  return next_ ? next_->GetAttribLocation(program, name) : -1;
+}
+
+// Without a next backend every count and length is 0
+void RecordingBackend::GetProgramiv(GLuint program, GLenum name, GLint * value) {
+  Record(kResourceCommand);
+  if (next_)
+    next_->GetProgramiv(program, name, value);
+  else
+    *value = 0;
+}
+
+void RecordingBackend::GetActiveUniform(GLuint program, GLuint index, GLsizei size, GLsizei * length,
+    GLint * uniform_size, GLenum * type, GLchar * name) {
+  Record(kResourceCommand);
+  if (next_) {
+    next_->GetActiveUniform(program, index, size, length, uniform_size, type, name);
+  } else {
+    *length = 0;
+    *uniform_size = 0;
+    *type = GL_FLOAT;
+    if (size > 0)
+      name[0] = '\0';
+  }
+}
+
+GLuint RecordingBackend::GetUniformBlockIndex(GLuint program, const GLchar * name) {
+  Record(kResourceCommand);
+  return next_ ? next_->GetUniformBlockIndex(program, name) : GL_INVALID_INDEX;
+}
+
+void RecordingBackend::UniformBlockBinding(GLuint program, GLuint index, GLuint binding) {
+  Record(kResourceCommand);
+  if (next_)
+    next_->UniformBlockBinding(program, index, binding);
+}
+
+void RecordingBackend::DrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid * indices) {
+  Record(kDrawCommand, mode, count);
+  if (next_)
+    next_->DrawElements(mode, count, type, indices);
+}
+
+void RecordingBackend::DrawArrays(GLenum mode, GLint first, GLsizei count) {
+  Record(kDrawCommand, mode, count);
+  if (next_)
+    next_->DrawArrays(mode, first, count);
+}
+
+void RecordingBackend::DrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances) {
+  Record(kDrawCommand, mode, count, instances);
+  if (next_)
+    next_->DrawArraysInstanced(mode, first, count, instances);
+}
+
+void RecordingBackend::DrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const GLvoid * indices,
+    GLsizei instances) {
+  Record(kDrawCommand, mode, count, instances);
+  if (next_)
+    next_->DrawElementsInstanced(mode, count, type, indices, instances);
+}
@@ -0,0 +1,285 @@
+#ifndef ASSIGN3_RENDER_BACKEND_H_
+#define ASSIGN3_RENDER_BACKEND_H_
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <GL/glew.h>
+
+// The commands a frame is made of
+//   Every call of the per frame render path goes through a RenderBackend,
+//   the GL backend issues them and the recording backend logs them
+//   The renderer (its shaders, shadow FBO and samplers), the terrain and the
+//   texture arrays are created through it too, so they can be recorded
+//   without a context. Models, instance rings, rain, water and the skybox
+//   are still created with GL directly, so a recording doesn't count their
+//   load time uploads
+class RenderBackend {
+  public:
+    virtual ~RenderBackend() {}
+
+    // FRAME
+    // Marks the start of a frame
+    virtual void BeginFrame() = 0;
+    // Labels the commands which follow, e.g. "shadow" or "opaque"
+    //   @param name, a string literal
+    virtual void BeginPass(const char * name) = 0;
+    virtual void BindFramebuffer(GLenum target, GLuint framebuffer) = 0;
+    virtual void Viewport(GLint x, GLint y, GLsizei width, GLsizei height) = 0;
+    virtual void Clear(GLbitfield mask) = 0;
+    virtual void BlitFramebuffer(GLint src_x0, GLint src_y0, GLint src_x1, GLint src_y1,
+        GLint dst_x0, GLint dst_y0, GLint dst_x1, GLint dst_y1, GLbitfield mask, GLenum filter) = 0;
+    virtual void GenFramebuffers(GLsizei count, GLuint * framebuffers) = 0;
+    virtual void FramebufferTextureLayer(GLenum target, GLenum attachment, GLuint texture,
+        GLint level, GLint layer) = 0;
+    virtual void DrawBuffer(GLenum buffer) = 0;
+    virtual void ReadBuffer(GLenum buffer) = 0;
+    virtual GLenum CheckFramebufferStatus(GLenum target) = 0;
+
+    // STATE
+    virtual void UseProgram(GLuint program) = 0;
+    virtual void ActiveTexture(GLenum unit) = 0;
+    virtual void BindTexture(GLenum target, GLuint texture) = 0;
+    virtual void BindVertexArray(GLuint vao) = 0;
+    virtual void Enable(GLenum capability) = 0;
+    virtual void Disable(GLenum capability) = 0;
+    virtual void CullFace(GLenum mode) = 0;
+    virtual void PolygonMode(GLenum face, GLenum mode) = 0;
+    virtual void BlendFunc(GLenum source, GLenum destination) = 0;
+    virtual void DepthFunc(GLenum func) = 0;
+    virtual void DepthMask(GLboolean flag) = 0;
+    virtual void LineWidth(GLfloat width) = 0;
+    virtual void PixelStorei(GLenum name, GLint value) = 0;
+
+    // UNIFORMS
+    virtual void Uniform1i(GLint location, GLint value) = 0;
+    virtual void Uniform1f(GLint location, GLfloat value) = 0;
+    virtual void Uniform3f(GLint location, GLfloat x, GLfloat y, GLfloat z) = 0;
+    virtual void Uniform3fv(GLint location, GLsizei count, const GLfloat * value) = 0;
+    virtual void UniformMatrix3fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat * value) = 0;
+    virtual void UniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat * value) = 0;
+
+    // BUFFERS
+    virtual void GenBuffers(GLsizei count, GLuint * buffers) = 0;
+    virtual void DeleteBuffers(GLsizei count, const GLuint * buffers) = 0;
+    virtual void GenVertexArrays(GLsizei count, GLuint * vaos) = 0;
+    virtual void DeleteVertexArrays(GLsizei count, const GLuint * vaos) = 0;
+    virtual void BindBuffer(GLenum target, GLuint buffer) = 0;
+    virtual void BindBufferBase(GLenum target, GLuint index, GLuint buffer) = 0;
+    virtual void BufferData(GLenum target, GLsizeiptr size, const GLvoid * data, GLenum usage) = 0;
+    virtual void BufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const GLvoid * data) = 0;
+    virtual void EnableVertexAttribArray(GLuint index) = 0;
+    virtual void VertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized,
+        GLsizei stride, const GLvoid * pointer) = 0;
+    virtual void VertexAttribDivisor(GLuint index, GLuint divisor) = 0;
+
+    // TEXTURES
+    virtual void GenTextures(GLsizei count, GLuint * textures) = 0;
+    virtual void DeleteTextures(GLsizei count, const GLuint * textures) = 0;
+    virtual void TexParameteri(GLenum target, GLenum name, GLint value) = 0;
+    virtual void TexImage3D(GLenum target, GLint level, GLint internal_format, GLsizei width,
+        GLsizei height, GLsizei depth, GLint border, GLenum format, GLenum type, const GLvoid * pixels) = 0;
+    virtual void TexSubImage3D(GLenum target, GLint level, GLint x, GLint y, GLint z,
+        GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const GLvoid * pixels) = 0;
+
+    // SAMPLERS
+    // Whether sampler objects are supported, i.e. ARB_sampler_objects
+    virtual bool HasSamplerObjects() = 0;
+    virtual void GenSamplers(GLsizei count, GLuint * samplers) = 0;
+    virtual void SamplerParameteri(GLuint sampler, GLenum name, GLint value) = 0;
+    virtual void BindSampler(GLuint unit, GLuint sampler) = 0;
+
+    // PROGRAMS
+    // Compiles and links a program, see LoadShaders
+    //   @return  The program, 0 if it failed to compile or link
+    virtual GLuint LoadProgram(const char * vertex_path, const char * fragment_path,
+        const char * defines, bool is_verbose) = 0;
+    virtual GLint GetUniformLocation(GLuint program, const GLchar * name) = 0;
+    virtual GLint GetAttribLocation(GLuint program, const GLchar * name) = 0;
+    virtual void GetProgramiv(GLuint program, GLenum name, GLint * value) = 0;
+    virtual void GetActiveUniform(GLuint program, GLuint index, GLsizei size, GLsizei * length,
+        GLint * uniform_size, GLenum * type, GLchar * name) = 0;
+    virtual GLuint GetUniformBlockIndex(GLuint program, const GLchar * name) = 0;
+    virtual void UniformBlockBinding(GLuint program, GLuint index, GLuint binding) = 0;
+
+    // DRAWS
+    virtual void DrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid * indices) = 0;
+    virtual void DrawArrays(GLenum mode, GLint first, GLsizei count) = 0;
+    virtual void DrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances) = 0;
+    virtual void DrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const GLvoid * indices,
+        GLsizei instances) = 0;
+};
+
+// The kinds of recorded commands
+enum RecordedCommandType {
+  kFramebufferCommand,  // creation, attachments, binding, Viewport, Clear and BlitFramebuffer
+  kStateCommand,
+  kUniformCommand,
+  kBufferCommand,       // creation, binding and attribute setup
+  kUploadCommand,       // BufferData, BufferSubData, TexImage3D and TexSubImage3D
+  kDrawCommand,
+  kResourceCommand,     // texture, sampler and program creation, parameters and queries
+};
+
+// One recorded command
+struct RecordedCommand {
+  RecordedCommandType type;
+  // The index of the pass it was recorded in
+  unsigned int pass;
+  // Draws: the primitive mode, vertex count and instances
+  GLenum mode;
+  GLsizei count;
+  GLsizei instances;
+  // Uploads: the bytes copied from client memory
+  GLsizeiptr bytes;
+};
+
+// The totals of a labelled pass
+struct PassRecord {
+  std::string name;
+  unsigned int commands;
+  unsigned int state_changes;
+  unsigned int uniforms;
+  unsigned int draws;
+  unsigned long triangles;
+  unsigned long bytes_uploaded;
+};
+
+// Records the command stream of a frame
+//   Counts commands, uploads, draws and triangles per pass so a frame can
+//   be asserted on (e.g. the opaque pass has at most N draws)
+//   With no next backend nothing reaches GL, i.e. it runs without a context
+//   and hands out its own names. Programs then have no active uniforms or
+//   attributes (every location is -1) and framebuffers are complete
+class RecordingBackend : public RenderBackend {
+  public:
+    // Construct with the backend to forward every command to
+    //   @param next, the backend to forward to, NULL for none
+    explicit RecordingBackend(RenderBackend * next = NULL);
+
+    // Clears the recording, commands before the first pass go to "frame"
+    void BeginFrame();
+    void BeginPass(const char * name);
+    void BindFramebuffer(GLenum target, GLuint framebuffer);
+    void Viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+    void Clear(GLbitfield mask);
+    void BlitFramebuffer(GLint src_x0, GLint src_y0, GLint src_x1, GLint src_y1,
+        GLint dst_x0, GLint dst_y0, GLint dst_x1, GLint dst_y1, GLbitfield mask, GLenum filter);
+    void GenFramebuffers(GLsizei count, GLuint * framebuffers);
+    void FramebufferTextureLayer(GLenum target, GLenum attachment, GLuint texture,
+        GLint level, GLint layer);
+    void DrawBuffer(GLenum buffer);
+    void ReadBuffer(GLenum buffer);
+    GLenum CheckFramebufferStatus(GLenum target);
+
+    void UseProgram(GLuint program);
+    void ActiveTexture(GLenum unit);
+    void BindTexture(GLenum target, GLuint texture);
+    void BindVertexArray(GLuint vao);
+    void Enable(GLenum capability);
+    void Disable(GLenum capability);
+    void CullFace(GLenum mode);
+    void PolygonMode(GLenum face, GLenum mode);
+    void BlendFunc(GLenum source, GLenum destination);
+    void DepthFunc(GLenum func);
+    void DepthMask(GLboolean flag);
+    void LineWidth(GLfloat width);
+    void PixelStorei(GLenum name, GLint value);
+
+    void Uniform1i(GLint location, GLint value);
+    void Uniform1f(GLint location, GLfloat value);
+    void Uniform3f(GLint location, GLfloat x, GLfloat y, GLfloat z);
+    void Uniform3fv(GLint location, GLsizei count, const GLfloat * value);
+    void UniformMatrix3fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat * value);
+    void UniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat * value);
+
+    void GenBuffers(GLsizei count, GLuint * buffers);
+    void DeleteBuffers(GLsizei count, const GLuint * buffers);
+    void GenVertexArrays(GLsizei count, GLuint * vaos);
+    void DeleteVertexArrays(GLsizei count, const GLuint * vaos);
+    void BindBuffer(GLenum target, GLuint buffer);
+    void BindBufferBase(GLenum target, GLuint index, GLuint buffer);
+    void BufferData(GLenum target, GLsizeiptr size, const GLvoid * data, GLenum usage);
+    void BufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const GLvoid * data);
+    void EnableVertexAttribArray(GLuint index);
+    void VertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized,
+        GLsizei stride, const GLvoid * pointer);
+    void VertexAttribDivisor(GLuint index, GLuint divisor);
+
+    void GenTextures(GLsizei count, GLuint * textures);
+    void DeleteTextures(GLsizei count, const GLuint * textures);
+    void TexParameteri(GLenum target, GLenum name, GLint value);
+    void TexImage3D(GLenum target, GLint level, GLint internal_format, GLsizei width,
+        GLsizei height, GLsizei depth, GLint border, GLenum format, GLenum type, const GLvoid * pixels);
+    void TexSubImage3D(GLenum target, GLint level, GLint x, GLint y, GLint z,
+        GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const GLvoid * pixels);
+
+    bool HasSamplerObjects();
+    void GenSamplers(GLsizei count, GLuint * samplers);
+    void SamplerParameteri(GLuint sampler, GLenum name, GLint value);
+    void BindSampler(GLuint unit, GLuint sampler);
+
+    GLuint LoadProgram(const char * vertex_path, const char * fragment_path,
+        const char * defines, bool is_verbose);
+    GLint GetUniformLocation(GLuint program, const GLchar * name);
+    GLint GetAttribLocation(GLuint program, const GLchar * name);
+    void GetProgramiv(GLuint program, GLenum name, GLint * value);
+    void GetActiveUniform(GLuint program, GLuint index, GLsizei size, GLsizei * length,
+        GLint * uniform_size, GLenum * type, GLchar * name);
+    GLuint GetUniformBlockIndex(GLuint program, const GLchar * name);
+    void UniformBlockBinding(GLuint program, GLuint index, GLuint binding);
+
+    void DrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid * indices);
+    void DrawArrays(GLenum mode, GLint first, GLsizei count);
+    void DrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances);
+    void DrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const GLvoid * indices,
+        GLsizei instances);
+
+    // The totals of a pass
+    //   Passes submitted more than once a frame are summed
+    //   @return  All zero if no pass of that name was recorded
+    PassRecord Pass(const std::string &name) const;
+    // The totals over every pass
+    PassRecord Total() const;
+    // Prints a line per pass
+    void Print(FILE * file) const;
+
+    // Accessor for the commands recorded this frame
+    inline const std::vector<RecordedCommand> &commands() const;
+    // Accessor for the passes recorded this frame
+    inline const std::vector<PassRecord> &passes() const;
+
+  private:
+    // The backend every command is forwarded to, NULL for none
+    RenderBackend * const next_;
+    std::vector<RecordedCommand> commands_;
+    std::vector<PassRecord> passes_;
+    // The last name handed out without a next backend
+    GLuint last_name_;
+    // The bound GL_PIXEL_UNPACK_BUFFER, texture uploads from it copy nothing
+    //   from client memory as the buffer's bytes were counted when it was filled
+    GLuint unpack_buffer_;
+
+    // Appends a command to the current pass
+    void Record(const RecordedCommandType type, const GLenum mode = 0, const GLsizei count = 0,
+        const GLsizei instances = 1, const GLsizeiptr bytes = 0);
+    // Hands out names when nothing is forwarded
+    void MakeNames(GLsizei count, GLuint * names);
+    // The bytes of a pixel, rows are counted without GL_UNPACK_ALIGNMENT padding
+    static GLsizeiptr PixelBytes(GLenum format, GLenum type);
+    // A record with every count zero
+    static PassRecord EmptyRecord(const std::string &name);
+    // Adds the counts of a record to a sum
+    static void Accumulate(const PassRecord &record, PassRecord * sum);
+};
+
+// Accessor for the commands recorded this frame
+inline const std::vector<RecordedCommand> &RecordingBackend::commands() const {
+  return commands_;
+}
+// Accessor for the passes recorded this frame
+inline const std::vector<PassRecord> &RecordingBackend::passes() const {
+  return passes_;
+}
+
+#endif
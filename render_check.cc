@@ -0,0 +1,204 @@
+/**
+ * render_check, a headless check of the terrain's command stream
+ *
+ * Runs the game's Terrain and Renderer on a RecordingBackend without a next
+ * backend, i.e. without a GPU: streams tiles through Terrain's generation
+ * ticks, queues the terrain with Renderer, sorts and submits the passes and
+ * checks the draws, state changes and uploads recorded in every pass of
+ * every frame against their budgets. Prints the worst frame of each pass as JSON
+ *
+ * Every tile is taken to be in view and in every cascade, the worst case
+ * Without a context every uniform location is -1, the uniforms are still
+ * recorded as the Renderer sends them
+ *
+ * Usage: ./render_check [tiles = 16]
+ *   Run from the game's directory, the terrain loads its textures
+ *   Exits with 1 if a pass went over its budget, the passes of the first
+ *   frame that did are printed to stderr
+ *   Exits with 2 if the argument isn't a positive whole number
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cerrno>
+#include <climits>
+#include <vector>
+#include <string>
+#include <map>
+#include <algorithm>
+
+#include "renderer.h"
+#include "terrain.h"
+#include "texture_arrays.h"
+#include "frame_context.h"
+#include "render_backend.h"
+#include "render_queue.h"
+#include "gl_state.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "lib/stb_image/stb_image.h"
+
+// The window size the camera is built with
+static const int kWindowWidth = 1280;
+static const int kWindowHeight = 720;
+// The state changes allowed for the first item of a run of items sharing a program
+//   Its program, capabilities, cull face, depth state and up to four texture units
+static const unsigned int kRunStateChanges = 16;
+// The width of a streamed cliff material, TextureStreamer's kLayerSize
+static const unsigned int kMaterialSize = 512;
+// More props than a tile places, ScatterWorker's tries and posts
+static const unsigned int kMaxTileProps = 2048;
+
+// The most a pass may record in one frame
+struct PassBudget {
+  const char * name;
+  unsigned int draws;
+  unsigned int state_changes;
+  unsigned long bytes_uploaded;
+};
+
+// Records a frame, checks its passes against the budgets and keeps the worst of each pass
+//   @return  The amount of passes over budget
+static unsigned int CheckFrame(const RecordingBackend &recorder, const std::vector<PassBudget> &budgets,
+    std::map<std::string, PassRecord> * worst) {
+  unsigned int failures = 0;
+  for (unsigned int x = 0; x < budgets.size(); ++x) {
+    const PassBudget &budget = budgets[x];
+    const PassRecord pass = recorder.Pass(budget.name);
+    PassRecord &kept = worst->insert(std::make_pair(budget.name, pass)).first->second;
+    kept.draws = std::max(kept.draws, pass.draws);
+    kept.state_changes = std::max(kept.state_changes, pass.state_changes);
+    kept.bytes_uploaded = std::max(kept.bytes_uploaded, pass.bytes_uploaded);
+    if (pass.draws > budget.draws || pass.state_changes > budget.state_changes
+        || pass.bytes_uploaded > budget.bytes_uploaded) {
+      fprintf(stderr, "render_check - %s: %u draws (at most %u), %u state changes (at most %u), "
+          "%lu bytes uploaded (at most %lu)\n", budget.name, pass.draws, budget.draws,
+          pass.state_changes, budget.state_changes, pass.bytes_uploaded, budget.bytes_uploaded);
+      ++failures;
+    }
+  }
+  return failures;
+}
+
+// Parses an argument as a count
+//   @param count, set to the count
+//   @return  false if it isn't a whole number above 0
+static bool ParseCount(const char * argument, unsigned int * count) {
+  char * end;
+  errno = 0;
+  const long value = strtol(argument, &end, 10);
+  if (end == argument || *end != '\0' || errno == ERANGE || value <= 0 || value > INT_MAX)
+    return false;
+  *count = value;
+  return true;
+}
+
+int main(int argc, char **argv) {
+  unsigned int streamed = 16;
+  if (argc > 2 || (argc == 2 && !ParseCount(argv[1], &streamed))) {
+    fprintf(stderr, "Usage: %s [tiles = 16]\n", argv[0]);
+    return 2;
+  }
+
+  // Loading, as Controller
+  RecordingBackend recorder(NULL);
+  GLState gl_state(&recorder);
+  const Renderer renderer(&gl_state);
+  const Shaders * shaders = renderer.shaders();
+  TextureArrays textures(&recorder);
+  Terrain terrain(shaders->LightMappedGeneric, shaders->DepthBuffer, &recorder, &textures);
+  textures.Allocate();
+  // The terrain's own textures are uploaded while loading, not while streaming
+  while (textures.pending_count() > 0)
+    textures.Update();
+  Camera camera(kWindowWidth, kWindowHeight);
+  Sun sun(&camera);
+  RenderQueue queue;
+  const unsigned int window = terrain.tiles()->size();
+
+  // The terrain tick uploads a tile's vertices and normals, its indices
+  // twice (adaptive and depth) and the horizon, which is smaller than a tile
+  // A finished material decode and a tile's props may land in the same frame
+  const unsigned long vertex_bytes = sizeof(glm::vec3) * terrain.width() * terrain.height();
+  unsigned long material_bytes = 0;
+  for (unsigned int size = kMaterialSize; size >= 1; size /= 2)
+    material_bytes += 3 * size * size;
+  const unsigned long stream_bytes = 4 * vertex_bytes + 2 * sizeof(int) * terrain.indice_count()
+    + material_bytes + sizeof(glm::mat4) * kMaxTileProps;
+  std::vector<PassBudget> budgets;
+  // Its state changes are the VAO setup, like a run's
+  const PassBudget stream = { "frame", 0, kRunStateChanges, stream_bytes };
+  budgets.push_back(stream);
+  for (unsigned int cascade = 0; cascade < kShadowCascades; ++cascade) {
+    const PassBudget shadow = { kRenderPassNames[StaticShadowPass(cascade)], window,
+      window + kRunStateChanges, 0 };
+    budgets.push_back(shadow);
+  }
+  // The horizon, a tile and a road per tile, in two runs (cliffs and roads)
+  const PassBudget opaque = { kRenderPassNames[kOpaquePass], 2 * window + 1,
+    2 * window + 1 + 2 * kRunStateChanges, 0 };
+  budgets.push_back(opaque);
+
+  // Every frame of each streamed tile, proceeding then ticking until its road is made
+  std::map<std::string, PassRecord> worst;
+  unsigned int frames = 0, failures = 0;
+  for (unsigned int x = 0; x < streamed; ++x) {
+    const circular_vector<Terrain::TileDescriptor> * tiles = terrain.tiles();
+    bool is_proceeding = true;
+    while (is_proceeding || tiles->size() < window || !tiles->back().road_vao) {
+      recorder.BeginFrame();
+      gl_state.ResetFrame();
+      queue.Clear();
+      if (is_proceeding)
+        terrain.ProceedTiles();
+      else
+        terrain.GenerationTick();
+      is_proceeding = false;
+
+      // Every plane passes every box
+      FrameContext frame(camera, sun, frames);
+      for (unsigned int plane = 0; plane < 6; ++plane) {
+        frame.frustum[plane] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        for (unsigned int cascade = 0; cascade < kShadowCascades; ++cascade)
+          frame.cascades[cascade].frustum[plane] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+      }
+      // The car is on the third tile
+      const Terrain::TileDescriptor &car_tile = (*tiles)[std::min<size_t>(2, tiles->size() - 1)];
+      frame.cam_pos = (car_tile.aabb_min + car_tile.aabb_max) * 0.5f;
+
+      renderer.Queue(&terrain, frame, &queue);
+      for (unsigned int cascade = 0; cascade < kShadowCascades; ++cascade)
+        renderer.QueueDepth(&terrain, frame, &queue, cascade);
+      queue.Sort();
+      for (unsigned int cascade = 0; cascade < kShadowCascades; ++cascade)
+        renderer.Submit(&queue, StaticShadowPass(cascade), frame);
+      renderer.Submit(&queue, kOpaquePass, frame);
+
+      const unsigned int frame_failures = CheckFrame(recorder, budgets, &worst);
+      if (frame_failures > 0 && failures == 0) {
+        fprintf(stderr, "render_check - frame %u:\n", frames);
+        recorder.Print(stderr);
+      }
+      failures += frame_failures;
+      ++frames;
+    }
+  }
+
+  printf("{\n");
+  printf("  \"tiles\": %u,\n", window);
+  printf("  \"streamed\": %u,\n", streamed);
+  printf("  \"frames\": %u,\n", frames);
+  printf("  \"passes\": {\n");
+  for (unsigned int x = 0; x < budgets.size(); ++x) {
+    const PassRecord &pass = worst[budgets[x].name];
+    printf("    \"%s\": { \"draws\": %u, \"max_draws\": %u, \"state_changes\": %u, \"max_state_changes\": %u, "
+        "\"bytes_uploaded\": %lu, \"max_bytes_uploaded\": %lu }%s\n",
+        budgets[x].name, pass.draws, budgets[x].draws, pass.state_changes, budgets[x].state_changes,
+        pass.bytes_uploaded, budgets[x].bytes_uploaded, x == budgets.size() - 1 ? "" : ",");
+  }
+  printf("  },\n");
+  printf("  \"failures\": %u\n", failures);
+  printf("}\n");
+
+  return failures == 0 ? 0 : 1;
+}
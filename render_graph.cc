@@ -0,0 +1,114 @@
+#include "render_graph.h"
+
+// Construct with the passes of every frame
+//   Every pass starts enabled and live
+//   @param passes, the declarations in execution order, must outlive the graph
+//   @param count, the amount of passes
+//   @param outputs, the RenderResource bits a frame must produce
+//   @warn requires a GL context
+RenderGraph::RenderGraph(const RenderGraphPass * passes, const unsigned int count, const unsigned int outputs) :
+  passes_(passes), count_(count), outputs_(outputs),
+  is_enabled_(count, true), is_live_(count, true),
+  timings_(count), frames_(0),
+  has_timer_query_(GLEW_ARB_timer_query), query_set_(0) {
+    for (unsigned int x = 0; x < 2; ++x) {
+      queries_[x].resize(count, 0);
+      is_query_pending_[x].resize(count, false);
+      if (has_timer_query_)
+        glGenQueries(count, &queries_[x][0]);
+    }
+    ResetTimings();
+  }
+
+RenderGraph::~RenderGraph() {
+  if (has_timer_query_) {
+    glDeleteQueries(count_, &queries_[0][0]);
+    glDeleteQueries(count_, &queries_[1][0]);
+  }
+}
+
+// Sets the result of a pass's enable predicate for this frame
+void RenderGraph::Enable(const unsigned int pass, const bool is_enabled) {
+  is_enabled_[pass] = is_enabled;
+}
+
+// Culls the passes of this frame
+//   Walks back from the frame's outputs, a live pass makes its inputs needed
+//   Also switches the query set and collects the results it held
+void RenderGraph::Compile() {
+  unsigned int needed = outputs_;
+  for (unsigned int x = count_; x-- > 0;) {
+    is_live_[x] = is_enabled_[x] && (passes_[x].outputs & needed) != 0;
+    if (is_live_[x])
+      needed |= passes_[x].inputs;
+  }
+
+  ++frames_;
+  query_set_ = 1 - query_set_;
+  if (has_timer_query_)
+    CollectQueries(query_set_);
+}
+
+// Starts timing a live pass
+void RenderGraph::BeginPass(const unsigned int pass) {
+  if (has_timer_query_) {
+    glBeginQuery(GL_TIME_ELAPSED, queries_[query_set_][pass]);
+    is_query_pending_[query_set_][pass] = true;
+  }
+  cpu_start_ = std::chrono::steady_clock::now();
+}
+
+// Stops timing the pass begun last
+void RenderGraph::EndPass(const unsigned int pass) {
+  RenderGraphTiming &timing = timings_[pass];
+  ++timing.frames;
+  timing.cpu_ms += std::chrono::duration<double, std::milli>(
+      std::chrono::steady_clock::now() - cpu_start_).count();
+  if (has_timer_query_)
+    glEndQuery(GL_TIME_ELAPSED);
+}
+
+// Adds the results of the query set's passes which have come back
+//   A result which isn't back after a frame is dropped rather than waited on
+void RenderGraph::CollectQueries(const unsigned int set) {
+  for (unsigned int x = 0; x < count_; ++x) {
+    if (!is_query_pending_[set][x])
+      continue;
+    is_query_pending_[set][x] = false;
+    GLint is_available = GL_FALSE;
+    glGetQueryObjectiv(queries_[set][x], GL_QUERY_RESULT_AVAILABLE, &is_available);
+    if (!is_available)
+      continue;
+    GLuint64 nanoseconds = 0;
+    glGetQueryObjectui64v(queries_[set][x], GL_QUERY_RESULT, &nanoseconds);
+    ++timings_[x].gpu_frames;
+    timings_[x].gpu_ms += nanoseconds / 1e6;
+  }
+}
+
+// Prints a line per pass, the average time of the frames it was live
+void RenderGraph::Print(FILE * file) const {
+  for (unsigned int x = 0; x < count_; ++x) {
+    const RenderGraphTiming &timing = timings_[x];
+    if (timing.frames == 0) {
+      fprintf(file, "  %-16s live: %3u/%3u\n", passes_[x].name, 0, frames_);
+      continue;
+    }
+    fprintf(file, "  %-16s live: %3u/%3u, cpu: %7.3f ms", passes_[x].name,
+        timing.frames, frames_, timing.cpu_ms / timing.frames);
+    if (timing.gpu_frames > 0)
+      fprintf(file, ", gpu: %7.3f ms", timing.gpu_ms / timing.gpu_frames);
+    fprintf(file, "\n");
+  }
+}
+
+// Clears the timings, e.g. after printing them
+void RenderGraph::ResetTimings() {
+  frames_ = 0;
+  for (unsigned int x = 0; x < count_; ++x) {
+    timings_[x].frames = 0;
+    timings_[x].cpu_ms = 0;
+    timings_[x].gpu_frames = 0;
+    timings_[x].gpu_ms = 0;
+  }
+}
@@ -0,0 +1,116 @@
+#ifndef ASSIGN3_RENDER_GRAPH_H_
+#define ASSIGN3_RENDER_GRAPH_H_
+
+#include <cstdio>
+#include <vector>
+#include <chrono>
+#include <GL/glew.h>
+
+// The resources the passes of a frame read and write, as bits
+enum RenderResource {
+  // The cached terrain depth, see ShadowCache
+  kShadowLayerResource = 1 << 0,
+  // The shadow map sampled by the scene
+  kShadowMapResource   = 1 << 1,
+  // The window's colour and depth buffers
+  kScreenResource      = 1 << 2,
+};
+
+// The declaration of a pass
+struct RenderGraphPass {
+  const char * name;
+  // The RenderResource bits the pass reads
+  unsigned int inputs;
+  // The RenderResource bits the pass writes
+  unsigned int outputs;
+};
+
+// The time spent in a pass since the last ResetTimings
+struct RenderGraphTiming {
+  // The frames the pass was live
+  unsigned int frames;
+  double cpu_ms;
+  // Only the frames whose timer query came back are counted
+  unsigned int gpu_frames;
+  double gpu_ms;
+};
+
+// The passes of a frame and what they read and write
+//   Every frame each pass is enabled or not by its owner, Compile then culls
+//   the disabled passes and those whose outputs no later pass reads, e.g. the
+//   terrain's shadow layer when the shadow map isn't drawn. The owner skips
+//   the work of every pass which isn't live, queueing and updates included
+//   Live passes are timed on the CPU, and on the GPU where timer queries exist
+//   @warn only to be used from the GL thread
+class RenderGraph {
+  public:
+    // Construct with the passes of every frame
+    //   @param passes, the declarations in execution order, must outlive the graph
+    //   @param count, the amount of passes
+    //   @param outputs, the RenderResource bits a frame must produce
+    RenderGraph(const RenderGraphPass * passes, const unsigned int count, const unsigned int outputs);
+    ~RenderGraph();
+
+    // Sets the result of a pass's enable predicate for this frame
+    void Enable(const unsigned int pass, const bool is_enabled);
+    // Culls the passes of this frame
+    //   A pass is live if it is enabled and the frame or a later live pass
+    //   reads one of its outputs
+    //   Should be called once per frame after every Enable
+    void Compile();
+
+    // Starts timing a live pass
+    void BeginPass(const unsigned int pass);
+    // Stops timing the pass begun last
+    void EndPass(const unsigned int pass);
+
+    // Prints a line per pass, the average time of the frames it was live
+    void Print(FILE * file) const;
+    // Clears the timings, e.g. after printing them
+    void ResetTimings();
+
+    // Whether a pass is drawn this frame
+    inline bool is_live(const unsigned int pass) const;
+    // Accessor for the amount of passes
+    inline unsigned int pass_count() const;
+
+  private:
+    // The declarations of the passes
+    const RenderGraphPass * const passes_;
+    const unsigned int count_;
+    // The resources a frame must produce
+    const unsigned int outputs_;
+
+    // The predicate results and culling of this frame
+    std::vector<bool> is_enabled_;
+    std::vector<bool> is_live_;
+
+    // TIMING
+    std::vector<RenderGraphTiming> timings_;
+    // The frames compiled since the timings were reset
+    unsigned int frames_;
+    // The start of the pass being timed
+    std::chrono::steady_clock::time_point cpu_start_;
+    // Whether GL_TIME_ELAPSED queries are supported
+    const bool has_timer_query_;
+    // Two sets of a query per pass, used every other frame so the results
+    // are read a frame late without stalling
+    std::vector<GLuint> queries_[2];
+    std::vector<bool> is_query_pending_[2];
+    // The set used this frame
+    unsigned int query_set_;
+
+    // Adds the results of the query set's passes which have come back
+    void CollectQueries(const unsigned int set);
+};
+
+// Whether a pass is drawn this frame
+inline bool RenderGraph::is_live(const unsigned int pass) const {
+  return is_live_[pass];
+}
+// Accessor for the amount of passes
+inline unsigned int RenderGraph::pass_count() const {
+  return count_;
+}
+
+#endif
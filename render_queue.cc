@@ -0,0 +1,71 @@
+#include "render_queue.h"
+
+// Construct with room for a frame of items
+//   About 60 tiles, roads and signs plus the car's shapes twice
+RenderQueue::RenderQueue() {
+  items_.reserve(256);
+  sorted_.reserve(256);
+  Clear();
+}
+
+// Removes every item and resets the stats
+//   Should be called at the start of every frame
+void RenderQueue::Clear() {
+  items_.clear();
+  sorted_.clear();
+  stats_.draws = 0;
+  stats_.setups = 0;
+}
+
+// Adds an item, its key is made from its state and depth
+//   @param item, the draw with every field but key set
+//   @param pass, the pass to draw it in
+//   @param depth, the distance of the item to the camera
+void RenderQueue::Push(const DrawItem &item, const RenderPass pass, const float depth) {
+  items_.push_back(item);
+  items_.back().key = MakeKey(item, pass, depth);
+  sorted_.push_back(std::make_pair(items_.back().key, items_.size() - 1));
+}
+
+// Sorts the items by key
+//   Only the keys and indices move, items with equal keys keep push order
+void RenderQueue::Sort() {
+  std::stable_sort(sorted_.begin(), sorted_.end());
+}
+
+// The sorted items of a pass
+//   The pass is the top of the key so every pass is one run
+//   @return  The [first, last) indices into items
+std::pair<unsigned int, unsigned int> RenderQueue::Range(const RenderPass pass) const {
+  const std::pair<unsigned long long, unsigned int> first(
+      static_cast<unsigned long long>(pass) << 60, 0);
+  const std::pair<unsigned long long, unsigned int> last(
+      static_cast<unsigned long long>(pass + 1) << 60, 0);
+  return std::make_pair(
+      std::lower_bound(sorted_.begin(), sorted_.end(), first) - sorted_.begin(),
+      std::lower_bound(sorted_.begin(), sorted_.end(), last) - sorted_.begin());
+}
+
+// Makes the sort key of an item
+//   bits 60-63   pass
+//   opaque:      59 blend | 58 front culled | 50-57 program | 30-49 texture | 14-29 near to far depth | 0-13 VAO
+//   transparent: 44-59 far to near depth, the rest is push order
+//   GL names are small sequential integers so the low bits are enough to group them
+//   @return  A key which sorts the item into its place
+unsigned long long RenderQueue::MakeKey(const DrawItem &item, const RenderPass pass, const float depth) const {
+  const float clamped = std::min(std::max(depth / kMaxSortDepth, 0.0f), 1.0f);
+  const unsigned long long depth_bits = static_cast<unsigned long long>(clamped * 0xffff);
+
+  unsigned long long key = static_cast<unsigned long long>(pass) << 60;
+  // Blending depends on what is behind, draw order beats state changes
+  if (pass == kTransparentPass || pass == kOverlayPass)
+    return key | (0xffff - depth_bits) << 44;
+
+  key |= static_cast<unsigned long long>(item.is_blended ? 1 : 0) << 59;
+  key |= static_cast<unsigned long long>(item.cull_face == GL_FRONT ? 1 : 0) << 58;
+  key |= static_cast<unsigned long long>(item.shader->Id & 0xff) << 50;
+  key |= static_cast<unsigned long long>(item.texture & 0xfffff) << 30;
+  key |= depth_bits << 14;
+  key |= static_cast<unsigned long long>(item.vao & 0x3fff);
+  return key;
+}
@@ -0,0 +1,168 @@
+#ifndef ASSIGN3_RENDER_QUEUE_H_
+#define ASSIGN3_RENDER_QUEUE_H_
+
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include "shaders/shaders.h"
+
+#include "glm/glm.hpp"
+#include <GL/glew.h>
+
+// The passes of a frame, submitted in this order
+//   The shadow passes draw into depth FBOs, the others to the screen
+//   The shadow passes are one per cascade, see StaticShadowPass and ShadowPass
+enum RenderPass {
+  // The terrain into a cascade of the cached shadow layer, only when it is outdated
+  kStaticShadowPass = 0,
+  // The dynamic objects on top of a copied cascade
+  kShadowPass = kStaticShadowPass + kShadowCascades,
+  kOpaquePass = kShadowPass + kShadowCascades,
+  // Drawn after the opaque pass so early-z rejects every covered pixel
+  kSkyPass,
+  kTransparentPass,
+  // Drawn after the particles, i.e. the car around the first person camera
+  kOverlayPass,
+  kPassCount,
+};
+// The names of the passes, e.g. for the recording backend
+static_assert(kShadowCascades == 3, "kRenderPassNames needs a name per cascade");
+static const char * const kRenderPassNames[kPassCount] = {
+  "static shadow 0", "static shadow 1", "static shadow 2",
+  "shadow 0", "shadow 1", "shadow 2",
+  "opaque", "sky", "transparent", "overlay",
+};
+
+// The pass drawing the terrain into a cascade of the cached shadow layer
+inline RenderPass StaticShadowPass(const unsigned int cascade) {
+  return static_cast<RenderPass>(kStaticShadowPass + cascade);
+}
+// The pass drawing the dynamic objects into a cascade of the shadow map
+inline RenderPass ShadowPass(const unsigned int cascade) {
+  return static_cast<RenderPass>(kShadowPass + cascade);
+}
+
+// What a draw item draws, picks the uniforms Renderer sets for it
+enum DrawKind {
+  kObjectShape,     // source is an Object, index its shape
+  kObjectDepth,     // as above into a cascade of the shadow map
+  kInstancedShape,  // source is an Object, index its draw, instanced from instance_buffer
+  kTerrainTile,     // source is a Terrain, index its tile
+  kHorizonStrip,    // source is a Terrain
+  kRoadTile,        // source is a Terrain, index its tile
+  kTerrainDepth,    // source is a Terrain, its depth VAOs into a cascade of the cached shadow layer
+  kSkyboxCube,      // source is a Skybox
+  kWaterPlane,      // source is a Water, model holds its placement
+};
+
+// One draw call and the GL state it needs
+//   Filled by Renderer::Queue*, the state is only changed between items
+//   which differ, see Renderer::Submit
+struct DrawItem {
+  // See RenderQueue::MakeKey
+  unsigned long long key;
+  DrawKind kind;
+  // The Object, Terrain, Skybox or Water being drawn
+  const void * source;
+  unsigned int index;
+  // The shadow cascade drawn into, depth kinds only
+  unsigned int cascade;
+  // The model matrix for kinds which don't get one from their source
+  glm::mat4 model;
+
+  // STATE
+  const Shader * shader;
+  GLuint vao;
+  // The texture the item samples most, 0 for none
+  GLenum texture_unit;
+  GLenum texture_target;
+  GLuint texture;
+  // GL_FRONT or GL_BACK, GL_NONE disables culling
+  GLenum cull_face;
+  bool is_blended;
+  // Drawn at the far plane, depth tested with GL_LEQUAL without depth writes
+  bool is_background;
+
+  // DRAW
+  GLenum mode;
+  // The first index or vertex, e.g. of a model's draw in its shared VAO
+  GLuint first;
+  GLsizei count;
+  // glDrawElements with unsigned int indices, otherwise glDrawArrays
+  bool is_indexed;
+  // The buffer of instance model matrices and the run of them drawn,
+  // kInstancedShape only
+  GLuint instance_buffer;
+  GLuint base_instance;
+  GLsizei instances;
+};
+
+// The per frame counters of a queue
+//   Filled by Renderer::Submit, reset by RenderQueue::Clear
+//   The state changes are counted by the GLState
+struct RenderStats {
+  unsigned int draws;
+  // The runs of items sharing the uniforms of a source
+  unsigned int setups;
+};
+
+// The draws of one frame
+//   Items are pushed in any order, sorted once by key and then submitted
+//   pass by pass so that the program, textures and VAOs change as rarely
+//   as possible, and opaque items go front to back for early-z
+class RenderQueue {
+  public:
+    // Construct with room for a frame of items
+    RenderQueue();
+
+    // Removes every item and resets the stats
+    //   Should be called at the start of every frame
+    void Clear();
+    // Adds an item, its key is made from its state and depth
+    //   @param item, the draw with every field but key set
+    //   @param pass, the pass to draw it in
+    //   @param depth, the distance of the item to the camera
+    void Push(const DrawItem &item, const RenderPass pass, const float depth);
+    // Sorts the items by key
+    //   Should be called once after the last Push of a frame
+    void Sort();
+
+    // The sorted items of a pass
+    //   @return  The [first, last) indices into items
+    std::pair<unsigned int, unsigned int> Range(const RenderPass pass) const;
+
+    // Accessor for an item
+    inline const DrawItem &item_at(const unsigned int index) const;
+    // Accessor for the counters of this frame
+    inline RenderStats * stats();
+
+  private:
+    // The items of this frame, in push order
+    std::vector<DrawItem> items_;
+    // The key and item index of every item, sorted by key
+    std::vector<std::pair<unsigned long long, unsigned int> > sorted_;
+    // The counters of this frame
+    RenderStats stats_;
+
+    // The depth which maps to the last sort depth bucket
+    //   The camera's far plane
+    const float kMaxSortDepth = 300.0f;
+
+    // Makes the sort key of an item
+    //   From the high bits: pass, then blend, cull, program, texture, depth
+    //   front to back and VAO. The transparent and overlay passes only sort
+    //   back to front, ties keep their push order
+    //   @return  A key which sorts the item into its place
+    unsigned long long MakeKey(const DrawItem &item, const RenderPass pass, const float depth) const;
+};
+
+// Accessor for an item
+inline const DrawItem &RenderQueue::item_at(const unsigned int index) const {
+  return items_[sorted_[index].second];
+}
+// Accessor for the counters of this frame
+inline RenderStats * RenderQueue::stats() {
+  return &stats_;
+}
+
+#endif
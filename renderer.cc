@@ -1,244 +1,98 @@
 #include "renderer.h"
 
-// Construct with a camera and verbose debugging mode
+// Construct with the GL state cache and verbose debugging mode
 //   Creates a depth buffer (used for shadows)
 //   Allows for Verbose Debugging Mode
-//   @param camera, The camera object used to get view matrix
+//   @param gl_state, the GL state cache every render call goes through
 //   @param bool debug_flag, true will enable verbose debugging
 //   @warn assert will end program prematurely with debugging enabled
-Renderer::Renderer(const bool debug_flag) :
+Renderer::Renderer(GLState * gl_state, const bool debug_flag) :
   // Rendering objects
-  fbo_(FrameBufferObject()),
-  shaders_(Shaders(debug_flag)),
+  gl_state_(gl_state),
+  fbo_(gl_state->backend()),
+  shaders_(gl_state->backend(), debug_flag),
   // Default vars
   coord_vao_handle_(debug_flag ? EnableAxis() : 0),
+  frame_block_buffer_(CreateFrameBlockBuffer(gl_state->backend())),
+  mipmap_sampler_(CreateMipmapSampler(gl_state->backend())),
   // Debugging state
   is_debugging_(debug_flag) {
 
   }
 
-//   Renders the passed in water to the scene
-//   Should be called in the controller
-//   @param Water * water, the skybox to render
-//   @warn this function is not responsible for NULL PTRs
-void Renderer::RenderWater(const Water * water, const Object* object,
-    const Skybox * Sky, const Camera &camera) const {
-  // Get and setup shader
-  const Shader &shader = water->shader();
-  glUseProgram(shader.Id);
-
-  // Setup rendering options
-  glEnable(GL_BLEND);
-  glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
-  // Cull Appropriately
-  glCullFace(GL_FRONT);
-
-  // Get only the needed components of the object's model matrix
-  // Translation to put water where car is
-  // Y component is fixed at -3.0f so that it does not follow car falling down
-  glm::mat4 object_translate = glm::translate(glm::mat4(1.0f),
-      glm::vec3(object->translation().x, -3.0f, object->translation().z));
-
-  // Translate to reposition the origin of the water
-  const float water_translate_x = water->width() / 2;
-  const float water_translate_z = water->height() / 2;
-  const glm::mat4 water_translate = glm::translate(glm::mat4(1.0f), glm::vec3(-water_translate_x, 0.0f, -water_translate_z));
-
-  const glm::mat4 &VIEW = camera.view_matrix();
-  // Make MVP
-  const glm::mat4 MODEL = object_translate * water_translate;
-  const glm::mat4 MODELVIEW = VIEW * MODEL;
-  // Make NORMAL
-  const glm::mat3 NORMAL = glm::transpose(glm::inverse(glm::mat3(MODELVIEW)));
-
-  // Send Uniforms
-  glUniformMatrix4fv(shader.mvHandle, 1, false, glm::value_ptr(MODELVIEW));
-  glUniformMatrix3fv(shader.normHandle, 1, false, glm::value_ptr(NORMAL));
-
-  // Send the cubemap (for reflections)
-  glActiveTexture(GL_TEXTURE0);
-  glBindTexture(GL_TEXTURE_CUBE_MAP, Sky->skyboxtex());
-  glUniform1i(shader.texMapHandle, 0);
-
-  // Render the Skybox
-  glBindVertexArray(water->watervao());
-
-  // MITCH - TODO COnsider changing this to triangles, whichever gives most FPS
-  glDrawElements(GL_TRIANGLE_STRIP, water->water_index_count(), GL_UNSIGNED_INT, 0 );
-  glDisable(GL_BLEND);
-
-  // Unbind
-  glBindVertexArray(0);
+// Creates the uniform buffer for the FrameConstants block
+//   @param backend, the backend it is created through
+//   @return  The buffer handle, sized for a FrameBlock
+GLuint Renderer::CreateFrameBlockBuffer(RenderBackend * backend) {
+  GLuint buffer;
+  backend->GenBuffers(1, &buffer);
+  backend->BindBuffer(GL_UNIFORM_BUFFER, buffer);
+  backend->BufferData(GL_UNIFORM_BUFFER, sizeof(FrameBlock), NULL, GL_DYNAMIC_DRAW);
+  backend->BindBuffer(GL_UNIFORM_BUFFER, 0);
+  return buffer;
 }
 
-//   Renders the passed in skybox to the scene
-//   Should be called in the controller
-//   @param Skybox * sky, the skybox to render
-//   @warn this function is not responsible for NULL PTRs
-void Renderer::RenderSkybox(const Skybox * Sky, const Camera &camera) const {
-
-  const Shader &shader = Sky->shader();
-
-  // Draw skybox with depth testing off
-  glDepthMask(GL_FALSE);
-  // Cull Appropriately
-  glCullFace(GL_BACK);
-
-  glUseProgram(shader.Id);
-  glActiveTexture(GL_TEXTURE0);
-  glBindTexture(GL_TEXTURE_CUBE_MAP, Sky->skyboxtex());
-  glUniform1i(shader.texMapHandle, 0);
-
-  // Create and send view matrix with translation stripped in order for skybox
-  // to always be in thr right location
-  const glm::mat4 &PROJECTION = camera.projection_matrix();
-  const glm::mat4 VIEW = glm::mat4(glm::mat3(camera.view_matrix()));
-  const glm::mat4 MVP = PROJECTION * VIEW;
-  // Update Handles
-  glUniformMatrix4fv(shader.mvpHandle, 1, false, glm::value_ptr(MVP) );
-
-  // Render the Skybox
-  glBindVertexArray(Sky->skyboxvao());
-  glDrawArrays(GL_TRIANGLES, 0, 36);
-
-  // Re-enable depth testing
-  glDepthMask(GL_TRUE);
-  // Unbind
-  glBindVertexArray(0);
+// Creates the sampler of the mipmapped texture units and binds it to them
+//   Units 0 to 3 hold the texture arrays, sampled trilinear and repeating
+//   The cube maps (unit 4) and the shadow map (unit 20) keep their own state
+//   @param backend, the backend it is created through
+//   @return  The sampler handle, 0 without sampler objects (the arrays'
+//            own state is the same)
+GLuint Renderer::CreateMipmapSampler(RenderBackend * backend) {
+  if (!backend->HasSamplerObjects())
+    return 0;
+  GLuint sampler;
+  backend->GenSamplers(1, &sampler);
+  backend->SamplerParameteri(sampler, GL_TEXTURE_WRAP_S, GL_REPEAT);
+  backend->SamplerParameteri(sampler, GL_TEXTURE_WRAP_T, GL_REPEAT);
+  backend->SamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+  backend->SamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  for (GLuint unit = 0; unit < 4; ++unit)
+    backend->BindSampler(unit, sampler);
+  return sampler;
 }
 
-// Draws/Renders the passed in objects (with their models) to the scene
-//   Should be called in the render loop
-//   @param Object * object, an object to render
-//   @warn this function is not responsible for NULL PTRs
-void Renderer::Render(const Object * object, const Camera &camera, const Sun &sun) const {
-  const Shader * shader = object->shader();
-  glUseProgram(shader->Id);
-
-  glDisable(GL_CULL_FACE);
-  glEnable(GL_BLEND); // For windshield
-  glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
-  // glLineWidth(1.0f);
-  glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-  // glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-
-  const glm::mat4 &PROJECTION = camera.projection_matrix();
-  const glm::mat4 VIEW = camera.view_matrix();
-  const glm::mat4 MODEL = object->model_matrix();
-  const glm::mat4 MVP = PROJECTION * VIEW * MODEL;
-  const glm::mat4 BIAS = glm::mat4(0.5f, 0.0f, 0.0f, 0.0f,
-      0.0f, 0.5f, 0.0f, 0.0f,
-      0.0f, 0.0f, 0.5f, 0.0f,
-      0.5f, 0.5f, 0.5f, 1.0f);
-
-  // Compute the MVP matrix from the light's point of view
-  const glm::mat4 D_PROJECTION = glm::ortho<float> (-100,100,-40,40,-100,100);
-  // const glm::vec2 texel_size = glm::vec2(1.0f/1024.0f, 1.0f/1024.0f);
-  // const glm::vec3 snapped_cam_pos = glm::vec3(
-  //     floor(camera.cam_pos().x / texel_size.x) * texel_size.x,
-  //     float(),
-  //     floor(camera.cam_pos().z / texel_size.y) * texel_size.y);
-  // const glm::vec3 light_start = glm::vec3(snapped_cam_pos.x+35.0f,10.0f,snapped_cam_pos.z);
-  // const glm::vec3 light_end = glm::vec3(snapped_cam_pos.x-00.0f,-10.0f,snapped_cam_pos.z);
-  const glm::vec3 light_start = glm::vec3(sun.sun_start(), sun.sun_height(), sun.sun_target_z());
-  const glm::vec3 light_end = glm::vec3(sun.sun_target_x(),-10.0f, sun.sun_target_z());
-  // const float snapped_sun_start = floor(sun.sun_start() / texel_size.x) * texel_size.x;
-  // const float snapped_sun_target_x = floor(sun.sun_target_x() / texel_size.x) * texel_size.x;
-  // const float snapped_sun_target_z = floor(sun.sun_target_z() / texel_size.y) * texel_size.y;
-  // const glm::vec3 light_start = glm::vec3(snapped_sun_start, sun.sun_height(), snapped_sun_target_z);
-  // const glm::vec3 light_end = glm::vec3(snapped_sun_target_x, -10.0f, snapped_sun_target_z);
-  const glm::mat4 D_VIEW = glm::lookAt(light_start, light_end, glm::vec3(0,1,0));
-  const glm::mat4 D_MODEL = glm::mat4(1.0);
-  const glm::mat4 DEPTH_MVP = D_PROJECTION * D_VIEW * D_MODEL;
-
-  const glm::mat4 DEPTH_BIAS_MVP = BIAS * DEPTH_MVP;
-
-  // We compute the normal matrix from the current modelview matrix
-  // and give it to our program
-  glm::mat3 NORMAL = glm::transpose(glm::inverse(glm::mat3(VIEW * MODEL)));
-  glUniformMatrix4fv(shader->mvHandle, 1, false, glm::value_ptr(VIEW * MODEL));
-  glUniformMatrix4fv(shader->mvpHandle, 1, false, glm::value_ptr(MVP));
-  glUniformMatrix4fv(shader->depthBiasMvpHandle, 1, false, glm::value_ptr(DEPTH_BIAS_MVP));
-  glUniformMatrix3fv(shader->normHandle, 1, false, glm::value_ptr(NORMAL));
-
-  int shadowIntensityHandle = glGetUniformLocation(shader->Id, "shadowIntensity");
-  if(shadowIntensityHandle == -1)
-  {
-    printf("OBJECT COULDNT FIND SHADOW INTENSITY\n");
+// Updates and binds the FrameConstants uniform block
+//   View, projection, shadow matrix, sun direction and time shared by all shaders
+//   One buffer update replaces the per shader projection and per draw
+//   shadow matrix uniforms
+//   @param frame, the shared matrices of this frame
+void Renderer::UpdateFrameConstants(const FrameContext &frame) const {
+  FrameBlock block;
+  block.view_matrix = frame.view;
+  block.projection_matrix = frame.projection;
+  for (unsigned int x = 0; x < kShadowCascades; ++x) {
+    block.shadow_matrices[x] = frame.cascades[x].bias_view_projection;
+    block.shadow_splits[x] = frame.cascades[x].split;
   }
-  // if (sun.IsDay()) {
-    glUniform1f(shadowIntensityHandle, 1.0f);
-  // } else {
-    // glUniform1f(shadowIntensityHandle, 0.7f);
-  // }
-
-  const std::vector<std::pair<unsigned int, GLuint> > * vao_texture_handle = object->vao_texture_handle();
-  for (unsigned int y = 0; y < vao_texture_handle->size(); ++y) {
-    // Pass Surface Colours to Shader
-    //   @note diffuse removed because Sun controls it
-    const glm::vec3 &vao_ambient = object->ambient_surface_colours_at(y);
-    const glm::vec3 &vao_diffuse = object->diffuse_surface_colours_at(y);
-    const glm::vec3 &vao_specular = object->specular_surface_colours_at(y);
-    const float mtlambient[3] = { vao_ambient.x, vao_ambient.y, vao_ambient.z };	// ambient material
-    const float mtldiffuse[3] = { vao_diffuse.x, vao_diffuse.y, vao_diffuse.z };	// diffuse material
-    const float mtlspecular[3] = { vao_specular.x, vao_specular.y, vao_specular.z };	// specular material
-    const float mtlshininess = object->shininess_at(y);
-    const float mtldissolve = object->dissolve_at(y);
-    glUniform3fv(shader->mtlAmbientHandle, 1, mtlambient);
-    glUniform3fv(shader->mtlDiffuseHandle, 1, mtldiffuse);
-    glUniform3fv(shader->mtlSpecularHandle, 1, mtlspecular);
-    glUniform1fv(shader->shininessHandle, 1, &mtlshininess);
-    glUniform1fv(shader->dissolveHandle, 1, &mtldissolve);
-
-    // Bind Textures
-    // Apply Shadow textures
-    // We are using texture unit 0 (the default)
-    glActiveTexture(GL_TEXTURE0);
-    glUniform1i(shader->texMapHandle, 0);
-    glBindTexture(GL_TEXTURE_2D, (*vao_texture_handle)[y].second);
-    // These shadows on car aint working FIXME
-    // glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);	
-    // glActiveTexture(GL_TEXTURE20);
-    // glUniform1i(shader->shadowMapHandle, 20);
-    // glBindTexture(GL_TEXTURE_2D, fbo_.DepthTexture);
-
-    // Populate Shader
-    glBindVertexArray((*vao_texture_handle)[y].first); 
-    // glBindAttribLocation(shader->Id, 0, "a_vertex");
-    // glBindAttribLocation(shader->Id, 1, "a_normal");
-    // glBindAttribLocation(shader->Id, 2, "a_texture");
-    glDrawElements(GL_TRIANGLES, object->points_per_shape_at(y), GL_UNSIGNED_INT, 0);	// New call
-  }
-  // Un-bind
-  glBindVertexArray(0);
-  glEnable(GL_CULL_FACE);
-  glDisable(GL_BLEND);
-
+  block.sun_direction = glm::vec4(frame.sun_direction, 0.0f);
+  block.time = frame.time;
+
+  RenderBackend * backend = gl_state_->backend();
+  backend->BindBuffer(GL_UNIFORM_BUFFER, frame_block_buffer_);
+  backend->BufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameBlock), &block);
+  backend->BindBuffer(GL_UNIFORM_BUFFER, 0);
+  backend->BindBufferBase(GL_UNIFORM_BUFFER, kFrameBlockBinding, frame_block_buffer_);
 }
 
 // Render Coordinate Axis 
 //   Only renders in debugging mode
 //   @warn requires VAO from EnableAxis
-void Renderer::RenderAxis(const Camera &camera) const {
+void Renderer::RenderAxis(const FrameContext &frame) const {
   //Render Axis if Debugging mode
   if (is_debugging_) {
     const Shader * shader = shaders_.AxisDebug;
-    glUseProgram(shader->Id);
+    gl_state_->UseProgram(shader->Id);
     // Setup rendering options
-    glDisable(GL_DEPTH_TEST);
+    gl_state_->Disable(GL_DEPTH_TEST);
     // Update Handles
-    const glm::mat4 &PROJECTION = camera.projection_matrix();
-    const glm::mat4 &VIEW = camera.view_matrix();
-    const glm::mat4 MVP = PROJECTION * VIEW;
-    glUniformMatrix4fv(shader->mvpHandle, 1, false, glm::value_ptr(MVP));
+    gl_state_->backend()->UniformMatrix4fv(shader->mvpHandle, 1, false, glm::value_ptr(frame.view_projection));
     // Bind VAOS and draw
-    glBindVertexArray(coord_vao_handle_);
-    glLineWidth(4.0f);
-    glDrawElements(GL_LINES, 2*3, GL_UNSIGNED_INT, 0);	// New call. 2 vertices * 3 lines
+    gl_state_->BindVertexArray(coord_vao_handle_);
+    gl_state_->backend()->LineWidth(4.0f);
+    gl_state_->backend()->DrawElements(GL_LINES, 2*3, GL_UNSIGNED_INT, 0);	// New call. 2 vertices * 3 lines
     // Reset Renderering options
-    glEnable(GL_DEPTH_TEST);
-    // Unbind
-    glBindVertexArray(0);
+    gl_state_->Enable(GL_DEPTH_TEST);
   }
 }
 
@@ -264,292 +118,564 @@ GLuint Renderer::EnableAxis() const {
 
   GLuint coord_vao_handle;
   const Shader * shader = shaders_.AxisDebug;
+  RenderBackend * backend = gl_state_->backend();
 
   //Create axis VAO
-  glGenVertexArrays(1, &coord_vao_handle);
-  glBindVertexArray(coord_vao_handle);
+  backend->GenVertexArrays(1, &coord_vao_handle);
+  backend->BindVertexArray(coord_vao_handle);
 
   // Buffers to store position, colour and index data
   unsigned int buffer[2];
-  glGenBuffers(2, buffer);
+  backend->GenBuffers(2, buffer);
 
   // Set vertex position
-  glBindBuffer(GL_ARRAY_BUFFER, buffer[0]);
-  glBufferData(GL_ARRAY_BUFFER, 
+  backend->BindBuffer(GL_ARRAY_BUFFER, buffer[0]);
+  backend->BufferData(GL_ARRAY_BUFFER, 
       sizeof(glm::vec3) * coord_vertices.size() , &coord_vertices[0], GL_STATIC_DRAW);
-  glEnableVertexAttribArray(shader->vertLoc);
-  glVertexAttribPointer(shader->vertLoc, 3, GL_FLOAT, GL_FALSE, 0, 0);
+  backend->EnableVertexAttribArray(shader->vertLoc);
+  backend->VertexAttribPointer(shader->vertLoc, 3, GL_FLOAT, GL_FALSE, 0, 0);
 
   // Set element attributes. Notice the change to using GL_ELEMENT_ARRAY_BUFFER
   // We don't attach this to a shader label, instead it controls how rendering is performed
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer[1]);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, 
+  backend->BindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer[1]);
+  backend->BufferData(GL_ELEMENT_ARRAY_BUFFER, 
       sizeof(unsigned int) * coord_indices.size(), &coord_indices[0], GL_STATIC_DRAW);   
   // Un-bind
-  glBindVertexArray(0);
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  backend->BindVertexArray(0);
+  backend->BindBuffer(GL_ARRAY_BUFFER, 0);
 
   return coord_vao_handle;
 }
 
-// Draws/Renders the passed in terrain to the scene
-//   @param Terrain * terrain, a terrain (cliffs/roads) to render
-//   @param vec4 light_pos, The position of the Light for lighting
-//   @warn Not responsible for NULL PTRs
-void Renderer::Render(const Terrain * terrain, const Camera &camera, const Sun &sun) const {
-  const Shader &shader = terrain->shader();
-  glUseProgram(shader.Id);
-  glCullFace(GL_BACK);
-  // glLineWidth(1.0f);
-  glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-  // glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-  glEnable(GL_LINE_SMOOTH);
-  glEnable(GL_POINT_SMOOTH);
-
-  const glm::mat4 &PROJECTION = camera.projection_matrix();
-  const glm::mat4 VIEW = camera.view_matrix();
-  const glm::mat4 MODEL = glm::mat4(1.0f);
-  const glm::mat4 MVP = PROJECTION * VIEW * MODEL;
-  const glm::mat4 BIAS = glm::mat4(0.5f, 0.0f, 0.0f, 0.0f,
-      0.0f, 0.5f, 0.0f, 0.0f,
-      0.0f, 0.0f, 0.5f, 0.0f,
-      0.5f, 0.5f, 0.5f, 1.0f);
-
-  // Compute the MVP matrix from the light's point of view
-  const glm::mat4 D_PROJECTION = glm::ortho<float> (-100,100,-40,40,-100,100);
-  // const glm::vec2 texel_size = glm::vec2(1.0f/1024.0f, 1.0f/1024.0f);
-  // const glm::vec3 snapped_cam_pos = glm::vec3(
-  //     floor(camera.cam_pos().x / texel_size.x) * texel_size.x,
-  //     float(),
-  //     floor(camera.cam_pos().z / texel_size.y) * texel_size.y);
-  // const glm::vec3 light_start = glm::vec3(snapped_cam_pos.x+35.0f,10.0f,snapped_cam_pos.z);
-  // const glm::vec3 light_end = glm::vec3(snapped_cam_pos.x-00.0f,-10.0f,snapped_cam_pos.z);
-  const glm::vec3 light_start = glm::vec3(sun.sun_start(), sun.sun_height(), sun.sun_target_z());
-  const glm::vec3 light_end = glm::vec3(sun.sun_target_x(),-10.0f, sun.sun_target_z());
-  // const float snapped_sun_start = floor(sun.sun_start() / texel_size.x) * texel_size.x;
-  // const float snapped_sun_target_x = floor(sun.sun_target_x() / texel_size.x) * texel_size.x;
-  // const float snapped_sun_target_z = floor(sun.sun_target_z() / texel_size.y) * texel_size.y;
-  // const glm::vec3 light_start = glm::vec3(snapped_sun_start, sun.sun_height(), snapped_sun_target_z);
-  // const glm::vec3 light_end = glm::vec3(snapped_sun_target_x, -10.0f, snapped_sun_target_z);
-  const glm::mat4 D_VIEW = glm::lookAt(light_start, light_end, glm::vec3(0,1,0));
-  const glm::mat4 D_MODEL = glm::mat4(1.0);
-  const glm::mat4 DEPTH_MVP = D_PROJECTION * D_VIEW * D_MODEL;
-
-  const glm::mat4 DEPTH_BIAS_MVP = BIAS * DEPTH_MVP;
-
-  // We compute the normal matrix from the current modelview matrix
-  // and give it to our program
-  glm::mat3 NORMAL = glm::transpose(glm::inverse(glm::mat3(VIEW * MODEL)));
-  glUniformMatrix4fv(shader.mvHandle, 1, false, glm::value_ptr(VIEW * MODEL));
-  glUniformMatrix4fv(shader.mvpHandle, 1, false, glm::value_ptr(MVP));
-  glUniformMatrix4fv(shader.depthBiasMvpHandle, 1, false, glm::value_ptr(DEPTH_BIAS_MVP));
-  glUniformMatrix3fv(shader.normHandle, 1, false, glm::value_ptr(NORMAL));
-
-  // Pass Surface Colours to Shader
-  const glm::vec3 &vao_ambient = glm::vec3(0.5f,0.5f,0.5f);
-  const glm::vec3 &vao_diffuse = glm::vec3(0.5f,0.5f,0.5f);
-  const glm::vec3 &vao_specular = glm::vec3(0.5f,0.5f,0.5f);
-  const float mtlambient[3] = { vao_ambient.x, vao_ambient.y, vao_ambient.z };	// ambient material
-  const float mtldiffuse[3] = { vao_diffuse.x, vao_diffuse.y, vao_diffuse.z };	// diffuse material
-  const float mtlspecular[3] = { vao_specular.x, vao_specular.y, vao_specular.z };	// specular material
-  const float mtlshininess = 0.8f; 
-  glUniform3fv(shader.mtlAmbientHandle, 1, mtlambient);
-  glUniform3fv(shader.mtlDiffuseHandle, 1, mtldiffuse);
-  glUniform3fv(shader.mtlSpecularHandle, 1, mtlspecular);
-  glUniform1fv(shader.shininessHandle, 1, &mtlshininess);
-
-  int texHandle2 = glGetUniformLocation(shader.Id, "normMap");
-  if(texHandle2 == -1)
-  {
-    printf("TERRAIN COULDNT FIND NORMAL MAPPINGS\n");
+// Queues the draws of an object to be drawn to the scene
+//   One per texture, every draw shares the object's VAO and Materials block
+//   Opaque draws are back face culled and unblended, in the opaque pass
+//   unless the object is an overlay. Transparent draws (e.g. the windshield)
+//   are blended and unculled, sorted back to front in the given pass
+//   @param Object * object, an object to render
+//   @param frame, the shared matrices of this frame
+//   @param queue, the queue of this frame
+//   @param pass, kTransparentPass or kOverlayPass to draw it after the particles
+//   @warn this function is not responsible for NULL PTRs
+void Renderer::Queue(const Object * object, const FrameContext &frame, RenderQueue * queue,
+    const RenderPass pass) const {
+  const float depth = glm::distance(frame.cam_pos, object->translation());
+
+  DrawItem item;
+  item.kind = kObjectShape;
+  item.source = object;
+  item.shader = ShadedVariant(object->shader(), 0, frame);
+  item.texture_unit = 0;
+  item.texture_target = GL_TEXTURE_2D_ARRAY;
+  item.is_background = false;
+  item.mode = GL_TRIANGLES;
+  item.is_indexed = true;
+
+  // The overlay keeps push order, so its opaque draws (pushed first) stay behind the windshield
+  const RenderPass opaque_pass = pass == kOverlayPass ? kOverlayPass : kOpaquePass;
+  const std::vector<std::pair<unsigned int, GLuint> > * vao_texture_handle = object->vao_texture_handle();
+  for (unsigned int y = 0; y < vao_texture_handle->size(); ++y) {
+    const bool is_transparent = object->is_transparent_at(y);
+    item.index = y;
+    item.vao = (*vao_texture_handle)[y].first;
+    item.texture = (*vao_texture_handle)[y].second;
+    item.cull_face = is_transparent ? GL_NONE : GL_BACK;
+    item.is_blended = is_transparent;
+    item.first = object->first_point_at(y);
+    item.count = object->points_per_shape_at(y);
+    queue->Push(item, is_transparent ? pass : opaque_pass, depth);
   }
+}
 
-  int bumpHandle = glGetUniformLocation(shader.Id, "isBumped");
-
-    glActiveTexture(GL_TEXTURE1);
-  glBindTexture(GL_TEXTURE_2D, terrain->cliff_bump());
-
-  glUniform1i(texHandle2, 1);
-  glUniform1i(bumpHandle, 1);
+// Queues every instance of a ring to be drawn to the scene
+//   Each draw of its object is one instanced draw per run of the ring, culled
+//   and blended as in Queue(const Object *)
+//   The instances are spread along the road so they all sort at depth 0
+//   @param ring, the instances to render
+//   @param frame, the shared matrices of this frame
+//   @param queue, the queue of this frame
+void Renderer::Queue(const InstanceRing * ring, const FrameContext &frame, RenderQueue * queue) const {
+  const Object * object = ring->object();
+
+  DrawItem item;
+  item.kind = kInstancedShape;
+  item.source = object;
+  item.shader = ShadedVariant(object->shader(), kShadedInstanced, frame);
+  item.instance_buffer = ring->buffer();
+  item.texture_unit = 0;
+  item.texture_target = GL_TEXTURE_2D_ARRAY;
+  item.is_background = false;
+  item.mode = GL_TRIANGLES;
+  item.is_indexed = true;
 
-  int texHandle3 = glGetUniformLocation(shader.Id, "mossMap");
-  if(texHandle3 == -1)
-  {
-    printf("TERRAIN COULDNT FIND MOSS MAPPINGS\n");
+  const std::vector<std::pair<unsigned int, GLuint> > * vao_texture_handle = object->vao_texture_handle();
+  for (unsigned int y = 0; y < vao_texture_handle->size(); ++y) {
+    const bool is_transparent = object->is_transparent_at(y);
+    item.index = y;
+    item.vao = (*vao_texture_handle)[y].first;
+    item.texture = (*vao_texture_handle)[y].second;
+    item.cull_face = is_transparent ? GL_NONE : GL_BACK;
+    item.is_blended = is_transparent;
+    item.first = object->first_point_at(y);
+    item.count = object->points_per_shape_at(y);
+    for (unsigned int x = 0; x < ring->run_count(); ++x) {
+      const std::pair<unsigned int, unsigned int> run = ring->run_at(x);
+      item.base_instance = run.first;
+      item.instances = run.second;
+      queue->Push(item, is_transparent ? kTransparentPass : kOpaquePass, 0.0f);
+    }
   }
-  glActiveTexture(GL_TEXTURE2);
-  glBindTexture(GL_TEXTURE_2D, terrain->road_bump());
-
-  glUniform1i(texHandle3, 2);
+}
 
-  int shadowIntensityHandle = glGetUniformLocation(shader.Id, "shadowIntensity");
-  if(shadowIntensityHandle == -1)
-  {
-    printf("TERRAIN COULDNT FIND SHADOW INTENSITY\n");
+// Queues the props scattered over the terrain's tiles to be drawn to the scene
+//   Each tile's props share one instance buffer, every kind is a run of it
+//   @param props, the object of each ScatterKind
+void Renderer::QueueScatter(const Terrain * terrain, const std::vector<Object*> &props,
+    const FrameContext &frame, RenderQueue * queue) const {
+  assert(props.size() == kScatterKinds && "Need an object per ScatterKind");
+  DrawItem item;
+  item.kind = kInstancedShape;
+  item.texture_unit = 0;
+  item.texture_target = GL_TEXTURE_2D_ARRAY;
+  item.is_background = false;
+  item.mode = GL_TRIANGLES;
+  item.is_indexed = true;
+
+  const circular_vector<Terrain::TileDescriptor> * tiles = terrain->tiles();
+  for (unsigned int x = 0; x < tiles->size(); ++x) {
+    const Terrain::TileDescriptor &tile = (*tiles)[x];
+    // Placed on the worker, may not be uploaded yet
+    if (!tile.scatter_buffer)
+      continue;
+    const glm::vec3 aabb_max = tile.aabb_max + glm::vec3(0.0f, kScatterHeight, 0.0f);
+    if (!frame.IsBoxVisible(tile.aabb_min, aabb_max))
+      continue;
+    const glm::vec3 nearest = glm::clamp(frame.cam_pos, tile.aabb_min, aabb_max);
+    const float distance = glm::distance(frame.cam_pos, nearest);
+    if (distance > kScatterDistance)
+      continue;
+    item.instance_buffer = tile.scatter_buffer;
+    for (unsigned int y = 0; y < kScatterKinds; ++y) {
+      if (tile.scatter_count[y] == 0)
+        continue;
+      const Object * object = props[y];
+      item.source = object;
+      item.shader = ShadedVariant(object->shader(), kShadedInstanced, frame);
+      item.base_instance = tile.scatter_first[y];
+      item.instances = tile.scatter_count[y];
+      const std::vector<std::pair<unsigned int, GLuint> > * vao_texture_handle = object->vao_texture_handle();
+      for (unsigned int z = 0; z < vao_texture_handle->size(); ++z) {
+        const bool is_transparent = object->is_transparent_at(z);
+        item.index = z;
+        item.vao = (*vao_texture_handle)[z].first;
+        item.texture = (*vao_texture_handle)[z].second;
+        item.cull_face = is_transparent ? GL_NONE : GL_BACK;
+        item.is_blended = is_transparent;
+        item.first = object->first_point_at(z);
+        item.count = object->points_per_shape_at(z);
+        queue->Push(item, is_transparent ? kTransparentPass : kOpaquePass, distance);
+      }
+    }
   }
-  // if (sun.IsDay()) {
-  //   glUniform1f(shadowIntensityHandle, 0.3f);
-  // } else {
-    glUniform1f(shadowIntensityHandle, 0.3f);
-  // }
-
-  // Bind TERRAIN Textures
-  // We are using texture unit 0 (the default)
-  glActiveTexture(GL_TEXTURE0);
-  glUniform1i(shader.texMapHandle, 0);
-  glBindTexture(GL_TEXTURE_2D, terrain->texture());
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,GL_LINEAR);	
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER,GL_LINEAR);	
-  glActiveTexture(GL_TEXTURE20);
-  glUniform1i(shader.shadowMapHandle, 20);
-  if (sun.IsDay()) {
-    glBindTexture(GL_TEXTURE_2D, fbo_.DepthTexture);
+}
+
+// Queues an object to be drawn into a cascade of the shadow map
+//   Drawn through its shadow proxy if it has one, otherwise every draw at
+//   once through its position only VAO
+//   Front faces are culled to remove shadow acne
+//   @param cascade, the index of the cascade
+void Renderer::QueueDepth(const Object * object, const FrameContext &frame, RenderQueue * queue,
+    const unsigned int cascade) const {
+  // A box around the object, larger than the car
+  const glm::vec3 extent = glm::vec3(kObjectShadowExtent);
+  const glm::vec3 min = object->translation() - extent;
+  const glm::vec3 max = object->translation() + extent;
+  if (!frame.IsBoxInCascade(cascade, min, max))
+    return;
+
+  DrawItem item;
+  item.kind = kObjectDepth;
+  item.source = object;
+  item.cascade = cascade;
+  item.shader = &shaders_.DepthBuffer;
+  item.texture_unit = 0;
+  item.texture_target = GL_TEXTURE_2D;
+  item.texture = 0;
+  item.cull_face = GL_FRONT;
+  item.is_blended = false;
+  item.is_background = false;
+  item.mode = GL_TRIANGLES;
+  item.is_indexed = true;
+  item.index = 0;
+  item.first = 0;
+
+  if (object->shadow_proxy_vao()) {
+    item.vao = object->shadow_proxy_vao();
+    item.count = object->shadow_proxy_points();
   } else {
-    glBindTexture(GL_TEXTURE_2D, 0);
+    // Models without a depth shader only have their full VAO
+    item.vao = object->depth_vao() ? object->depth_vao() : (*object->vao_texture_handle())[0].first;
+    item.count = object->amount_points();
   }
+  queue->Push(item, ShadowPass(cascade), 0.0f);
+}
 
-  // Bind VAO and texture - Terrain
-  const circular_vector<unsigned int> * terrain_vao_handle = terrain->terrain_vao_handle();
-  for (unsigned int x = 0; x < terrain_vao_handle->size(); ++x) {
-    // Populate Shader
-    glBindVertexArray((*terrain_vao_handle)[x]);
-    // glBindAttribLocation(shader->Id, shader->vertLoc, "a_vertex");
-    // glBindAttribLocation(shader->Id, shader->normLoc, "a_normal");
-    // glBindAttribLocation(shader->Id, shader->textureLoc, "a_texture");
-    int amount = terrain->indice_count();
-    glDrawElements(GL_TRIANGLES, amount, GL_UNSIGNED_INT, 0);	// New call
+// Queues the tiles, roads and horizon of the terrain to be drawn to the scene
+//   Every tile samples its own layer of the one texture array
+//   Tiles outside the view frustum are skipped
+//   @param Terrain * terrain, a terrain (cliffs/roads) to render
+//   @param frame, the shared matrices of this frame
+//   @param queue, the queue of this frame
+//   @warn Not responsible for NULL PTRs
+void Renderer::Queue(const Terrain * terrain, const FrameContext &frame, RenderQueue * queue) const {
+  DrawItem item;
+  item.source = terrain;
+  item.shader = ShadedVariant(&terrain->shader(), kShadedTerrain, frame);
+  item.texture_unit = 3;
+  item.texture_target = GL_TEXTURE_2D_ARRAY;
+  item.texture = terrain->texture_streamer()->texture();
+  item.cull_face = GL_BACK;
+  item.is_blended = false;
+  item.is_background = false;
+  item.mode = GL_TRIANGLES;
+  item.is_indexed = true;
+  item.first = 0;
+
+  // Horizon strip, it is behind every tile
+  const circular_vector<Terrain::TileDescriptor> * tiles = terrain->tiles();
+  const Horizon * horizon = terrain->horizon();
+  item.kind = kHorizonStrip;
+  item.index = tiles->size() - 1;
+  item.vao = horizon->vao_handle();
+  item.count = horizon->indice_count();
+  queue->Push(item, kOpaquePass, 1e6f);
+
+  // Terrain
+  item.kind = kTerrainTile;
+  for (unsigned int x = 0; x < tiles->size(); ++x) {
+    const Terrain::TileDescriptor &tile = (*tiles)[x];
+    if (!frame.IsBoxVisible(tile.aabb_min, tile.aabb_max))
+      continue;
+    item.index = x;
+    item.vao = tile.terrain_vao;
+    item.count = tile.terrain_indice_count;
+    queue->Push(item, kOpaquePass,
+        glm::distance(frame.cam_pos, (tile.aabb_min + tile.aabb_max) * 0.5f));
   }
-  // Unbind
-  glBindVertexArray(0);
-
-  glUniform1i(bumpHandle, 0);
-
-  // Bind ROAD Textures
-  // We are using texture unit 0 (the default)
-  glActiveTexture(GL_TEXTURE0);
-  glUniform1i(shader.texMapHandle, 0);
-  glBindTexture(GL_TEXTURE_2D, terrain->road_texture());
-  // glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,GL_LINEAR);	
-  // glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER,GL_LINEAR);	
-  glActiveTexture(GL_TEXTURE20);
-  glBindTexture(GL_TEXTURE_2D, fbo_.DepthTexture);
-  glUniform1i(shader.shadowMapHandle, 20);
-
-  glCullFace(GL_FRONT); //Road is rendered with reverse facing
-  int amount = terrain->road_indice_count();
-  const circular_vector<unsigned int> * road_vao_handle = terrain->road_vao_handle();
-  for (unsigned int x = 0; x < road_vao_handle->size(); ++x) {
-    // Bind VAO Road
-    glBindVertexArray((*road_vao_handle)[x]);
-    glDrawElements(GL_TRIANGLES, amount, GL_UNSIGNED_INT, 0);	// New call
+
+  // Roads, rendered with reverse facing and without the cliffs' bump maps
+  item.kind = kRoadTile;
+  item.shader = ShadedVariant(&terrain->shader(), 0, frame);
+  item.texture_unit = 0;
+  item.texture_target = GL_TEXTURE_2D_ARRAY;
+  item.texture = terrain->road_texture().texture;
+  item.cull_face = GL_FRONT;
+  item.count = terrain->road_indice_count();
+  for (unsigned int x = 0; x < tiles->size(); ++x) {
+    const Terrain::TileDescriptor &tile = (*tiles)[x];
+    // The road VAO is made the tick after the terrain VAO
+    if (!tile.road_vao)
+      continue;
+    if (!frame.IsBoxVisible(tile.aabb_min, tile.aabb_max))
+      continue;
+    item.index = x;
+    item.vao = tile.road_vao;
+    queue->Push(item, kOpaquePass,
+        glm::distance(frame.cam_pos, (tile.aabb_min + tile.aabb_max) * 0.5f));
   }
+}
 
-  glUniform1i(bumpHandle, 0);
+// Queues the tiles of the terrain to be drawn into a cascade of the cached shadow layer
+//   Every tile overlapping the cascade is queued, shadows can be cast from outside the view
+//   Drawn through the position only depth VAOs, which also cover the road
+//   Front faces are culled to remove shadow acne
+//   @param cascade, the index of the cascade
+void Renderer::QueueDepth(const Terrain * terrain, const FrameContext &frame, RenderQueue * queue,
+    const unsigned int cascade) const {
+  DrawItem item;
+  item.kind = kTerrainDepth;
+  item.source = terrain;
+  item.cascade = cascade;
+  item.shader = &shaders_.DepthBuffer;
+  item.texture_unit = 0;
+  item.texture_target = GL_TEXTURE_2D;
+  item.texture = 0;
+  item.is_blended = false;
+  item.is_background = false;
+  item.mode = GL_TRIANGLES;
+  item.is_indexed = true;
+  item.first = 0;
+  item.cull_face = GL_FRONT;
+
+  const circular_vector<Terrain::TileDescriptor> * tiles = terrain->tiles();
+  for (unsigned int x = 0; x < tiles->size(); ++x) {
+    const Terrain::TileDescriptor &tile = (*tiles)[x];
+    if (!frame.IsBoxInCascade(cascade, tile.aabb_min, tile.aabb_max))
+      continue;
+    item.index = x;
+    item.vao = tile.depth_vao;
+    item.count = tile.depth_indice_count;
+    queue->Push(item, StaticShadowPass(cascade), 0.0f);
+  }
+}
 
-  // Un-bind
-  glBindVertexArray(0);
-  glDisable(GL_LINE_SMOOTH);
-  glDisable(GL_POINT_SMOOTH);
+// Queues the water, centered under the object and reflecting the sky
+//   Blended over everything behind it, it is the farthest transparent item
+//   @warn this function is not responsible for NULL PTRs
+void Renderer::Queue(const Water * water, const Object * object, const Skybox * sky,
+    const FrameContext &frame, RenderQueue * queue) const {
+  // Get only the needed components of the object's model matrix
+  // Translation to put water where car is
+  // Y component is fixed at -3.0f so that it does not follow car falling down
+  const glm::mat4 object_translate = glm::translate(glm::mat4(1.0f),
+      glm::vec3(object->translation().x, -3.0f, object->translation().z));
+  // Translate to reposition the origin of the water
+  const float water_translate_x = water->width() / 2;
+  const float water_translate_z = water->height() / 2;
+  const glm::mat4 water_translate = glm::translate(glm::mat4(1.0f), glm::vec3(-water_translate_x, 0.0f, -water_translate_z));
+
+  DrawItem item;
+  item.kind = kWaterPlane;
+  item.source = water;
+  item.index = 0;
+  item.model = object_translate * water_translate;
+  item.shader = &water->shader();
+  item.vao = water->watervao();
+  // The cubemap (for reflections), on a unit without the mipmap sampler
+  item.texture_unit = 4;
+  item.texture_target = GL_TEXTURE_CUBE_MAP;
+  item.texture = sky->skyboxtex();
+  item.cull_face = GL_FRONT;
+  item.is_blended = true;
+  item.is_background = false;
+  // MITCH - TODO COnsider changing this to triangles, whichever gives most FPS
+  item.mode = GL_TRIANGLE_STRIP;
+  item.count = water->water_index_count();
+  item.is_indexed = true;
+  item.first = 0;
+  queue->Push(item, kTransparentPass, 1e6f);
 }
 
-// Draws/Renders the passed in terrain to the scene
-//   @param Terrain * terrain, a terrain (cliffs/roads) to render
-//   @param vec4 light_pos, The position of the Light for lighting
-//   TODO this is depth buffer
-//   @warn Not responsible for NULL PTRs
-void Renderer::RenderDepthBuffer(const Object * object, const Sun &sun) const {
-  const Shader &shader = shaders_.DepthBuffer;
-  glUseProgram(shader.Id);
-  glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-  // Remove shadow acne
-  glCullFace(GL_FRONT);
-
-  // Compute the MVP matrix from the light's point of view
-  const glm::mat4 PROJECTION = glm::ortho<float> (-100,100,-40,40,-100,100);
-  // const glm::vec2 texel_size = glm::vec2(1.0f/fbo_.textureX, 1.0f/fbo_.textureY);
-  // const glm::vec3 snapped_cam_pos = glm::vec3(
-  //     floor(camera.cam_pos().x / texel_size.x) * texel_size.x,
-  //     float(),
-  //     floor(camera.cam_pos().z / texel_size.y) * texel_size.y);
-  // const glm::vec3 light_start = glm::vec3(snapped_cam_pos.x+35.0f,10.0f,snapped_cam_pos.z);
-  // const glm::vec3 light_end = glm::vec3(snapped_cam_pos.x-00.0f,-10.0f,snapped_cam_pos.z);
-  const glm::vec3 light_start = glm::vec3(sun.sun_start(), sun.sun_height(), sun.sun_target_z());
-  const glm::vec3 light_end = glm::vec3(sun.sun_target_x(),-10.0f, sun.sun_target_z());
-  // const float snapped_sun_start = floor(sun.sun_start() / texel_size.x) * texel_size.x;
-  // const float snapped_sun_target_x = floor(sun.sun_target_x() / texel_size.x) * texel_size.x;
-  // const float snapped_sun_target_z = floor(sun.sun_target_z() / texel_size.y) * texel_size.y;
-  // const glm::vec3 light_start = glm::vec3(snapped_sun_start, sun.sun_height(), snapped_sun_target_z);
-  // const glm::vec3 light_end = glm::vec3(snapped_sun_target_x, -10.0f, snapped_sun_target_z);
-  const glm::mat4 VIEW = glm::lookAt(light_start, light_end, glm::vec3(0,1,0));
-  const glm::mat4 MODEL = object->model_matrix();
-  const glm::mat4 DEPTH_MVP = PROJECTION * VIEW * MODEL;
-
-  // Send our transformation to the currently bound shader,
-  // in the "MVP" uniform
-  glUniformMatrix4fv(shader.depthMvpHandle, 1, GL_FALSE, glm::value_ptr(DEPTH_MVP));
+// Queues the skybox, drawn after every opaque item
+//   sky.vert puts it on the far plane so only the uncovered pixels are shaded
+//   @warn this function is not responsible for NULL PTRs
+void Renderer::Queue(const Skybox * sky, const FrameContext &frame, RenderQueue * queue) const {
+  DrawItem item;
+  item.kind = kSkyboxCube;
+  item.source = sky;
+  item.index = 0;
+  item.shader = &sky->shader();
+  item.vao = sky->skyboxvao();
+  // The cubemap has no mipmaps, so not on a unit with the mipmap sampler
+  item.texture_unit = 4;
+  item.texture_target = GL_TEXTURE_CUBE_MAP;
+  item.texture = sky->skyboxtex();
+  item.cull_face = GL_BACK;
+  item.is_blended = false;
+  item.is_background = true;
+  item.mode = GL_TRIANGLES;
+  item.count = 36;
+  item.is_indexed = false;
+  item.first = 0;
+  queue->Push(item, kSkyPass, 0.0f);
+}
 
-  const std::vector<std::pair<unsigned int, GLuint> > * vao_texture_handle = object->vao_texture_handle();
-  for (unsigned int y = 0; y < vao_texture_handle->size(); ++y) {
-    // Pass Surface Colours to Shader
-    glBindVertexArray((*vao_texture_handle)[y].first); 
-    glDrawElements(GL_TRIANGLES, object->points_per_shape_at(y), GL_UNSIGNED_INT, 0);	// New call
+// Draws the sorted items of a pass
+//   The program, textures, VAO, cull, blend and depth state go through
+//   the GL state cache so only changes between items reach GL
+//   Leaves depth writes on
+//   @param queue, the sorted queue of this frame
+//   @param pass, the pass to draw
+//   @param frame, the shared matrices of this frame
+void Renderer::Submit(RenderQueue * queue, const RenderPass pass, const FrameContext &frame) const {
+  const std::pair<unsigned int, unsigned int> range = queue->Range(pass);
+  RenderStats * stats = queue->stats();
+  gl_state_->backend()->BeginPass(kRenderPassNames[pass]);
+
+  gl_state_->PolygonMode(GL_FILL);
+  gl_state_->BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  // The kind, source and program whose shared uniforms are set
+  DrawKind setup_kind = kObjectShape;
+  const void * setup_source = NULL;
+  const Shader * setup_shader = NULL;
+  for (unsigned int x = range.first; x < range.second; ++x) {
+    const DrawItem &item = queue->item_at(x);
+
+    gl_state_->UseProgram(item.shader->Id);
+    if (item.cull_face == GL_NONE) {
+      gl_state_->Disable(GL_CULL_FACE);
+    } else {
+      gl_state_->Enable(GL_CULL_FACE);
+      gl_state_->CullFace(item.cull_face);
+    }
+    if (item.is_blended)
+      gl_state_->Enable(GL_BLEND);
+    else
+      gl_state_->Disable(GL_BLEND);
+    gl_state_->DepthFunc(item.is_background ? GL_LEQUAL : GL_LESS);
+    gl_state_->DepthMask(item.is_background ? GL_FALSE : GL_TRUE);
+
+    // Uniforms shared by the items of a source are only sent once per run
+    if (item.source != setup_source || item.kind != setup_kind || item.shader != setup_shader) {
+      Setup(item, frame);
+      setup_source = item.source;
+      setup_kind = item.kind;
+      setup_shader = item.shader;
+      ++stats->setups;
+    }
+    if (item.texture)
+      gl_state_->BindTexture(item.texture_unit, item.texture_target, item.texture);
+    gl_state_->BindVertexArray(item.vao);
+
+    Draw(item);
+    ++stats->draws;
   }
-  // Unbind
-  glBindVertexArray(0);
+
+  // Depth writes are needed by the next glClear
+  gl_state_->DepthMask(GL_TRUE);
 }
 
-// Draws/Renders the passed in terrain to the scene
-//   @param Terrain * terrain, a terrain (cliffs/roads) to render
-//   @param vec4 light_pos, The position of the Light for lighting
-//   TODO this is depth buffer
-//   @warn Not responsible for NULL PTRs
-void Renderer::RenderDepthBuffer(const Terrain * terrain, const Sun &sun) const {
-  const Shader &shader = shaders_.DepthBuffer;
-  glUseProgram(shader.Id);
-  glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-  // Remove shadow acne
-  glCullFace(GL_FRONT);
-
-  // Compute the MVP matrix from the light's point of view
-  const glm::mat4 PROJECTION = glm::ortho<float> (-100,100,-40,40,-100,100);
-  // const glm::vec2 texel_size = glm::vec2(1.0f/fbo_.textureX, 1.0f/fbo_.textureY);
-  // const glm::vec3 snapped_cam_pos = glm::vec3(
-  //     floor(camera.cam_pos().x / texel_size.x) * texel_size.x,
-  //     float(),
-  //     floor(camera.cam_pos().z / texel_size.y) * texel_size.y);
-  // const glm::vec3 light_start = glm::vec3(snapped_cam_pos.x+35.0f,10.0f,snapped_cam_pos.z);
-  // const glm::vec3 light_end = glm::vec3(snapped_cam_pos.x-00.0f,-10.0f,snapped_cam_pos.z);
-  const glm::vec3 light_start = glm::vec3(sun.sun_start(), sun.sun_height(), sun.sun_target_z());
-  const glm::vec3 light_end = glm::vec3(sun.sun_target_x(),-10.0f, sun.sun_target_z());
-  // const float snapped_sun_start = floor(sun.sun_start() / texel_size.x) * texel_size.x;
-  // const float snapped_sun_target_x = floor(sun.sun_target_x() / texel_size.x) * texel_size.x;
-  // const float snapped_sun_target_z = floor(sun.sun_target_z() / texel_size.y) * texel_size.y;
-  // const glm::vec3 light_start = glm::vec3(snapped_sun_start, sun.sun_height(), snapped_sun_target_z);
-  // const glm::vec3 light_end = glm::vec3(snapped_sun_target_x, -10.0f, snapped_sun_target_z);
-  const glm::mat4 VIEW = glm::lookAt(light_start, light_end, glm::vec3(0,1,0));
-  const glm::mat4 MODEL = glm::mat4(1.0);
-  const glm::mat4 DEPTH_MVP = PROJECTION * VIEW * MODEL;
-
-  // Send our transformation to the currently bound shader,
-  // in the "MVP" uniform
-  glUniformMatrix4fv(shader.depthMvpHandle, 1, GL_FALSE, glm::value_ptr(DEPTH_MVP));
-
-  // Bind VAO and texture - Terrain
-  const int amount_terrain = terrain->indice_count();
-  const circular_vector<unsigned int> * terrain_vao_handle = terrain->terrain_vao_handle();
-  for (unsigned int x = 0; x < terrain_vao_handle->size(); ++x) {
-    glBindVertexArray((*terrain_vao_handle)[x]);
-    glDrawElements(GL_TRIANGLES, amount_terrain, GL_UNSIGNED_INT, 0);
+// Sends the uniforms shared by the items of a source
+//   e.g. an object's matrices or the terrain's material and textures
+void Renderer::Setup(const DrawItem &item, const FrameContext &frame) const {
+  RenderBackend * backend = gl_state_->backend();
+  const Shader &shader = *item.shader;
+  switch (item.kind) {
+    case kObjectShape:
+    case kInstancedShape: {
+      // Instances carry their own model matrix, see shaded.vert
+      const bool is_instanced = item.kind == kInstancedShape;
+      const Object * object = static_cast<const Object *>(item.source);
+      const glm::mat4 MODELVIEW = is_instanced ? frame.view : frame.view * object->model_matrix();
+      const glm::mat4 MVP = frame.projection * MODELVIEW;
+      // The normal matrix of the modelview matrix, the model's part is cached
+      // with its model matrix
+      const glm::mat3 NORMAL = is_instanced ? frame.view_normal : frame.view_normal * object->normal_matrix();
+      backend->UniformMatrix4fv(shader.mvHandle, 1, false, glm::value_ptr(MODELVIEW));
+      backend->UniformMatrix4fv(shader.mvpHandle, 1, false, glm::value_ptr(MVP));
+      backend->UniformMatrix3fv(shader.normHandle, 1, false, glm::value_ptr(NORMAL));
+      backend->Uniform1f(UNIFORM(shader, "shadowIntensity"), 1.0f);
+      backend->BindBufferBase(GL_UNIFORM_BUFFER, kMaterialsBlockBinding, object->material_block());
+      // Only the SHADOWS variants sample the shadow map
+      if (shader.shadowMapHandle != -1)
+        gl_state_->BindTexture(20, GL_TEXTURE_2D_ARRAY, fbo_.DepthTexture);
+      break;
+    }
+    case kTerrainTile:
+    case kHorizonStrip:
+    case kRoadTile: {
+      const Terrain * terrain = static_cast<const Terrain *>(item.source);
+      const bool is_road = item.kind == kRoadTile;
+      // The terrain is in world space, i.e. an identity model matrix
+      backend->UniformMatrix4fv(shader.mvHandle, 1, false, glm::value_ptr(frame.view));
+      backend->UniformMatrix4fv(shader.mvpHandle, 1, false, glm::value_ptr(frame.view_projection));
+      backend->UniformMatrix3fv(shader.normHandle, 1, false, glm::value_ptr(frame.view_normal));
+
+      // Surface Colours of the terrain
+      backend->BindBufferBase(GL_UNIFORM_BUFFER, kMaterialsBlockBinding, terrain->material_block());
+      backend->Uniform1f(UNIFORM(shader, "shadowIntensity"), 0.3f);
+
+      // Cliffs are bump mapped and sample the texture array (the terrain
+      // variants), the road samples its own texture
+      //   The sampler units are set once, see Shaders
+      if (!is_road) {
+        backend->Uniform1f(UNIFORM(shader, "normLayer"), terrain->cliff_bump().layer);
+        backend->Uniform1f(UNIFORM(shader, "mossLayer"), terrain->road_bump().layer);
+        gl_state_->BindTexture(1, GL_TEXTURE_2D_ARRAY, terrain->cliff_bump().texture);
+        gl_state_->BindTexture(2, GL_TEXTURE_2D_ARRAY, terrain->road_bump().texture);
+      }
+      // The shadow map is only drawn by day, for the SHADOWS variants
+      if (shader.shadowMapHandle != -1)
+        gl_state_->BindTexture(20, GL_TEXTURE_2D_ARRAY, fbo_.DepthTexture);
+      break;
+    }
+    case kObjectDepth: {
+      // The MVP matrix from the light's point of view
+      const Object * object = static_cast<const Object *>(item.source);
+      const glm::mat4 DEPTH_MVP = frame.cascades[item.cascade].view_projection * object->model_matrix();
+      backend->UniformMatrix4fv(shader.depthMvpHandle, 1, GL_FALSE, glm::value_ptr(DEPTH_MVP));
+      break;
+    }
+    case kTerrainDepth:
+      // The terrain is in world space
+      backend->UniformMatrix4fv(shader.depthMvpHandle, 1, GL_FALSE,
+          glm::value_ptr(frame.cascades[item.cascade].view_projection));
+      break;
+    case kSkyboxCube: {
+      // The view matrix with translation stripped in order for skybox
+      // to always be in the right location
+      const glm::mat4 MVP = frame.projection * glm::mat4(glm::mat3(frame.view));
+      backend->UniformMatrix4fv(shader.mvpHandle, 1, false, glm::value_ptr(MVP));
+      backend->Uniform1i(shader.texMapHandle, 4);
+      break;
+    }
+    case kWaterPlane: {
+      const glm::mat4 MODELVIEW = frame.view * item.model;
+      // The model is only translated
+      backend->UniformMatrix4fv(shader.mvHandle, 1, false, glm::value_ptr(MODELVIEW));
+      backend->UniformMatrix3fv(shader.normHandle, 1, false, glm::value_ptr(frame.view_normal));
+      backend->Uniform1i(shader.texMapHandle, 4);
+      break;
+    }
   }
+}
 
-  // ROADS
-  glCullFace(GL_BACK); //Road is rendererd reverse facing
-  const int amount_road = terrain->road_indice_count();
-  const circular_vector<unsigned int> * road_vao_handle = terrain->road_vao_handle();
-  for (unsigned int x = 0; x < road_vao_handle->size(); ++x) {
-    glBindVertexArray((*road_vao_handle)[x]);
-    glDrawElements(GL_TRIANGLES, amount_road, GL_UNSIGNED_INT, 0);
+// Sends the uniforms of a single item and draws it
+void Renderer::Draw(const DrawItem &item) const {
+  RenderBackend * backend = gl_state_->backend();
+  const Shader &shader = *item.shader;
+  switch (item.kind) {
+    case kTerrainTile:
+    case kHorizonStrip: {
+      // The horizon continues the last tile's material
+      const Terrain * terrain = static_cast<const Terrain *>(item.source);
+      const Terrain::TileDescriptor &tile = (*terrain->tiles())[item.index];
+      backend->Uniform1f(shader.texLayerHandle, terrain->texture_streamer()->layer(tile.material));
+      break;
+    }
+    case kInstancedShape: {
+      // Points the instance attributes at the run, instead of a base instance
+      //   A mat4 attribute is four vec4 columns
+      assert(shader.instanceLoc >= 0 && "The shader has no a_instance_model");
+      backend->BindBuffer(GL_ARRAY_BUFFER, item.instance_buffer);
+      for (unsigned int column = 0; column < 4; ++column) {
+        const GLuint location = shader.instanceLoc + column;
+        backend->EnableVertexAttribArray(location);
+        backend->VertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+            (const GLvoid *) (sizeof(glm::mat4) * item.base_instance + sizeof(glm::vec4) * column));
+        backend->VertexAttribDivisor(location, 1);
+      }
+      backend->BindBuffer(GL_ARRAY_BUFFER, 0);
+      backend->DrawElementsInstanced(item.mode, item.count, GL_UNSIGNED_INT,
+          (const GLvoid *) (sizeof(GLuint) * item.first), item.instances);
+      return;
+    }
+    default:
+      break;
   }
-  // Unbind
-  glBindVertexArray(0);
+
+  if (item.is_indexed)
+    backend->DrawElements(item.mode, item.count, GL_UNSIGNED_INT,
+        (const GLvoid *) (sizeof(GLuint) * item.first));
+  else
+    backend->DrawArrays(item.mode, item.first, item.count);
+}
+
+// The variant of the shaded program an item is drawn with
+//   Shadows are compiled in by day, when the shadow map is drawn, and the
+//   light loops unrolled when the frame has the car's lights
+//   Shaders other than LightMappedGeneric are returned as they are
+//   @param shader, the shader of the item's source
+//   @param flags, the ShadedVariant flags of the item's kind
+//   @return  The variant, with the frame's shadows and lights compiled in
+const Shader * Renderer::ShadedVariant(const Shader * shader, unsigned int flags,
+    const FrameContext &frame) const {
+  if (shader != &shaders_.LightMappedGeneric)
+    return shader;
+  if (frame.is_day)
+    flags |= kShadedShadows;
+  if (frame.point_lights == kCarPointLights && frame.spot_lights == kCarSpotLights)
+    flags |= kShadedCarLights;
+  assert(shaders_.Shaded[flags] && "No shaded variant with these flags");
+  return shaders_.Shaded[flags];
 }
@@ -9,9 +9,13 @@
 #include "camera.h"
 #include "terrain.h"
 #include "object.h"
+#include "instance_ring.h"
 #include "Skybox.h"
 #include "Water.h"
 #include "sun.h"
+#include "frame_context.h"
+#include "render_queue.h"
+#include "gl_state.h"
 #include "shaders/shaders.h"
 
 #include "glm/glm.hpp"
@@ -25,65 +29,63 @@
 #include <GL/glut.h>
 #endif
 
-// The FBO that holds the depth texture
-//   Used for shadow mapping
+// The FBOs that hold the depth texture array
+//   Used for shadow mapping, a layer and FBO per cascade
 struct FrameBufferObject {
-  // Size of texture
+  // Size of every layer
   const unsigned int textureX;
   const unsigned int textureY;
 
-  GLuint FrameBufferShadows;
+  GLuint FrameBufferShadows[kShadowCascades];
   GLuint DepthTexture;
 
-  FrameBufferObject() :
-  // Size of texture
-  textureX(1024), textureY(1024) {
-
-  glActiveTexture(GL_TEXTURE20);
-  // generate namespace for the frame buffer 
-  glGenFramebuffers(1, &FrameBufferShadows);
-  //switch to our fbo so we can bind stuff to it
-  glBindFramebuffer(GL_FRAMEBUFFER, FrameBufferShadows);
+  // Creates the depth texture array and its FBOs
+  //   @param backend, the backend they are created through
+  FrameBufferObject(RenderBackend * backend) :
+  // Size of every layer
+  textureX(kShadowMapSize), textureY(kShadowMapSize) {
 
+  backend->ActiveTexture(GL_TEXTURE20);
   // and depthbuffer
-  glGenTextures(1, &DepthTexture);
-  // create the depth texture and attach it to the frame buffer.
-  glBindTexture(GL_TEXTURE_2D, DepthTexture);
+  backend->GenTextures(1, &DepthTexture);
+  // create the depth texture array, a layer per cascade
+  backend->BindTexture(GL_TEXTURE_2D_ARRAY, DepthTexture);
 
   // Give an empty image to OpenGL ( the last "0" )
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT16, textureX, textureY, 0, GL_DEPTH_COMPONENT, GL_FLOAT, 0);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR); 
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_R_TO_TEXTURE);
-
-  // glTexImage2D(GL_TEXTURE_2D, 0,GL_DEPTH_COMPONENT, windowX, windowY, 0,GL_DEPTH_COMPONENT, GL_FLOAT, 0);
-  // glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
-  // glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
-  // glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-  // glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-
-  // Set "renderedTexture" as our depth attachement
-  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, DepthTexture, 0);
-
-  // Instruct openGL that we won't bind a color texture with the currently binded FBO
-  glDrawBuffer(GL_NONE);
-  glReadBuffer(GL_NONE);
-
-  // Always check that our framebuffer is ok
-  GLenum Status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
-
-  if (Status != GL_FRAMEBUFFER_COMPLETE) {
-      printf("FB error, status: 0x%x\n", Status);
-      exit(-1);
+  backend->TexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT16, textureX, textureY, kShadowCascades,
+      0, GL_DEPTH_COMPONENT, GL_FLOAT, 0);
+  backend->TexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  backend->TexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  backend->TexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  backend->TexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  backend->TexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+  backend->TexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_R_TO_TEXTURE);
+
+  // generate namespace for the frame buffers
+  backend->GenFramebuffers(kShadowCascades, FrameBufferShadows);
+  for (unsigned int x = 0; x < kShadowCascades; ++x) {
+    //switch to our fbo so we can bind stuff to it
+    backend->BindFramebuffer(GL_FRAMEBUFFER, FrameBufferShadows[x]);
+    // Set the cascade's layer as our depth attachement
+    backend->FramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, DepthTexture, 0, x);
+
+    // Instruct openGL that we won't bind a color texture with the currently binded FBO
+    backend->DrawBuffer(GL_NONE);
+    backend->ReadBuffer(GL_NONE);
+
+    // Always check that our framebuffer is ok
+    GLenum Status = backend->CheckFramebufferStatus(GL_FRAMEBUFFER);
+
+    if (Status != GL_FRAMEBUFFER_COMPLETE) {
+        printf("FB error, status: 0x%x\n", Status);
+        exit(-1);
+    }
   }
 
   // Unbind buffer
-  glBindTexture(GL_TEXTURE_2D, 0);
-  glBindFramebuffer(GL_FRAMEBUFFER, 0);
-  glActiveTexture(GL_TEXTURE0);
+  backend->BindTexture(GL_TEXTURE_2D_ARRAY, 0);
+  backend->BindFramebuffer(GL_FRAMEBUFFER, 0);
+  backend->ActiveTexture(GL_TEXTURE0);
   }
 };
 
@@ -92,41 +94,109 @@ struct FrameBufferObject {
 //   Everything should be const to maximize read only performance
 class Renderer {
   public:
-    // Construct with verbose debugging mode option
-    Renderer(const bool debug_flag = false);
-
-    // Draws/Renders the passed in objects (with their models) to the scene
+    // Construct with the GL state cache and verbose debugging mode option
+    Renderer(GLState * gl_state, const bool debug_flag = false);
+
+    // Updates and binds the FrameConstants uniform block
+    //   View, projection, shadow matrix, sun direction and time shared by all shaders
+    //   Should be called once per frame before any rendering
+    //   @param frame, the shared matrices of this frame
+    void UpdateFrameConstants(const FrameContext &frame) const;
+
+    // Queues the draws of an object to be drawn to the scene
+    //   Opaque draws are culled and unblended in the opaque pass, transparent
+    //   draws are blended and sorted in the given pass
     //   @param Object * object, an object to render
+    //   @param frame, the shared matrices of this frame
+    //   @param queue, the queue of this frame
+    //   @param pass, kTransparentPass or kOverlayPass to draw it after the particles
     //   @warn this function is not responsible for NULL PTRs
-    //   @warn uses camera pointer for view matrix
-    void Render(const Object * object, const Camera &camera, const Sun &sun) const;
-    // TODO
-    void RenderDepthBuffer(const Object * car, const Sun &sun) const;
-    // Draws/Renders the passed in terrain to the scene
+    void Queue(const Object * object, const FrameContext &frame, RenderQueue * queue,
+        const RenderPass pass = kTransparentPass) const;
+    // Queues every instance of a ring to be drawn to the scene
+    //   One instanced draw per draw of its object and run of the ring
+    //   @param ring, the instances to render
+    //   @param frame, the shared matrices of this frame
+    //   @param queue, the queue of this frame
+    void Queue(const InstanceRing * ring, const FrameContext &frame, RenderQueue * queue) const;
+    // Queues the shapes of an object to be drawn into a cascade of the shadow map
+    //   Skipped if the object is outside the cascade
+    //   @param cascade, the index of the cascade
+    void QueueDepth(const Object * object, const FrameContext &frame, RenderQueue * queue,
+        const unsigned int cascade) const;
+    // Queues the tiles, roads and horizon of the terrain to be drawn to the scene
+    //   Tiles outside the view frustum are skipped
     //   @param Terrain * terrain, a terrain (cliffs/roads) to render
-    //   @warn uses camera pointer for view matrix
-    void Render(const Terrain * terrain, const Camera &camera, const Sun &sun) const;
-    // TODO
-    void RenderDepthBuffer(const Terrain * terrain, const Sun &sun) const;
+    //   @param frame, the shared matrices of this frame
+    //   @param queue, the queue of this frame
+    void Queue(const Terrain * terrain, const FrameContext &frame, RenderQueue * queue) const;
+    // Queues the props scattered over the terrain's tiles to be drawn to the scene
+    //   One instanced draw per draw of a prop per tile, tiles outside the view
+    //   frustum or further than kScatterDistance are skipped
+    //   @param props, the object of each ScatterKind
+    //   @param frame, the shared matrices of this frame
+    //   @param queue, the queue of this frame
+    void QueueScatter(const Terrain * terrain, const std::vector<Object*> &props,
+        const FrameContext &frame, RenderQueue * queue) const;
+    // Queues the tiles of the terrain to be drawn into a cascade of the cached shadow layer
+    //   The depth VAOs cover the road, so it isn't drawn
+    //   Every tile overlapping the cascade is queued, shadows can be cast from outside the view
+    //   @param cascade, the index of the cascade
+    //   @warn only needed when the cascade is outdated, see ShadowCache
+    void QueueDepth(const Terrain * terrain, const FrameContext &frame, RenderQueue * queue,
+        const unsigned int cascade) const;
+    // Queues the water, centered under the object and reflecting the sky
+    void Queue(const Water * water, const Object * object, const Skybox * sky,
+        const FrameContext &frame, RenderQueue * queue) const;
+    // Queues the skybox, drawn after every opaque item
+    void Queue(const Skybox * sky, const FrameContext &frame, RenderQueue * queue) const;
+    // Draws the sorted items of a pass
+    //   The program, textures, VAO, cull, blend and depth state go through
+    //   the GL state cache so only changes between items reach GL
+    //   Leaves depth writes on
+    //   @param queue, the sorted queue of this frame
+    //   @param pass, the pass to draw
+    //   @param frame, the shared matrices of this frame
+    void Submit(RenderQueue * queue, const RenderPass pass, const FrameContext &frame) const;
     // Render Coordinate Axis 
     //   Only renders in debugging mode
     //   @warn requires VAO from EnableAxis
-    void RenderAxis(const Camera &camera) const;
+    void RenderAxis(const FrameContext &frame) const;
     // Enable x,y,z axis coordinates VAO
     //   @return a VAO to use for the Axis
     //   @warn should only be called once, duplicate calls are irrelevant
     GLuint EnableAxis() const;
 
-    void RenderWater(const Water * water, const Object * object, const Skybox * Sky, const Camera &camera) const;
-
-    void RenderSkybox(const Skybox * Sky, const Camera &camera) const;
-
     // Accessor for a shaders pointer
     inline const Shaders * shaders() const;
     // Accessor for a fbo pointer
     inline const FrameBufferObject * fbo() const;
 
   private:
+    // Sends the uniforms shared by the items of a source
+    //   e.g. an object's matrices or the terrain's material and textures
+    void Setup(const DrawItem &item, const FrameContext &frame) const;
+    // Sends the uniforms of a single item and draws it
+    void Draw(const DrawItem &item) const;
+    // The variant of the shaded program an item is drawn with
+    //   Shaders other than LightMappedGeneric are returned as they are
+    //   @param shader, the shader of the item's source
+    //   @param flags, the ShadedVariant flags of the item's kind
+    //   @return  The variant, with the frame's shadows and lights compiled in
+    const Shader * ShadedVariant(const Shader * shader, unsigned int flags,
+        const FrameContext &frame) const;
+
+    // The half size of the box an object's shadow cascades are culled with
+    //   Larger than the car
+    const float kObjectShadowExtent = 10.0f;
+    // The height props can stand above a tile's bounding box
+    const float kScatterHeight = 3.0f;
+    // The distance past which a tile's props aren't drawn
+    const float kScatterDistance = 120.0f;
+
+    // The GL state cache shared with the rest of the render code
+    GLState * const gl_state_;
+
     // The FBO to hold the shadow map buffer and it's depth texture
     const FrameBufferObject fbo_;
 
@@ -136,6 +206,19 @@ class Renderer {
     // The VAO Handle for the Axis Coordinates
     const GLuint coord_vao_handle_;
 
+    // The uniform buffer backing the FrameConstants block
+    const GLuint frame_block_buffer_;
+    // Creates the uniform buffer for the FrameConstants block
+    //   @param backend, the backend it is created through
+    //   @return  The buffer handle, sized for a FrameBlock
+    static GLuint CreateFrameBlockBuffer(RenderBackend * backend);
+    // The sampler of the texture arrays' units, set once rather than per texture
+    const GLuint mipmap_sampler_;
+    // Creates the sampler of the mipmapped texture units and binds it to them
+    //   @param backend, the backend it is created through
+    //   @return  The sampler handle, 0 without sampler objects
+    static GLuint CreateMipmapSampler(RenderBackend * backend);
+
     // Verbose Debugging mode
     const bool is_debugging_;
 };
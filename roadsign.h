@@ -6,7 +6,9 @@
 #include <cassert>
 #include <cstdlib>
 #include "terrain.h"
+#include "texture_arrays.h"
 #include "object.h"
+#include "instance_ring.h"
 
 #include "constants.h"
 
@@ -22,23 +24,32 @@
 #include <GL/glut.h>
 #endif
 
+// The road signs placed along the road
+//   Each kind of sign is one model drawn through an InstanceRing, so a
+//   sign can be placed on every tile at the same draw cost
 class RoadSign {
   public:
-    RoadSign(const Shaders * shaders, const Terrain * terrain);
+    // The most signs of a kind placed at once
+    static const unsigned int kMaxSignInstances = 32;
 
-    // TODO comment, make const
+    // Construct with the sign models loaded
+    //   @param textures, the arrays the signs' textures are loaded into
+    RoadSign(const Shaders * shaders, TextureArrays * textures, const Terrain * terrain);
+
+    // Places the sign of the newest tile's turn type
+    //   @return  The model of the sign placed, NULL if the type has none
     Object * SignSpawn();
 
-    // Moves the active signs indexes
-    //   Reactivates past signs
+    // Moves the tile of every placed sign back by one
+    //   Removes the signs of tiles which are no longer loaded
     void ShiftIndexes();
 
     // Accessor for the signs
-    //   Used for rendering the signs
+    //   The model of each kind, in the order of the turn types
     inline std::vector<Object*> signs() const;
-    // Accessor for the signs that are active
-    //   Used to optimize draw
-    inline std::vector<int> active_signs() const;
+    // Accessor for the placements of each kind of sign
+    //   Used for rendering the signs
+    inline const std::vector<InstanceRing*> &instances() const;
 
   private:
     const Shaders * shaders_;
@@ -51,11 +62,10 @@ class RoadSign {
     // sign_right_;
     std::vector<Object*> signs_;
 
-    // The active signs (in above order)
-    //   index = order, value = index in circular_vector
-    std::vector<int> active_signs_;
+    // The placements of each sign (in above order)
+    std::vector<InstanceRing*> instances_;
 
-    Object * AddModel(const Shaders * shaders, const std::string &file_name) const;
+    Object * AddModel(const Shaders * shaders, TextureArrays * textures, const std::string &file_name) const;
 
 };
 
@@ -64,10 +74,10 @@ class RoadSign {
 inline std::vector<Object*> RoadSign::signs() const {
   return signs_;
 }
-// Accessor for the signs that are active
-//   Used to optimize draw
-inline std::vector<int> RoadSign::active_signs() const {
-  return active_signs_;
+// Accessor for the placements of each kind of sign
+//   Used for rendering the signs
+inline const std::vector<InstanceRing*> &RoadSign::instances() const {
+  return instances_;
 }
 
 #endif
@@ -0,0 +1,183 @@
+#include "scatter.h"
+
+// A random float in [0, 1] from the engine
+static float Unit(std::minstd_rand &engine) {
+  return float(engine() - engine.min()) / float(engine.max() - engine.min());
+}
+
+// The model matrix of a prop turned about y and uniformly scaled
+//   Its columns stay orthogonal, as shaded.vert expects of instances
+static glm::mat4 MakeModel(const glm::vec3 &position, const float yaw, const float scale) {
+  const float c = cos(yaw) * scale;
+  const float s = sin(yaw) * scale;
+  glm::mat4 model;
+  model[0] = glm::vec4(c, 0.0f, -s, 0.0f);
+  model[1] = glm::vec4(0.0f, scale, 0.0f, 0.0f);
+  model[2] = glm::vec4(s, 0.0f, c, 0.0f);
+  model[3] = glm::vec4(position, 1.0f);
+  return model;
+}
+
+// Construct with the tile dimensions and starts the worker
+//   @param width, the amount of vertices across a tile (a multiple of 32)
+//   @param height, the amount of vertices along a tile
+//   @param seed, the terrain seed
+ScatterWorker::ScatterWorker(const int width, const int height, const unsigned int seed) :
+  x_length_(width), z_length_(height), length_multiplier_(width / 32), seed_(seed),
+  is_running_(true), worker_(&ScatterWorker::Work, this) {
+  }
+
+// Stops and joins the worker thread
+ScatterWorker::~ScatterWorker() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_running_ = false;
+  }
+  condition_.notify_one();
+  worker_.join();
+}
+
+// Queues a tile to be placed
+//   @param tile, the serial of the tile
+//   @param vertices, the finished vertices of the tile
+//   @param normals, the finished normals of the tile
+void ScatterWorker::Request(const unsigned int tile, const std::vector<glm::vec3> &vertices,
+    const std::vector<glm::vec3> &normals) {
+  assert(vertices.size() == normals.size() && "Every vertex needs a normal");
+  Job job;
+  job.tile = tile;
+  job.vertices = vertices;
+  job.normals = normals;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    jobs_.push(job);
+  }
+  condition_.notify_one();
+}
+
+// Takes a placed tile
+//   @param scatter, set to the props of the tile
+//   @return  false if no tile has been placed since the last call
+bool ScatterWorker::Poll(TileScatter * scatter) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (placed_.empty())
+    return false;
+  scatter->tile = placed_.front().tile;
+  scatter->instances.swap(placed_.front().instances);
+  for (unsigned int x = 0; x < kScatterKinds; ++x) {
+    scatter->first[x] = placed_.front().first[x];
+    scatter->count[x] = placed_.front().count[x];
+  }
+  placed_.pop();
+  return true;
+}
+
+// The worker loop, places jobs until stopped
+void ScatterWorker::Work() {
+  while (true) {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      while (is_running_ && jobs_.empty())
+        condition_.wait(lock);
+      if (!is_running_)
+        return;
+      job.tile = jobs_.front().tile;
+      job.vertices.swap(jobs_.front().vertices);
+      job.normals.swap(jobs_.front().normals);
+      jobs_.pop();
+    }
+    TileScatter scatter;
+    Place(job, &scatter);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    placed_.push(TileScatter());
+    placed_.back().tile = scatter.tile;
+    placed_.back().instances.swap(scatter.instances);
+    for (unsigned int x = 0; x < kScatterKinds; ++x) {
+      placed_.back().first[x] = scatter.first[x];
+      placed_.back().count[x] = scatter.count[x];
+    }
+  }
+}
+
+// Places the props of a tile
+//   Rocks and shrubs on both banks, clear of the road by a column, and a
+//   post every kPostSpacing rows along the water side of the road
+//   @param job, the tile
+//   @param scatter, filled with its props
+void ScatterWorker::Place(const Job &job, TileScatter * scatter) const {
+  std::minstd_rand engine(seed_ + job.tile * 2654435761u);
+  // The columns of the water and cliff banks
+  const int water_min_x = 0;
+  const int water_max_x = 15 * length_multiplier_ - 1;
+  const int cliff_min_x = 19 * length_multiplier_ + 1;
+  const int cliff_max_x = x_length_ - 1;
+
+  scatter->tile = job.tile;
+  scatter->instances.clear();
+  scatter->instances.reserve(kRockTries + kShrubTries + z_length_ / kPostSpacing + 1);
+  glm::mat4 model;
+
+  // Rocks, from pebbles to boulders
+  scatter->first[kScatterRock] = scatter->instances.size();
+  for (unsigned int x = 0; x < kRockTries; ++x) {
+    const bool is_water_side = x % 2 == 0;
+    if (TryPlace(job, engine, is_water_side ? water_min_x : cliff_min_x,
+          is_water_side ? water_max_x : cliff_max_x, kRockMinUp, 0.2f, 1.6f, &model))
+      scatter->instances.push_back(model);
+  }
+  scatter->count[kScatterRock] = scatter->instances.size() - scatter->first[kScatterRock];
+
+  // Shrubs, only on gentle slopes
+  scatter->first[kScatterShrub] = scatter->instances.size();
+  for (unsigned int x = 0; x < kShrubTries; ++x) {
+    const bool is_water_side = x % 2 == 0;
+    if (TryPlace(job, engine, is_water_side ? water_min_x : cliff_min_x,
+          is_water_side ? water_max_x : cliff_max_x, kShrubMinUp, 0.5f, 1.4f, &model))
+      scatter->instances.push_back(model);
+  }
+  scatter->count[kScatterShrub] = scatter->instances.size() - scatter->first[kScatterShrub];
+
+  // Posts, facing along the road
+  scatter->first[kScatterPost] = scatter->instances.size();
+  for (int z = 0; z + 1 < z_length_; z += kPostSpacing) {
+    const glm::vec3 &position = job.vertices[water_max_x + z * x_length_];
+    if (position.y < kMinHeight)
+      continue;
+    const glm::vec3 along = job.vertices[water_max_x + (z + 1) * x_length_] - position;
+    scatter->instances.push_back(MakeModel(position, atan2(along.x, along.z), 1.0f));
+  }
+  scatter->count[kScatterPost] = scatter->instances.size() - scatter->first[kScatterPost];
+}
+
+// Tries to place a prop at a random point of a range of columns
+//   The point is interpolated within its quad and the prop sunk a little
+//   so it doesn't float where the quad's triangles fold
+//   @param min_x, max_x, the [min_x, max_x) columns
+//   @param min_up, the least normal y of the ground
+//   @param min_scale, max_scale, the range of sizes, small ones are likelier
+//   @return  true if the ground there suits, model is then its matrix
+bool ScatterWorker::TryPlace(const Job &job, std::minstd_rand &engine, const int min_x, const int max_x,
+    const float min_up, const float min_scale, const float max_scale, glm::mat4 * model) const {
+  const int x = min_x + engine() % (max_x - min_x);
+  const int z = engine() % (z_length_ - 1);
+  const float fx = Unit(engine);
+  const float fz = Unit(engine);
+  const float yaw = Unit(engine) * 6.2831853f;
+  const float size = Unit(engine);
+
+  const unsigned int index = x + z * x_length_;
+  if (job.normals[index].y < min_up)
+    return false;
+  const glm::vec3 near_row = glm::mix(job.vertices[index], job.vertices[index + 1], fx);
+  const glm::vec3 far_row = glm::mix(job.vertices[index + x_length_], job.vertices[index + x_length_ + 1], fx);
+  glm::vec3 position = glm::mix(near_row, far_row, fz);
+  if (position.y < kMinHeight)
+    return false;
+
+  const float scale = min_scale + (max_scale - min_scale) * size * size;
+  position.y -= 0.1f * scale;
+  *model = MakeModel(position, yaw, scale);
+  return true;
+}
@@ -0,0 +1,118 @@
+#ifndef ASSIGN3_SCATTER_H_
+#define ASSIGN3_SCATTER_H_
+
+#include <vector>
+#include <cmath>
+#include <queue>
+#include <random>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cassert>
+
+#include "glm/glm.hpp"
+
+// The kinds of props scattered beside the road
+enum ScatterKind {
+  kScatterRock = 0,
+  kScatterShrub = 1,
+  kScatterPost = 2,
+  kScatterKinds,
+};
+
+// The props of one tile
+//   The model matrices of every kind one after another, uploaded as one
+//   instance buffer and drawn with a run per kind
+struct TileScatter {
+  // The serial of the tile, see Terrain::TileDescriptor
+  unsigned int tile;
+  std::vector<glm::mat4> instances;
+  // The run of each kind in instances
+  unsigned int first[kScatterKinds];
+  unsigned int count[kScatterKinds];
+};
+
+// Places the rocks, shrubs and posts of tiles on a worker thread
+//   The tile's vertices and normals are copied on request, so the generator
+//   can move on to the next tile at once. Every tile is placed with its own
+//   random engine seeded from the terrain seed and its serial, so the props
+//   of a tile are the same whatever order they are placed in
+//   The amount of tries per kind is fixed, so a tile always costs the same
+//   however much of it is steep or under water
+//   @warn  Request and Poll must be called from the same thread
+class ScatterWorker {
+  public:
+    // Construct with the tile dimensions and starts the worker
+    //   @param width, the amount of vertices across a tile (a multiple of 32)
+    //   @param height, the amount of vertices along a tile
+    //   @param seed, the terrain seed
+    ScatterWorker(const int width, const int height, const unsigned int seed);
+    // Stops and joins the worker thread
+    ~ScatterWorker();
+
+    // Queues a tile to be placed
+    //   @param tile, the serial of the tile
+    //   @param vertices, the finished vertices of the tile
+    //   @param normals, the finished normals of the tile
+    void Request(const unsigned int tile, const std::vector<glm::vec3> &vertices,
+        const std::vector<glm::vec3> &normals);
+    // Takes a placed tile
+    //   @param scatter, set to the props of the tile
+    //   @return  false if no tile has been placed since the last call
+    bool Poll(TileScatter * scatter);
+
+  private:
+    // CONSTANTS
+    // The tries at placing a rock and a shrub in each tile
+    static const unsigned int kRockTries = 600;
+    static const unsigned int kShrubTries = 1200;
+    // The rows between posts along the water side of the road
+    static const unsigned int kPostSpacing = 24;
+    // The lowest prop, above the water's waves
+    const float kMinHeight = -1.0f;
+    // The least normal y (cos of the steepest slope) a rock and shrub stand on
+    const float kRockMinUp = 0.5f;
+    const float kShrubMinUp = 0.8f;
+
+    // A tile waiting to be placed
+    struct Job {
+      unsigned int tile;
+      std::vector<glm::vec3> vertices;
+      std::vector<glm::vec3> normals;
+    };
+
+    // The amount of vertices across and along a tile
+    const int x_length_;
+    const int z_length_;
+    // The tile width in multiples of 32, the road is columns [15, 19) of it
+    const int length_multiplier_;
+    // The terrain seed
+    const unsigned int seed_;
+
+    // WORKER THREAD
+    // Tiles to place
+    std::queue<Job> jobs_;
+    // Placed tiles to upload
+    std::queue<TileScatter> placed_;
+    // Guards jobs_, placed_ and is_running_
+    std::mutex mutex_;
+    // Wakes the worker up on new jobs
+    std::condition_variable condition_;
+    // Cleared on destruction to stop the worker
+    bool is_running_;
+    // The worker placing props
+    std::thread worker_;
+
+    // The worker loop, places jobs until stopped
+    void Work();
+    // Places the props of a tile
+    //   @param job, the tile
+    //   @param scatter, filled with its props
+    void Place(const Job &job, TileScatter * scatter) const;
+    // Tries to place a prop at a random point of a range of columns
+    //   @return  true if the ground there suits, model is then its matrix
+    bool TryPlace(const Job &job, std::minstd_rand &engine, const int min_x, const int max_x,
+        const float min_up, const float min_scale, const float max_scale, glm::mat4 * model) const;
+};
+
+#endif
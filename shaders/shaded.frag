@@ -1,7 +1,12 @@
 #version 130
+#extension GL_ARB_uniform_buffer_object : require
 
-// 0 = No fog, 1 = Linear, 2 = Exponential, 3 = Exponentional (diff)
-uniform int fog_mode;
+// Variants, see ShadedVariant in shaders.h
+//   BUMPED         cliffs, the normal and moss maps are applied
+//   TEXTURE_ARRAY  the tile's layer of texArray is sampled instead of texMap
+//   SHADOWS        the shadow map cascades are sampled, else all is in shadow
+//   POINT_LIGHTS   the amount of point lights, else gNumPointLights
+//   SPOT_LIGHTS    the amount of spot lights, else gNumSpotLights
 
 struct BaseLight
 {
@@ -41,33 +46,89 @@ const int MAX_POINT_LIGHTS = 10;
 const int MAX_SPOT_LIGHTS = 10;
 // Bias for trimming shadow acne
 const float BIAS = 0.001;
+// The amount of shadow cascades
+//   @warn must match kShadowCascades in uniform_blocks.h
+const int SHADOW_CASCADES = 3;
+// The amount of materials in a Materials block
+//   @warn must match kMaxMaterials in uniform_blocks.h
+const int MAX_MATERIALS = 64;
+
+// Per frame constants, shared by all shaders
+//   @warn must match FrameBlock in uniform_blocks.h
+layout(std140) uniform FrameConstants
+{
+  mat4 view_matrix;
+  mat4 projection_matrix;
+  mat4 shadow_matrices[SHADOW_CASCADES];
+  vec4 shadow_splits;
+  vec4 sun_direction;
+  float time;
+};
+
+// Light properties, shared by all lit shaders
+//   @warn must match LightsBlock in uniform_blocks.h
+layout(std140) uniform Lights
+{
+  DirectionalLight gDirectionalLight;
+  PointLight gPointLights[MAX_POINT_LIGHTS];
+  SpotLight gSpotLights[MAX_SPOT_LIGHTS];
+  int gNumPointLights;
+  int gNumSpotLights;
+};
+
+struct Material
+{
+  vec3 ambient;
+  float dissolve;
+  vec3 diffuse;
+  float shininess;
+  vec3 specular;
+  float layer;
+};
+
+// The materials of the model being drawn
+//   @warn must match MaterialBlock in uniform_blocks.h
+layout(std140) uniform Materials
+{
+  Material gMaterials[MAX_MATERIALS];
+};
+
+// Material properties, of the fragment's material
+vec3 mtl_ambient;
+vec3 mtl_diffuse;
+vec3 mtl_specular;
+float shininess;
+float dissolve;
 
-// Light properties
-uniform int gNumPointLights;
-uniform int gNumSpotLights;
-uniform DirectionalLight gDirectionalLight;
-uniform PointLight gPointLights[MAX_POINT_LIGHTS];
-uniform SpotLight gSpotLights[MAX_SPOT_LIGHTS];
-
-// Material properties
-uniform vec3 mtl_ambient;
-uniform vec3 mtl_diffuse;
-uniform vec3 mtl_specular;
-uniform float shininess;
-uniform float dissolve;
-
-uniform int isBumped;
 uniform float shadowIntensity;
 
-uniform sampler2D texMap;
-uniform sampler2D normMap;
-uniform sampler2D mossMap;
-uniform sampler2DShadow shadowMap;
+#ifdef TEXTURE_ARRAY
+// Terrain samples its layer of the texture array instead of texMap
+uniform float texLayer;
+uniform sampler2DArray texArray;
+#else
+// Loaded textures are layers of TextureArrays, texMap's layer is the material's
+uniform sampler2DArray texMap;
+#endif
+#ifdef BUMPED
+// The layers of the bump maps in their arrays
+uniform float normLayer;
+uniform float mossLayer;
+uniform sampler2DArray normMap;
+uniform sampler2DArray mossMap;
+#endif
+#ifdef SHADOWS
+// A layer per cascade
+uniform sampler2DArrayShadow shadowMap;
+#endif
 
 in vec4 a_vertex_mv;
 in vec3 a_normal_mv;
 in vec2 a_tex_coord;
-in vec4 a_shadow_coord;
+#ifdef SHADOWS
+in vec4 a_shadow_coord[SHADOW_CASCADES];
+#endif
+flat in int a_material_index;
 
 out vec4 fragColour;
 
@@ -161,40 +222,79 @@ vec4 calcSpotLight(in SpotLight light, in vec4 position, in vec3 normal)
 
 void main(void) {
 
+  Material material = gMaterials[a_material_index];
+  mtl_ambient = material.ambient;
+  mtl_diffuse = material.diffuse;
+  mtl_specular = material.specular;
+  shininess = material.shininess;
+  dissolve = material.dissolve;
+
   // Cannot trust pipeline interpolation to generate normalized normals
 
   vec4 vertex_mv = a_vertex_mv;
   vec3 normal_mv = normalize(a_normal_mv);  
  
-  if(isBumped > 0)
-  {
-    vec3 NN = texture(normMap, a_tex_coord.st).xyz; // normal map
-    normal_mv  =  normal_mv +  normalize(2.0*NN.xyz-1.0);
-  }
+#ifdef BUMPED
+  vec3 NN = texture(normMap, vec3(a_tex_coord.st, normLayer)).xyz; // normal map
+  normal_mv  =  normal_mv +  normalize(2.0*NN.xyz-1.0);
+#endif
 
 
   vec4 litColour = calcDirectionalLight(normal_mv);
 
+#ifdef POINT_LIGHTS
+  for (int i = 0; i < POINT_LIGHTS; i++)
+#else
   for (int i = 0; i < gNumPointLights; i++)
+#endif
   {
     litColour += calcPointLight(gPointLights[i], vertex_mv, normal_mv);
   }
 
+#ifdef SPOT_LIGHTS
+  for (int i = 0; i < SPOT_LIGHTS; i++)
+#else
   for (int i = 0; i < gNumSpotLights; i++)
+#endif
   {
     litColour += calcSpotLight(gSpotLights[i], vertex_mv, normal_mv);
   }
 
-	if(isBumped > 0)
-  {
-    litColour = mix(litColour, texture(mossMap, a_tex_coord), 0.2);
+#ifdef BUMPED
+  litColour = mix(litColour, texture(mossMap, vec3(a_tex_coord, mossLayer)), 0.2);
+#endif
+
+#ifdef SHADOWS
+  // The nearest cascade covering the fragment, none past the last
+  float depth = -a_vertex_mv.z;
+  float visibility = 1.0;
+  if (depth < shadow_splits.z) {
+    vec4 shadow_coord = a_shadow_coord[2];
+    float layer = 2.0;
+    if (depth < shadow_splits.y) {
+      shadow_coord = a_shadow_coord[1];
+      layer = 1.0;
+    }
+    if (depth < shadow_splits.x) {
+      shadow_coord = a_shadow_coord[0];
+      layer = 0.0;
+    }
+    visibility = texture(shadowMap, vec4(shadow_coord.xy, layer, (shadow_coord.z-BIAS)/shadow_coord.w) );
   }
-
-  float visibility = texture(shadowMap, vec3(a_shadow_coord.xy, (a_shadow_coord.z-BIAS)/a_shadow_coord.w) );
+#else
+  // No shadow map is drawn at night
+  float visibility = 0.0;
+#endif
   visibility = visibility / 2 + 0.5; //Fit range between [0,0.5]
   visibility *= shadowIntensity;
   litColour *= 1.6+(1-shadowIntensity);
 
-  fragColour = mix(vec4(0.7,0.7,0.7,1.0), visibility * litColour * texture(texMap, a_tex_coord), fogFactor(vertex_mv,15.0,80.0,0.008));
+#ifdef TEXTURE_ARRAY
+  vec4 texColour = texture(texArray, vec3(a_tex_coord, texLayer));
+#else
+  vec4 texColour = texture(texMap, vec3(a_tex_coord, material.layer));
+#endif
+
+  fragColour = mix(vec4(0.7,0.7,0.7,1.0), visibility * litColour * texColour, fogFactor(vertex_mv,15.0,80.0,0.008));
   fragColour.a = dissolve;
 }
@@ -1,29 +1,76 @@
 #version 130
+#extension GL_ARB_uniform_buffer_object : require
 
 uniform mat4 modelview_matrix;
 uniform mat4 mvp_matrix;
-uniform mat4 depth_bias_mvp_matrix;
 uniform mat3 normal_matrix;
+// Variants, see ShadedVariant in shaders.h
+//   INSTANCED  a_instance_model places the vertex, the matrices above are
+//              then the view's only
+//   SHADOWS    the vertex is projected into the shadow map cascades
+
+// The amount of shadow cascades
+//   @warn must match kShadowCascades in uniform_blocks.h
+const int SHADOW_CASCADES = 3;
+
+// Per frame constants, shared by all shaders
+//   @warn must match FrameBlock in uniform_blocks.h
+layout(std140) uniform FrameConstants
+{
+  mat4 view_matrix;
+  mat4 projection_matrix;
+  mat4 shadow_matrices[SHADOW_CASCADES];
+  vec4 shadow_splits;
+  vec4 sun_direction;
+  float time;
+};
 
 in vec3 a_vertex;
 in vec2 a_texture;
 in vec3 a_normal;
+// The index of the vertex's material in the Materials block
+//   Left disabled by the terrain, i.e. 0
+in float a_material;
+#ifdef INSTANCED
+// The model matrix of the instance, see InstanceRing
+in mat4 a_instance_model;
+#endif
 
 out vec4 a_vertex_mv;
 out vec3 a_normal_mv;
 out vec2 a_tex_coord;
-out vec4 a_shadow_coord;
+#ifdef SHADOWS
+out vec4 a_shadow_coord[SHADOW_CASCADES];
+#endif
+flat out int a_material_index;
 
 void main()
 {
+  vec4 vertex = vec4(a_vertex, 1.0);
+  vec3 normal = a_normal;
+#ifdef INSTANCED
+  vertex = a_instance_model * vertex;
+  // The inverse transpose of a rotation and scale, whose columns are
+  // orthogonal, is each column divided by its squared length
+  mat3 model = mat3(a_instance_model);
+  model[0] /= dot(model[0], model[0]);
+  model[1] /= dot(model[1], model[1]);
+  model[2] /= dot(model[2], model[2]);
+  normal = model * normal;
+#endif
+
   // Pass pipeline the vertex position and normal in eye coordinates for light computation
-  a_vertex_mv = modelview_matrix * vec4(a_vertex, 1.0);
-  a_normal_mv = normalize(normal_matrix * a_normal);
+  a_vertex_mv = modelview_matrix * vertex;
+  a_normal_mv = normalize(normal_matrix * normal);
 
   // Texture coordinates 
   a_tex_coord = a_texture;
-  a_shadow_coord = depth_bias_mvp_matrix * vec4(a_vertex, 1.0);
+  a_material_index = int(a_material);
+#ifdef SHADOWS
+  for (int i = 0; i < SHADOW_CASCADES; ++i)
+    a_shadow_coord[i] = shadow_matrices[i] * vertex;
+#endif
 
   // Apply full MVP transformation
-  gl_Position = mvp_matrix * vec4(a_vertex, 1.0);
+  gl_Position = mvp_matrix * vertex;
 }
@@ -3,20 +3,35 @@
 #include <vector>
 #include <iostream>
 #include <fstream>
+#include <iterator>
+#include <chrono>
+#include <sys/stat.h>
 
 #include <GL/glew.h>
 
 #include "shader.hpp"
 
-int CompileShader(const char *ShaderPath, const GLuint ShaderID)
+// Where linked program binaries are kept between runs
+static const char * const kProgramCacheDir = "shaders/cache";
+// Part of every cache key, bump when programs are linked differently
+// (e.g. the attribute locations below) so old binaries aren't loaded
+static const char * const kProgramCacheVersion = "1";
+
+int ReadShader(const char *ShaderPath, const char *Defines, std::string &ShaderCode)
 {
 	// Read shader code from file
-	std::string ShaderCode;
 	std::ifstream ShaderStream (ShaderPath, std::ios::in);
 	if (ShaderStream.is_open()) {
 		std::string Line = "";
+		bool IsVersionLine = true;
 		while (getline(ShaderStream, Line)) {
 			ShaderCode += "\n" + Line;
+			// The defines must follow #version, which must come first
+			if (IsVersionLine) {
+				ShaderCode += "\n";
+				ShaderCode += Defines;
+				IsVersionLine = false;
+			}
         }
 		ShaderStream.close();
 	}
@@ -24,7 +39,11 @@ int CompileShader(const char *ShaderPath, const GLuint ShaderID)
         std::cerr << "Cannot open " << ShaderPath << ". Are you in the right directory?" << std::endl;
 		return 0;
 	}
+    return 1;
+}
 
+int CompileShader(const std::string &ShaderCode, const GLuint ShaderID)
+{
 	// Compile Shader
 	char const *SourcePointer = ShaderCode.c_str();
 	glShaderSource(ShaderID, 1, &SourcePointer , NULL);
@@ -36,7 +55,6 @@ int CompileShader(const char *ShaderPath, const GLuint ShaderID)
 
 	glGetShaderiv(ShaderID, GL_COMPILE_STATUS, &Result);
 	glGetShaderiv(ShaderID, GL_INFO_LOG_LENGTH, &InfoLogLength);
-    printf("compiled shader %d %d\n", Result, InfoLogLength);
 	if ( InfoLogLength > 1 ) {
         char ShaderErrorMessage[InfoLogLength+1];
 		glGetShaderInfoLog( ShaderID,
@@ -49,23 +67,135 @@ int CompileShader(const char *ShaderPath, const GLuint ShaderID)
     return 1;
 }
 
+// FNV-1a, continued from Hash
+static unsigned long long HashString(const char *String, unsigned long long Hash)
+{
+	// glGetString is NULL without a context
+	for (; String && *String; ++String)
+		Hash = (Hash ^ static_cast<unsigned char>(*String)) * 1099511628211ull;
+	// Separates consecutive strings
+	return (Hash ^ 0xff) * 1099511628211ull;
+}
+
+// The cache file of a program, keyed by its sources (defines included) and
+// the driver, which is what decides whether a binary still loads
+static std::string ProgramCachePath(const std::string &VertexCode, const std::string &FragmentCode)
+{
+	unsigned long long Hash = 14695981039346656037ull;
+	Hash = HashString(kProgramCacheVersion, Hash);
+	Hash = HashString(VertexCode.c_str(), Hash);
+	Hash = HashString(FragmentCode.c_str(), Hash);
+	Hash = HashString(reinterpret_cast<const char *>(glGetString(GL_VENDOR)), Hash);
+	Hash = HashString(reinterpret_cast<const char *>(glGetString(GL_RENDERER)), Hash);
+	Hash = HashString(reinterpret_cast<const char *>(glGetString(GL_VERSION)), Hash);
+	char Name[32];
+	snprintf(Name, sizeof(Name), "/%016llx.bin", Hash);
+	return kProgramCacheDir + std::string(Name);
+}
+
+// Loads a program binary saved by SaveProgramBinary
+// Returns 0 if there is none or the driver rejects it, e.g. after an update
+static GLuint LoadProgramBinary(const std::string &CachePath)
+{
+	std::ifstream CacheStream (CachePath.c_str(), std::ios::in | std::ios::binary);
+	if (!CacheStream.is_open())
+		return 0;
+	GLenum Format = 0;
+	CacheStream.read(reinterpret_cast<char *>(&Format), sizeof(Format));
+	std::vector<char> Binary((std::istreambuf_iterator<char>(CacheStream)),
+	                         std::istreambuf_iterator<char>());
+	if (Binary.empty())
+		return 0;
+
+	GLuint ProgramID = glCreateProgram();
+	glProgramBinary(ProgramID, Format, &Binary[0], Binary.size());
+	GLint Result = GL_FALSE;
+	glGetProgramiv(ProgramID, GL_LINK_STATUS, &Result);
+	if (Result != GL_TRUE) {
+		glDeleteProgram(ProgramID);
+		return 0;
+	}
+	return ProgramID;
+}
+
+// Saves a linked program's binary, its format first
+// Written to a temporary file first, so a reader never sees half a binary
+static void SaveProgramBinary(const GLuint ProgramID, const std::string &CachePath)
+{
+	GLint Length = 0;
+	glGetProgramiv(ProgramID, GL_PROGRAM_BINARY_LENGTH, &Length);
+	if (Length <= 0)
+		return;
+	std::vector<char> Binary(Length);
+	GLenum Format = 0;
+	glGetProgramBinary(ProgramID, Length, NULL, &Format, &Binary[0]);
+
+	// Fails harmlessly if it exists
+	mkdir(kProgramCacheDir, 0755);
+	const std::string TemporaryPath = CachePath + ".tmp";
+	std::ofstream CacheStream (TemporaryPath.c_str(), std::ios::out | std::ios::binary);
+	if (!CacheStream.is_open()) {
+		std::cerr << "Cannot write " << TemporaryPath << ", the program isn't cached" << std::endl;
+		return;
+	}
+	CacheStream.write(reinterpret_cast<const char *>(&Format), sizeof(Format));
+	CacheStream.write(&Binary[0], Binary.size());
+	CacheStream.close();
+	if (CacheStream.fail() || rename(TemporaryPath.c_str(), CachePath.c_str()) != 0) {
+		std::cerr << "Cannot write " << CachePath << ", the program isn't cached" << std::endl;
+		remove(TemporaryPath.c_str());
+	}
+}
+
 GLuint LoadShaders(const char * vertex_file_path,
-                   const char * fragment_file_path )
+                   const char * fragment_file_path,
+                   const char * defines,
+                   bool is_verbose )
 {
+	const std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+	std::string VertexCode, FragmentCode;
+	if ( !ReadShader(vertex_file_path, defines, VertexCode)
+	     || !ReadShader(fragment_file_path, defines, FragmentCode) ) {
+		return 0;
+	}
+
+	// Skip compiling and linking if this driver linked the same sources before
+	const bool IsCacheable = GLEW_ARB_get_program_binary;
+	const std::string CachePath = IsCacheable ? ProgramCachePath(VertexCode, FragmentCode) : "";
+	if (IsCacheable) {
+		const GLuint CachedID = LoadProgramBinary(CachePath);
+		if (CachedID) {
+			if (is_verbose)
+				printf("loaded %s from the program cache in %.2f ms\n", vertex_file_path,
+				       std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count());
+			return CachedID;
+		}
+	}
+
 	// Create the shaders
 	GLuint VertexShaderID = glCreateShader(GL_VERTEX_SHADER);
 	GLuint FragmentShaderID = glCreateShader(GL_FRAGMENT_SHADER);
 
     // Compile both shaders. Exit if compile errors.
-    if ( !CompileShader(vertex_file_path, VertexShaderID)
-         || !CompileShader(fragment_file_path, FragmentShaderID) ) {
+    if ( !CompileShader(VertexCode, VertexShaderID)
+         || !CompileShader(FragmentCode, FragmentShaderID) ) {
         return 0;
     }
 
 	// Link the program
 	GLuint ProgramID = glCreateProgram();
+	if (IsCacheable)
+		glProgramParameteri(ProgramID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 	glAttachShader(ProgramID, VertexShaderID);
 	glAttachShader(ProgramID, FragmentShaderID);
+	// The same attribute locations in every program, so a VAO made with one
+	// variant of a shader can be drawn with any other
+	glBindAttribLocation(ProgramID, 0, "a_vertex");
+	glBindAttribLocation(ProgramID, 1, "a_normal");
+	glBindAttribLocation(ProgramID, 2, "a_texture");
+	glBindAttribLocation(ProgramID, 3, "a_material");
+	// A mat4, takes locations 4 to 7
+	glBindAttribLocation(ProgramID, 4, "a_instance_model");
 	glLinkProgram(ProgramID);
 
 	// Check the program
@@ -83,6 +213,11 @@ GLuint LoadShaders(const char * vertex_file_path,
 	glDeleteShader(VertexShaderID);
 	glDeleteShader(FragmentShaderID);
 
+	if (IsCacheable && Result == GL_TRUE)
+		SaveProgramBinary(ProgramID, CachePath);
+	if (is_verbose)
+		printf("compiled %s in %.2f ms\n", vertex_file_path,
+		       std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count());
 	return ProgramID;
 }
 
@@ -4,11 +4,16 @@
 /**************************************************
  * Simple function to read GLSL shader source from a file,
  * Then compile it and link to create a shader program ready for use.
+ * The defines (e.g. "#define SHADOWS\n") are inserted after the
+ * #version line of both stages, to compile variants of one source.
+ * Prints how long each program took to load when is_verbose.
  * Returns the ID of the shader program (assigned by OpenGL)
  * or 0 if error.
 **************************************************/
 
 GLuint LoadShaders(const char * vertex_file_path,
-                   const char * fragment_file_path);
+                   const char * fragment_file_path,
+                   const char * defines = "",
+                   bool is_verbose = false);
 
 #endif
@@ -4,12 +4,109 @@
 #include <cassert>
 #include <string>
 #include <cstdio>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <type_traits>
 #include <GL/glew.h>
-#include "shader_compiler/shader.hpp"
+#include "uniform_blocks.h"
+#include "../render_backend.h"
+
+// The FNV-1a hash of a uniform name
+//   @param name, the uniform name
+//   @param hash, the hash of a prefix to continue from, i.e.
+//          UniformHash(".Position", UniformHash("gPointLights[0]")) is the
+//          hash of "gPointLights[0].Position"
+//   @return  The 32 bit hash, see UNIFORM_HASH for compile time hashing
+constexpr unsigned int UniformHash(const char * name, const unsigned int hash = 2166136261u) {
+  return *name ? UniformHash(name + 1, (hash ^ static_cast<unsigned char>(*name)) * 16777619u) : hash;
+}
+
+// The hash of a literal uniform name, computed by the compiler
+#define UNIFORM_HASH(name) std::integral_constant<unsigned int, UniformHash(name)>::value
+// The location of a literal uniform name in a Shader, see Shader::Uniform
+#define UNIFORM(shader, name) (shader).Uniform(UNIFORM_HASH(name), name)
+
+// A Uniform Registry
+//   Resolves the location of every active uniform of a linked program once,
+//   keyed by the hash of its name. Array elements are registered both as
+//   "name" and "name[i]", struct array members as the driver reports them
+//   i.e. "gPointLights[1].Position"
+//   Lookups are a binary search, no driver calls are made after construction
+//   @warn Must be constructed on the GL thread after the program is linked
+class UniformRegistry {
+  public:
+    // Enumerates and resolves all active uniforms of the program
+    //   @param backend, the backend the program is queried through
+    //   @param program, the linked program id
+    //   @param file, the shader name for warnings
+    UniformRegistry(RenderBackend * backend, const GLuint program, const std::string &file) : file_(file) {
+      GLint count = 0, max_length = 0;
+      backend->GetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+      backend->GetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+      std::vector<char> name(max_length + 1, 0);
+      for (GLint x = 0; x < count; ++x) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type;
+        backend->GetActiveUniform(program, x, name.size(), &length, &size, &type, &name[0]);
+        std::string base(&name[0], length);
+        // Arrays are reported by their first element
+        if (base.size() > 3 && base.compare(base.size() - 3, 3, "[0]") == 0)
+          base.erase(base.size() - 3);
+        Register(backend, program, base);
+        for (GLint element = 0; size > 1 && element < size; ++element)
+          Register(backend, program, base + "[" + std::to_string(element) + "]");
+      }
+      std::sort(locations_.begin(), locations_.end());
+      for (unsigned int x = 1; x < locations_.size(); ++x) {
+        if (locations_[x].first == locations_[x-1].first)
+          fprintf(stderr, "%s - Uniform name hash collision - %u\n", file_.c_str(), locations_[x].first);
+      }
+    }
+
+    // The location of the uniform with the hashed name
+    //   A program without any active uniform, i.e. one recorded without a
+    //   context, isn't warned about
+    //   @param hash, the UniformHash of the name
+    //   @param name, the name, only used for the warning
+    //   @return  The location, -1 (and a warning the first time) if not active
+    GLint Location(const unsigned int hash, const char * name) const {
+      const std::vector<std::pair<unsigned int, GLint> >::const_iterator it = std::lower_bound(
+          locations_.begin(), locations_.end(), std::make_pair(hash, GLint(-1)));
+      if (it != locations_.end() && it->first == hash)
+        return it->second;
+      if (!locations_.empty() && std::find(warned_.begin(), warned_.end(), hash) == warned_.end()) {
+        warned_.push_back(hash);
+        fprintf(stderr, "%s - Could not find uniform variable - %s\n", file_.c_str(), name);
+      }
+      return -1;
+    }
+
+    // Accessor for the amount of registered names
+    inline unsigned int size() const { return locations_.size(); }
+
+  private:
+    // The shader name for warnings
+    const std::string file_;
+    // The name hash and location pairs, sorted by hash
+    std::vector<std::pair<unsigned int, GLint> > locations_;
+    // The hashes of missing uniforms already warned about
+    mutable std::vector<unsigned int> warned_;
+
+    // Resolves and stores a single name
+    void Register(RenderBackend * backend, const GLuint program, const std::string &name) {
+      const GLint location = backend->GetUniformLocation(program, name.c_str());
+      if (location != -1)
+        locations_.push_back(std::make_pair(UniformHash(name.c_str()), location));
+    }
+};
 
 // A Shader
 //   Holds an ID and all possible handles of a shader
 //   In debugging mode prints uniforms not found
+//   Per frame camera, sun and light data come from the shared uniform
+//   blocks instead, see uniform_blocks.h
 //   @warn Uniforms not found will be -1
 //   @warn Function calls in initializer list hence order
 //         of declaration is vital!
@@ -19,13 +116,13 @@ struct Shader {
 
   // GET UNIFORMS
   // Matrices
-  const GLint         projHandle;
   const GLint          mvpHandle;
   const GLint           mvHandle;
   const GLint         normHandle;
   const GLint       texMapHandle;
+  const GLint     texArrayHandle;
+  const GLint     texLayerHandle;
   const GLint    shadowMapHandle;
-  const GLint depthBiasMvpHandle;
   const GLint     depthMvpHandle;
   // Lighting
   const GLint   mtlAmbientHandle;
@@ -42,46 +139,65 @@ struct Shader {
   const GLint            vertLoc;
   const GLint            normLoc;
   const GLint         textureLoc;
+  const GLint        materialLoc;
+  // The first of the four locations of an instance's model matrix
+  const GLint        instanceLoc;
+
+  // UNIFORM REGISTRY
+  //   Every other active uniform, shared between copies
+  const std::shared_ptr<const UniformRegistry> Uniforms;
 
   // Try to load all uniform handles
   //   Will print to stderr when handles are not found
   //     in debugging mode
-  Shader(const std::string &vert_path, const std::string &frag_path, const bool is_debug) :
-    Id(LoadShaders(vert_path.c_str(), frag_path.c_str())),
+  //   @param backend, the backend the program is loaded and queried through
+  //   @param defines, the #define lines of the variant to compile, see LoadShaders
+  Shader(RenderBackend * backend, const std::string &vert_path, const std::string &frag_path,
+      const bool is_debug, const std::string &defines = "") :
+    Id(backend->LoadProgram(vert_path.c_str(), frag_path.c_str(), defines.c_str(), is_debug)),
     // GET UNIFORMS
     // Matrices
-    projHandle(         glGetUniformLocation(Id, "projection_matrix")),
-    mvpHandle(          glGetUniformLocation(Id, "mvp_matrix")),
-    mvHandle(           glGetUniformLocation(Id, "modelview_matrix")),
-    normHandle(         glGetUniformLocation(Id, "normal_matrix")),
-    texMapHandle(       glGetUniformLocation(Id, "texMap")),
-    shadowMapHandle(    glGetUniformLocation(Id, "shadowMap")),
-    depthBiasMvpHandle( glGetUniformLocation(Id, "depth_bias_mvp_matrix")),
-    depthMvpHandle(     glGetUniformLocation(Id, "depth_mvp_matrix")),
+    mvpHandle(          backend->GetUniformLocation(Id, "mvp_matrix")),
+    mvHandle(           backend->GetUniformLocation(Id, "modelview_matrix")),
+    normHandle(         backend->GetUniformLocation(Id, "normal_matrix")),
+    texMapHandle(       backend->GetUniformLocation(Id, "texMap")),
+    texArrayHandle(     backend->GetUniformLocation(Id, "texArray")),
+    texLayerHandle(     backend->GetUniformLocation(Id, "texLayer")),
+    shadowMapHandle(    backend->GetUniformLocation(Id, "shadowMap")),
+    depthMvpHandle(     backend->GetUniformLocation(Id, "depth_mvp_matrix")),
     // Lighting
-    mtlAmbientHandle(   glGetUniformLocation(Id, "mtl_ambient")),
-    mtlDiffuseHandle(   glGetUniformLocation(Id, "mtl_diffuse")),
-    mtlSpecularHandle(  glGetUniformLocation(Id, "mtl_specular")),
-    shininessHandle(    glGetUniformLocation(Id, "shininess")),
+    mtlAmbientHandle(   backend->GetUniformLocation(Id, "mtl_ambient")),
+    mtlDiffuseHandle(   backend->GetUniformLocation(Id, "mtl_diffuse")),
+    mtlSpecularHandle(  backend->GetUniformLocation(Id, "mtl_specular")),
+    shininessHandle(    backend->GetUniformLocation(Id, "shininess")),
     // Transparency
-    dissolveHandle(     glGetUniformLocation(Id, "dissolve")),
+    dissolveHandle(     backend->GetUniformLocation(Id, "dissolve")),
     // Water
-    camPosHandle(       glGetUniformLocation(Id, "cameraPos")),
+    camPosHandle(       backend->GetUniformLocation(Id, "cameraPos")),
     // GET ATTRIB LOCATIONS
-    vertLoc(      glGetAttribLocation(Id, "a_vertex")),
-    normLoc(      glGetAttribLocation(Id, "a_normal")),
-    textureLoc(   glGetAttribLocation(Id, "a_texture"))
+    vertLoc(      backend->GetAttribLocation(Id, "a_vertex")),
+    normLoc(      backend->GetAttribLocation(Id, "a_normal")),
+    textureLoc(   backend->GetAttribLocation(Id, "a_texture")),
+    materialLoc(  backend->GetAttribLocation(Id, "a_material")),
+    instanceLoc(  backend->GetAttribLocation(Id, "a_instance_model")),
+    // UNIFORM REGISTRY
+    Uniforms(std::make_shared<UniformRegistry>(backend, Id, vert_path.substr(vert_path.find_last_of('/') + 1)))
   {
+    // Shared uniform blocks, see UniformBlockBinding
+    BindBlock(backend, Id, "FrameConstants", kFrameBlockBinding);
+    BindBlock(backend, Id, "Lights",         kLightsBlockBinding);
+    BindBlock(backend, Id, "Materials",      kMaterialsBlockBinding);
+
     if (is_debug) {
       const std::string file_string = vert_path.substr(vert_path.find_last_of('/') + 1);
       const char *      file        = file_string.c_str();
-      CheckHandle(projHandle,         "projHandle",         file);
       CheckHandle(mvpHandle,          "mvpHandle",          file);
       CheckHandle(mvHandle,           "mvHandle",           file);
       CheckHandle(normHandle,         "normHandle",         file);
       CheckHandle(texMapHandle,       "texMapHandle",       file);
+      CheckHandle(texArrayHandle,     "texArrayHandle",     file);
+      CheckHandle(texLayerHandle,     "texLayerHandle",     file);
       CheckHandle(shadowMapHandle,    "shadowMapHandle",    file);
-      CheckHandle(depthBiasMvpHandle, "depthBiasMvpHandle", file);
       CheckHandle(depthMvpHandle,     "depthMvpHandle",     file);
       CheckHandle(mtlAmbientHandle,   "mtlAmbientHandle",   file);
       CheckHandle(mtlDiffuseHandle,   "mtlDiffuseHandle",   file);
@@ -92,10 +208,29 @@ struct Shader {
       CheckAttrib(vertLoc,            "vertLoc",            file);
       CheckAttrib(normLoc,            "normLoc",            file);
       CheckAttrib(textureLoc,         "textureLoc",         file);
+      CheckAttrib(materialLoc,        "materialLoc",        file);
+      CheckAttrib(instanceLoc,        "instanceLoc",        file);
       printf("\n"); // Make spacing only in stdout
     }
   }
 
+  // The location of a uniform from the registry
+  //   @param hash, the UniformHash of the name, see UNIFORM
+  //   @param name, the name, only used for the warning
+  //   @return  The location, -1 if the uniform is not active (warns once)
+  GLint Uniform(const unsigned int hash, const char * name) const {
+    return Uniforms->Location(hash, name);
+  }
+
+  // Binds the named uniform block of the program to a binding point
+  //   Programs without the block are left alone
+  static void BindBlock(RenderBackend * backend, const GLuint program, const char * block_name,
+      const UniformBlockBinding binding) {
+    const GLuint index = backend->GetUniformBlockIndex(program, block_name);
+    if (index != GL_INVALID_INDEX)
+      backend->UniformBlockBinding(program, index, binding);
+  }
+
   // Checks for validity of handle and prints to stderr or to stdout appropriately
   static void CheckHandle(const GLint handle, const char * handle_name, const char * file) {
     if (handle == -1)
@@ -113,6 +248,26 @@ struct Shader {
   }
 };
 
+// The flags of a variant of shaded.vert/frag
+//   Each is a #define compiled into its own program, rather than a uniform
+//   the shaders branch on per vertex or fragment
+enum ShadedVariant {
+  // INSTANCED, a_instance_model places the vertex
+  kShadedInstanced = 1,
+  // BUMPED and TEXTURE_ARRAY, the cliffs' bump maps and tile texture array
+  kShadedTerrain   = 2,
+  // SHADOWS, the fragment samples the shadow map cascades
+  kShadedShadows   = 4,
+  // POINT_LIGHTS and SPOT_LIGHTS, the light loops have a constant count
+  kShadedCarLights = 8,
+};
+// The amount of shaded variants, one per combination of flags
+const unsigned int kShadedVariants = 16;
+// The lights of the kShadedCarLights variants, the car's brake and head lights
+//   Frames with other counts use the variants looping to the Lights block's
+const unsigned int kCarPointLights = 2;
+const unsigned int kCarSpotLights  = 2;
+
 // A Shaders class
 //   Holds all shaders required for the program
 //   @warn only one instance should ever be created
@@ -125,16 +280,21 @@ struct Shaders {
   const Shader SkyboxGeneric;
   const Shader RainGeneric;
   const Shader DepthBuffer;
+  // The variants of LightMappedGeneric, indexed by ShadedVariant flags
+  //   The flagless variant is LightMappedGeneric itself, instanced terrain
+  //   isn't drawn so is NULL
+  const Shader  * Shaded[kShadedVariants];
 
   // Load in all the shaders
+  //   @param backend, the backend the programs are loaded through
   //   @param is_debug, true = load axis shader
-  Shaders(const bool is_debug = false) :
-    AxisDebug(is_debug ? new Shader("shaders/coord.vert", "shaders/coord.frag", is_debug) : 0 ),
-    LightMappedGeneric( Shader("shaders/shaded.vert", "shaders/shaded.frag", is_debug)),
-    WaterGeneric(       Shader("shaders/water.vert", "shaders/water.frag", is_debug)),
-    SkyboxGeneric(      Shader("shaders/sky.vert", "shaders/sky.frag", is_debug)),
-    RainGeneric(        Shader("shaders/rain.vert", "shaders/rain.frag", is_debug)),
-    DepthBuffer(        Shader("shaders/depthbuffer.vert", "shaders/depthbuffer.frag", is_debug))
+  Shaders(RenderBackend * backend, const bool is_debug = false) :
+    AxisDebug(is_debug ? new Shader(backend, "shaders/coord.vert", "shaders/coord.frag", is_debug) : 0 ),
+    LightMappedGeneric( backend, "shaders/shaded.vert", "shaders/shaded.frag", is_debug),
+    WaterGeneric(       backend, "shaders/water.vert", "shaders/water.frag", is_debug),
+    SkyboxGeneric(      backend, "shaders/sky.vert", "shaders/sky.frag", is_debug),
+    RainGeneric(        backend, "shaders/rain.vert", "shaders/rain.frag", is_debug),
+    DepthBuffer(        backend, "shaders/depthbuffer.vert", "shaders/depthbuffer.frag", is_debug)
     {
       if (is_debug)
         assert(AxisDebug->Id       && "Axis Shader failed to load");
@@ -143,131 +303,60 @@ struct Shaders {
       assert(SkyboxGeneric.Id      && "SkyboxGeneric Shader failed to load");
       assert(RainGeneric.Id        && "RainGeneric Shader failed to load");
       assert(DepthBuffer.Id        && "DepthBuffer Shader failed to load");
-    }
 
-};
-
-
-// An iterator for the Shaders struct
-//   The depthbuffer shader is at iter.end() but should be
-//   hence is excluded from std begin->end looping
-//   Helpful for updating all projections
-//   @warn iterating past end() (or before begin) is undefined
-//         behaviour and will eventually overflow to beginning
-//   @warn hard coded
-struct ShadersProjectionIterator {
-  typedef ShadersProjectionIterator const_iterator;
-  // BASE CONSTRUCTOR
-  ShadersProjectionIterator(const Shaders * shaders) :
-    shaders_(shaders) {};
+      Shaded[0] = &LightMappedGeneric;
+      for (unsigned int x = 1; x < kShadedVariants; ++x) {
+        if ((x & kShadedInstanced) && (x & kShadedTerrain)) {
+          Shaded[x] = 0;
+          continue;
+        }
+        Shaded[x] = new Shader(backend, "shaders/shaded.vert", "shaders/shaded.frag", is_debug, ShadedDefines(x));
+        assert(Shaded[x]->Id         && "Shaded variant failed to load");
+      }
+      // Every variant samples the same units, set once
+      for (unsigned int x = 0; x < kShadedVariants; ++x) {
+        if (!Shaded[x])
+          continue;
+        backend->UseProgram(Shaded[x]->Id);
+        backend->Uniform1i(Shaded[x]->texMapHandle, 0);
+        if (x & kShadedTerrain) {
+          backend->Uniform1i(UNIFORM(*Shaded[x], "normMap"), 1);
+          backend->Uniform1i(UNIFORM(*Shaded[x], "mossMap"), 2);
+        }
+        backend->Uniform1i(Shaded[x]->texArrayHandle, 3);
+        backend->Uniform1i(Shaded[x]->shadowMapHandle, 20);
+      }
+      backend->UseProgram(0);
+    }
 
-  // ITERATOR OVERLOADED CONSTRUCTOR
-  ShadersProjectionIterator(const Shaders * shaders, const Shader * shader, const char index) :
-    shaders_(shaders), shader_iter_(shader), index_(index) {};
+  // Owns the axis shader and shaded variants, copies would free them twice
+  Shaders(const Shaders&) = delete;
+  Shaders& operator=(const Shaders&) = delete;
 
-  // ITERATORS
-  // begin(), An iterator referring to AxisDebug or LightMappedGeneric, i.e. the first element
-  //          depends on whether debugging is enabled or not.
-  //   @warn undefined behaviour when iterating past end (or before begin)
-  const_iterator begin() const {
-    const_iterator temp(
-        this->shaders_,
-        this->shaders_->AxisDebug ? this->shaders_->AxisDebug : &(this->shaders_->LightMappedGeneric),
-        this->shaders_->AxisDebug ? 0 : 1);
-    return temp;
+  // Frees the axis shader and shaded variants
+  ~Shaders() {
+    delete AxisDebug;
+    for (unsigned int x = 1; x < kShadedVariants; ++x)
+      delete Shaded[x];
   }
-  // end(), An iterator referring to DepthBuffer, i.e. past-the-end (relevant-to-proj) element
-  //   @warn undefined behaviour when iterating past end (or before begin)
-  //   @warn will return axis debug if iterated past begin
-  const_iterator end()   const {
-    const_iterator temp(
-        this->shaders_,
-        &(this->shaders_->DepthBuffer),
-        5);
-    return temp;
-  }
-  // Dereference
-  const Shader * operator * () { return shader_iter_; };
-  const Shader * operator -> () { return (operator * ()); };
-  // Mutators
-  const_iterator &operator ++ () {
-    switch (index_) {
-      case 0:
-        shader_iter_ = &(shaders_->LightMappedGeneric);
-        break;
-      case 1:
-        shader_iter_ = &(shaders_->WaterGeneric);
-        break;
-      case 2:
-        shader_iter_ = &(shaders_->SkyboxGeneric);
-        break;
-      case 3:
-        shader_iter_ = &(shaders_->RainGeneric);
-        break;
-      case 4:
-        shader_iter_ = &(shaders_->DepthBuffer); // End of iterator
-        break;
-    }
-    ++index_;
-    return *this;
-  };
 
-  const_iterator operator ++ (int) {
-    const_iterator temp(*this);
-    ++(*this);
-    return temp;
-  };
-
-  const_iterator &operator -- () {
-    switch (index_) {
-      --index_;
-      case 0:
-      shader_iter_ = shaders_->AxisDebug;
-      case 1:
-      shader_iter_ = &(shaders_->LightMappedGeneric);
-      break;
-      case 2:
-      shader_iter_ = &(shaders_->WaterGeneric);
-      break;
-      case 3:
-      shader_iter_ = &(shaders_->SkyboxGeneric);
-      break;
-      case 4:
-      shader_iter_ = &(shaders_->RainGeneric);
-      break;
-      case 5:
-      shader_iter_ = &(shaders_->DepthBuffer); // End of iterator
-      break;
+  // The #define lines of a shaded variant
+  //   @param flags, the ShadedVariant flags
+  //   @return  The lines, see LoadShaders
+  static std::string ShadedDefines(const unsigned int flags) {
+    std::string defines;
+    if (flags & kShadedInstanced)
+      defines += "#define INSTANCED\n";
+    if (flags & kShadedTerrain)
+      defines += "#define BUMPED\n#define TEXTURE_ARRAY\n";
+    if (flags & kShadedShadows)
+      defines += "#define SHADOWS\n";
+    if (flags & kShadedCarLights) {
+      defines += "#define POINT_LIGHTS " + std::to_string(kCarPointLights) + "\n";
+      defines += "#define SPOT_LIGHTS " + std::to_string(kCarSpotLights) + "\n";
     }
-    return *this;
-  };
-
-  const_iterator operator -- (int) {
-    const_iterator temp(*this);
-    --(*this);
-    return temp;
-  };
-
-  bool operator == (const const_iterator &other) const {
-    return index_ == other.index_ &&
-      shader_iter_ == other.shader_iter_ &&
-      shaders_ == other.shaders_;
-  }
-  bool operator != (const const_iterator &other) const {
-    return index_ != other.index_ ||
-      shader_iter_ != other.shader_iter_ ||
-      shaders_ != other.shaders_;
+    return defines;
   }
-
-  private:
-  // The shaders object for next pointer
-  const Shaders * shaders_;
-  // The current shader object pointed to
-  const Shader * shader_iter_;
-  // The current index of the iterator
-  //   Corresponds to the order of members
-  //   in Shaders struct
-  char index_;
 };
 
 #endif
@@ -10,6 +10,7 @@ out vec3 texCoords;
 void main(void) {
 	
 	texCoords = a_vertex;
-	gl_Position = mvp_matrix * vec4(a_vertex, 1.0);
+	// On the far plane (w/w = 1) so it is drawn behind everything
+	gl_Position = (mvp_matrix * vec4(a_vertex, 1.0)).xyww;
 
 }
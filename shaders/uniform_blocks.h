@@ -0,0 +1,102 @@
+#ifndef ASSIGN3_UNIFORM_BLOCKS_H_
+#define ASSIGN3_UNIFORM_BLOCKS_H_
+
+#include <GL/glew.h>
+#include "../glm/glm.hpp"
+
+// The uniform block binding points shared by all shaders
+//   Shader binds its blocks to these after link, the owners of the
+//   buffers bind them once per frame
+enum UniformBlockBinding {
+  kFrameBlockBinding = 0,
+  kLightsBlockBinding = 1,
+  kMaterialsBlockBinding = 2,
+};
+
+// The maximum amount of point and spot lights in the Lights block
+//   @warn must match MAX_POINT_LIGHTS and MAX_SPOT_LIGHTS in the shaders
+const unsigned int kMaxLights = 10;
+// The amount of cascades the shadow map is split into
+//   @warn must match SHADOW_CASCADES in the shaders, at most 4 (shadow_splits)
+const unsigned int kShadowCascades = 3;
+// The maximum amount of materials in a Materials block
+//   64 MaterialBlocks are 3KB, well under the 16KB every uniform block may use
+//   @warn must match MAX_MATERIALS in the shaders
+const unsigned int kMaxMaterials = 64;
+
+// std140 mirror of the FrameConstants block
+//   Owned by the Renderer, updated once per frame
+//   @warn member order and padding must match the shaders
+struct FrameBlock {
+  glm::mat4 view_matrix;                        // offset 0
+  glm::mat4 projection_matrix;                  // offset 64
+  glm::mat4 shadow_matrices[kShadowCascades];   // offset 128, world to shadow texture space
+  glm::vec4 shadow_splits;                      // offset 320, the view depth each cascade ends at
+  glm::vec4 sun_direction;                      // offset 336, w unused
+  GLfloat time;                                 // offset 352, in milliseconds
+  GLfloat padding[3];
+};
+static_assert(kShadowCascades <= 4, "shadow_splits holds at most 4 cascades");
+static_assert(sizeof(FrameBlock) == 368, "FrameBlock does not match std140");
+
+// std140 mirrors of the light structs in the shaders
+//   Every vec3 takes 16 bytes unless a float follows it
+struct BaseLightBlock {
+  glm::vec3 AmbientIntensity;       // offset 0
+  GLfloat padding0;
+  glm::vec3 DiffuseIntensity;       // offset 16
+  GLfloat padding1;
+  glm::vec3 SpecularIntensity;      // offset 32
+  GLfloat padding2;
+};
+struct DirectionalLightBlock {
+  BaseLightBlock Base;              // offset 0
+  glm::vec3 Direction;              // offset 48
+  GLfloat padding;
+};
+struct PointLightBlock {
+  BaseLightBlock Base;              // offset 0
+  glm::vec3 Position;               // offset 48
+  GLfloat padding0;
+  GLfloat AttenConstant;            // offset 64, Atten is a struct hence aligned to 16
+  GLfloat AttenLinear;              // offset 68
+  GLfloat AttenExp;                 // offset 72
+  GLfloat padding1;
+};
+struct SpotLightBlock {
+  PointLightBlock Base;             // offset 0
+  glm::vec3 Direction;              // offset 80
+  GLfloat CosineCutoff;             // offset 92
+};
+
+// std140 mirror of the Lights block
+//   Owned by the LightController, updated once per tick
+//   @warn member order and padding must match the shaders
+struct LightsBlock {
+  DirectionalLightBlock DirectionalLight;     // offset 0
+  PointLightBlock PointLights[kMaxLights];    // offset 64
+  SpotLightBlock SpotLights[kMaxLights];      // offset 864
+  GLint NumPointLights;                       // offset 1824
+  GLint NumSpotLights;                        // offset 1828
+  GLint padding[2];
+};
+static_assert(sizeof(DirectionalLightBlock) == 64, "DirectionalLightBlock does not match std140");
+static_assert(sizeof(PointLightBlock) == 80, "PointLightBlock does not match std140");
+static_assert(sizeof(SpotLightBlock) == 96, "SpotLightBlock does not match std140");
+static_assert(sizeof(LightsBlock) == 1840, "LightsBlock does not match std140");
+
+// std140 mirror of the Material struct in the shaders
+//   A Materials block is kMaxMaterials of these, owned by each model (and
+//   the terrain) and bound with its draws. Vertices pick theirs by a_material
+//   @warn member order and padding must match the shaders
+struct MaterialBlock {
+  glm::vec3 ambient;                // offset 0
+  GLfloat dissolve;                 // offset 12
+  glm::vec3 diffuse;                // offset 16
+  GLfloat shininess;                // offset 28
+  glm::vec3 specular;               // offset 32
+  GLfloat layer;                    // offset 44, of texMap, see TextureArrays
+};
+static_assert(sizeof(MaterialBlock) == 48, "MaterialBlock does not match std140");
+
+#endif
@@ -1,4 +1,5 @@
 #version 130
+#extension GL_ARB_uniform_buffer_object : require
 
 struct BaseLight
 {
@@ -37,12 +38,16 @@ struct SpotLight
 const int MAX_POINT_LIGHTS = 10;
 const int MAX_SPOT_LIGHTS = 10;
 
-// Light properties
-uniform int gNumPointLights;
-uniform int gNumSpotLights;
-uniform DirectionalLight gDirectionalLight;
-uniform PointLight gPointLights[MAX_POINT_LIGHTS];
-uniform SpotLight gSpotLights[MAX_SPOT_LIGHTS];
+// Light properties, shared by all lit shaders
+//   @warn must match LightsBlock in uniform_blocks.h
+layout(std140) uniform Lights
+{
+  DirectionalLight gDirectionalLight;
+  PointLight gPointLights[MAX_POINT_LIGHTS];
+  SpotLight gSpotLights[MAX_SPOT_LIGHTS];
+  int gNumPointLights;
+  int gNumSpotLights;
+};
 
 // Material properties
 uniform vec3 mtl_ambient;
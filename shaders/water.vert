@@ -1,9 +1,25 @@
 #version 130
+#extension GL_ARB_uniform_buffer_object : require
 
-uniform mat4 projection_matrix;
 uniform mat4 modelview_matrix;
 uniform mat3 normal_matrix;
 
+// The amount of shadow cascades
+//   @warn must match kShadowCascades in uniform_blocks.h
+const int SHADOW_CASCADES = 3;
+
+// Per frame constants, shared by all shaders
+//   @warn must match FrameBlock in uniform_blocks.h
+layout(std140) uniform FrameConstants
+{
+  mat4 view_matrix;
+  mat4 projection_matrix;
+  mat4 shadow_matrices[SHADOW_CASCADES];
+  vec4 shadow_splits;
+  vec4 sun_direction;
+  float time;
+};
+
 in vec3 a_vertex;
 out vec4 a_vertex_mv;
 out vec3 a_normal_mv;
@@ -15,7 +31,6 @@ out vec3 a_normal_mv;
 
 const float pi = 3.14159;
 uniform float waterHeight;
-uniform float time;
 uniform float numWaves;
 uniform float amplitude[20];
 uniform float wavelength[20];
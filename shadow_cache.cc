@@ -0,0 +1,40 @@
+#include "shadow_cache.h"
+
+// Construct with an empty layer
+//   @param backend, the backend the layer is created through
+ShadowCache::ShadowCache(RenderBackend * backend) :
+  layer_(backend),
+  is_valid_(false), tile_version_(0),
+  light_direction_(glm::vec3(0,-1,0)) {
+    Invalidate();
+  }
+
+// Decides which cascades must be rendered again this frame
+//   Every cascade is outdated if a tile was added or removed or the light
+//   turned more than kMaxLightAngle, otherwise only those which moved
+//   @param frame, the frame about to be drawn
+//   @param tile_version, the version of the terrain's loaded tiles
+void ShadowCache::Update(FrameContext * frame, const unsigned int tile_version) {
+  const bool is_turned = !is_valid_ ||
+    glm::dot(frame->light_direction, light_direction_) < cos(kMaxLightAngle);
+  if (is_turned)
+    light_direction_ = frame->light_direction;
+  else
+    frame->SetLight(light_direction_);
+  const bool is_all_outdated = is_turned || tile_version != tile_version_;
+
+  for (unsigned int x = 0; x < kShadowCascades; ++x) {
+    const glm::mat4 &view_projection = frame->cascades[x].view_projection;
+    is_outdated_[x] = is_all_outdated || view_projection != view_projections_[x];
+    view_projections_[x] = view_projection;
+  }
+  is_valid_ = true;
+  tile_version_ = tile_version;
+}
+
+// Marks every cascade outdated
+void ShadowCache::Invalidate() {
+  is_valid_ = false;
+  for (unsigned int x = 0; x < kShadowCascades; ++x)
+    is_outdated_[x] = true;
+}
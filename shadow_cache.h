@@ -0,0 +1,68 @@
+#ifndef ASSIGN3_SHADOW_CACHE_H_
+#define ASSIGN3_SHADOW_CACHE_H_
+
+#include <cmath>
+#include "frame_context.h"
+#include "renderer.h"
+
+#include "glm/glm.hpp"
+#include <GL/glew.h>
+
+// The depth of the terrain kept between frames
+//   The terrain never moves, so its depth is only rendered into a cascade of
+//   the cached layer when a tile is added or removed, the sun has turned or
+//   the cascade has moved. Every frame the layer is copied into the shadow
+//   map and only the dynamic objects are drawn on top of it
+//   While the layer is kept the frame keeps the light it was rendered with,
+//   so the casters and receivers always agree on the shadow matrices
+class ShadowCache {
+  public:
+    // Construct with an empty layer
+    //   @param backend, the backend the layer is created through
+    explicit ShadowCache(RenderBackend * backend);
+
+    // Decides which cascades must be rendered again this frame
+    //   Replaces the light of the frame with that of the layer unless it
+    //   has turned too far
+    //   @param frame, the frame about to be drawn
+    //   @param tile_version, the version of the terrain's loaded tiles
+    void Update(FrameContext * frame, const unsigned int tile_version);
+    // Marks every cascade outdated, e.g. while no shadows are drawn at night
+    void Invalidate();
+
+    // Whether a cascade must be rendered again this frame
+    inline bool is_outdated(const unsigned int cascade) const;
+    // Accessor for the FBOs holding the layer
+    inline const FrameBufferObject * layer() const;
+
+  private:
+    // The angle (radians) the light may turn before the layer is outdated
+    //   About 1 degree, the shadows lag the sun by at most that much
+    const float kMaxLightAngle = 0.0175f;
+
+    // The FBOs and depth texture array of the layer
+    //   Same size and format as the shadow map so it can be blitted
+    const FrameBufferObject layer_;
+    // Whether the layer holds the terrain's depth
+    bool is_valid_;
+    // The tile version the layer was rendered with
+    unsigned int tile_version_;
+    // The light the layer was rendered with
+    glm::vec3 light_direction_;
+    // The matrix every cascade was rendered with
+    //   They only change when a cascade moves by a snap step
+    glm::mat4 view_projections_[kShadowCascades];
+    // Whether a cascade must be rendered again this frame
+    bool is_outdated_[kShadowCascades];
+};
+
+// Whether a cascade must be rendered again this frame
+inline bool ShadowCache::is_outdated(const unsigned int cascade) const {
+  return is_outdated_[cascade];
+}
+// Accessor for the FBOs holding the layer
+inline const FrameBufferObject * ShadowCache::layer() const {
+  return &layer_;
+}
+
+#endif
@@ -12,10 +12,16 @@
 #include "model_data.h"
 #include "model.h"
 #include "camera.h"
+#include "horizon.h"
+#include "texture_streamer.h"
+#include "texture_arrays.h"
+#include "tile_generator.h"
+#include "scatter.h"
 
 #include "glm/glm.hpp"
 #include <GL/glew.h>
 #include "shaders/shaders.h"
+#include "shaders/uniform_blocks.h"
 #include "glm/gtc/matrix_transform.hpp"
 #include "glm/gtc/type_ptr.hpp"
 
@@ -38,39 +44,77 @@ class Terrain {
     typedef std::vector<glm::vec3> anim_vec;
     typedef circular_vector<anim_vec> anim_container;
     // Constants
-    enum RoadType {
-      kStraight = 0,
-      kTurnLeft = 1,
-      kTurnRight = 2,
+    //   The turn types are shared with the tile generator
+    typedef TileGenerator::RoadType RoadType;
+
+    // The render facing state of a loaded tile
+    //   Small and POD so the renderer walks one compact array
+    struct TileDescriptor {
+      // The terrain and road VAOs
+      //   The road VAO is 0 until the tick after the terrain VAO
+      GLuint terrain_vao;
+      GLuint road_vao;
+      // The amount of adaptive indices in the terrain VAO
+      unsigned int terrain_indice_count;
+      // The position only VAO drawn into the shadow map
+      //   Its indices also cover the hole under the road, see TileGenerator::MakeAdaptiveIndices
+      GLuint depth_vao;
+      unsigned int depth_indice_count;
+      // The turn type of the tile
+      RoadType turn;
+      // The material (texture array) of the tile
+      unsigned char material;
+      // The bounding box of the terrain vertices
+      glm::vec3 aabb_min;
+      glm::vec3 aabb_max;
+      // The serial of the tile, counting every tile ever generated
+      unsigned int serial;
+      // The instance buffer of the tile's props, see ScatterWorker
+      //   0 until the worker has placed them
+      GLuint scatter_buffer;
+      // The run of each ScatterKind in scatter_buffer
+      unsigned int scatter_first[kScatterKinds];
+      unsigned int scatter_count[kScatterKinds];
     };
 
     // TODO remove from public
     GLuint cliff_nrm_texture_;
 
     // Construct with width and height specified
-    Terrain(const Shader &shader, const int width = 96, const int height = 96);
+    //   @param depth_shader, the shader the tiles are drawn into the shadow map with
+    //   @param backend, the backend the tile buffers and cliff materials go through
+    //   @param textures, the arrays the road and bump textures are loaded into
+    Terrain(const Shader &shader, const Shader &depth_shader, RenderBackend * backend,
+        TextureArrays * textures, const int width = 96, const int height = 96);
 
     // Accessor for the program id (shader)
-    inline const Shader shader() const;
-    // A container filled with tiled terrain VAOs in proceeding order
-    inline const circular_vector<GLuint> * terrain_vao_handle() const;
-    // A container filled with tiled road VAOs in proceeding order
-    inline const circular_vector<GLuint> * road_vao_handle() const;
-    // The GL generated road texture used for binding
-    inline GLuint road_texture() const;
-
-    inline GLuint cliff_bump() const;
-
-    inline GLuint road_bump() const;
-    // Accessor for the loaded texture
-    //   @warn requires a texture to be loaded with LoadTexture()
-    inline GLuint texture() const;
+    inline const Shader &shader() const;
+    // A container filled with the loaded tiles in proceeding order
+    inline const circular_vector<TileDescriptor> * tiles() const;
+    // The low resolution strip continuing past the last tile
+    inline const Horizon * horizon() const;
+    // Accessor for the version of the loaded tiles
+    //   Changes whenever a terrain or road VAO is added or removed,
+    //   e.g. to know when the cached terrain shadows are outdated
+    inline unsigned int tile_version() const;
+    // The road texture used for binding, its layer is in the material block
+    inline const TextureLayer &road_texture() const;
+    // The cliff normal map
+    inline const TextureLayer &cliff_bump() const;
+    // The moss mixed into the cliffs
+    inline const TextureLayer &road_bump() const;
+    // Accessor for the uniform buffer of the terrain's Materials block
+    //   The terrain's vertices have no a_material so they all use slot 0
+    inline GLuint material_block() const;
+    // Accessor for the streamed cliff materials
+    //   Holds the texture array sampled by the terrain tiles
+    inline const TextureStreamer * texture_streamer() const;
     // Accessor for the width (Amount of Grid boxes width-wise)
     inline int width() const;
     // Accessor for the height (Amount of Grid boxes height-wise)
     inline int height() const;
-    // Accessor for the amount of indices
-    //   Used in render to efficiently draw triangles
+    // Accessor for the amount of indices in an unsimplified tile
+    //   Used as the baseline for the adaptive triangle counts
     inline int indice_count() const;
     // Accessor for the amount of indices
     //   Used in render to efficiently draw triangles
@@ -115,61 +159,53 @@ class Terrain {
     //   @warn this requires a square heightmap
     //   @warn dimensions should be multiples of 32
     const char length_multiplier_;
-    // The maximum number of randomizing height generation iterations
-    const int kRandomIterations;
+    // The seed used for the terrain generation
+    //   Shared with the horizon so it follows the same world
+    const unsigned int seed_;
+    // The backend the tile buffers are created and streamed through
+    //   @warn declared before the UV and indice VBOs which are created through it
+    RenderBackend * const backend_;
+
+    // TILE CONSTANTS
+    // The road and terrain UV and Indice VBOs
+    //   These dont change throughout life of terrain
+    //   These are used in CreateVAO to optimize
+    const std::pair<GLuint, GLuint> terrain_vbo_uv_indices_;
+    const std::pair<GLuint, GLuint> road_vbo_uv_indices_;
+    // Normals to be generated for all the road tiles
+    //   These should only be generated once as x_lengths and z_lengths are the
+    //   same between tiles.and the normals always point upwards (road is flat)
+    std::vector<glm::vec3> normals_road_;
 
     // RENDER DATA
-    // The amount of ticks generated so far
-    //   Used to spread iterations over multiple ticks
-    //   Spread over $kGenerationTicks ticks
-    signed char generated_ticks_;
-    // The x and y positions of the height randomization for the (left) cliff part
-    int x_cliff_position_;
-    int z_cliff_position_;
-    // The x and y positions of the height randomization for the (right) water part
-    int x_water_position_;
-    int z_water_position_;
-    // The previous random value used to calculate next turn type
-    //   Next turn rand is generated in proceedTiles
-    char prev_rand_;
-    // The previous random value used to generate the cliff and water (X^3 i.e. cubic) base heights
-    //   Used to ensure there are no sudden peaks and for extra feel
-    char prev_cliff_x3_rand_;
-    char prev_water_x3_rand_;
-    // The previous random value used to generate next spacing of tile
-    float prev_spacing_rand_;
+    //   Read every frame, kept together and away from the generation state
+    // The loaded tiles in proceeding order
+    circular_vector<TileDescriptor> tiles_;
+    // Incremented whenever a terrain or road VAO is added or removed
+    unsigned int tile_version_;
     // The shader to use to render heightmap
     //   Road uses the same shader
     const Shader shader_;
-    // The texture to be used to Wrap Terrain
-    GLuint texture_;
+    // The shader the tiles are drawn into the shadow map with
+    //   Only its vertex location is needed for the depth VAOs
+    const Shader depth_shader_;
+    // The cliff materials which can be used to Wrap Terrain
+    //   Materials are streamed in as tiles start generating
+    TextureStreamer texture_streamer_;
     // The bumpmap texture for the cliff
-    GLuint cliff_bump_;
+    TextureLayer cliff_bump_;
     // The bumpmap texture for the road
-    GLuint road_bump_;
+    TextureLayer road_bump_;
     // The texture to be used for the road
-    GLuint road_texture_;
-    // The VAO handle for the terrain and roads
-    circular_vector<GLuint> terrain_vao_handle_;
-    circular_vector<GLuint> road_vao_handle_;
-    // The terrain and road VBOs assosicated with each VAO for deleting
-    //   Each pair represents Vertices and Normals
-    // @note  UV and Indices never change hence dont require delete
-    circular_vector<std::pair<GLuint, GLuint> > terrain_vbo_handle_;
-    circular_vector<std::pair<GLuint, GLuint> > road_vbo_handle_;
-    // The road and terrain UV and Indice VBOs
-    //   These dont change throughout life of terrain
-    //   These are used in CreateVAO to optimize
-    const std::pair<GLuint, GLuint> terrain_vbo_uv_indices_;
-    const std::pair<GLuint, GLuint> road_vbo_uv_indices_;
-    // The indices generated for all the tiles
-    //   These should only be generated once as x_lengths and z_lengths are the
-    //   same between tiles.
-    const std::vector<int> indices_;
-    const std::vector<int> indices_road_;
-    // The amount of indices, used to render terrain efficiently
-    const unsigned int indice_count_;
-    const unsigned int road_indice_count_;
+    TextureLayer road_texture_;
+    // The uniform buffer of the Materials block, see material_block
+    GLuint material_block_;
+    // The low resolution strip continuing past the last tile
+    //   Updated whenever a terrain VAO is pushed back
+    Horizon horizon_;
+
+    // COLLISION DATA
+    //   Read every frame
     // A circular_vector representing each road tile for collision checking
     //   The first (0th) index is the current tile the car is on (or not - check index 1)
     //     pair.first = min_x, pair.second = max_x
@@ -178,43 +214,36 @@ class Terrain {
     circular_vector<std::vector<glm::vec3> > colisn_lst_water_;
     // The collisions for the left (cliff) side
     circular_vector<std::vector<glm::vec3> > colisn_lst_cliff_;
-
     // Road Sign Vars
+    //   Unlike tiles_ this is indexed the same as the collision data
     circular_vector<RoadType> tile_turn_;
 
-    // GENERATE TERRAIN VARS
-    // Vertices to be generated for next terrain (or water) tile
-    std::vector<glm::vec3> vertices_;
-    // Normals to be generated for the next terrain (or water) tile
-    std::vector<glm::vec3> normals_;
-    // This vector is used to build heights and smooths previous tile connections
-    std::vector<float> heights_; 
-
-    // The current X,Z displacement from zero
-    //   Used for joining tiles
-    glm::vec2 next_tile_start_;
-    // The previous maximum x vertice
-    //   Used for updating next_tile_start_.x
-    float prev_max_x_;
-
-    // GENERATE ROAD VARS
-    // Vertices to be generated for the next road tile
-    std::vector<glm::vec3> vertices_road_;
-    // Normals to be generated for all the road tiles
-    //   These should only be generated once as x_lengths and z_lengths are the
-    //   same between tiles.and the normals always point upwards (road is flat)
-    std::vector<glm::vec3> normals_road_;
-    // Current road tile end rotation
-    //   The rotation of the entire next tile from positive z
-    //   Positive degrees rotate leftwards (anti cw from spidermans facing)
-    float rotation_;
-    // The above used for UV stretch correction;
-    float prev_rotation_;
-    // The amount of (tile relative) Z rows from the back to smooth
-    //   Is needed to connect rotated rows
-    unsigned int z_smooth_max_;
-    // The last row used for smoothing
-    std::vector<float> temp_last_row_heights_;
+    // GENERATION STATE
+    //   Only touched while generating a tile
+    // The amount of ticks generated so far
+    //   Used to spread iterations over multiple ticks
+    //   Spread over $kGenerationTicks ticks
+    signed char generated_ticks_;
+    // The material of the tile being generated
+    //   Changes every few tiles to give longer stretches of the same rock
+    unsigned char next_material_;
+    // Builds the heights, vertices and collision data of the tiles
+    //   Owns the generation workspace and random engine
+    TileGenerator generator_;
+    // The serial of the next tile pushed, see TileDescriptor::serial
+    unsigned int next_serial_;
+    // Places the props of finished tiles on its own thread
+    ScatterWorker scatter_worker_;
+    // The terrain and road VBOs assosicated with each VAO for deleting
+    //   Each pair represents Vertices and Normals
+    // @note  UV and Indices never change hence dont require delete
+    circular_vector<std::pair<GLuint, GLuint> > terrain_vbo_handle_;
+    circular_vector<std::pair<GLuint, GLuint> > road_vbo_handle_;
+    // The adaptive terrain indice VBO for each tile
+    //   Unlike the UV these change between tiles and require delete
+    circular_vector<GLuint> terrain_vbo_adaptive_indices_;
+    // The depth indice VBO for each tile, see TileDescriptor::depth_vao
+    circular_vector<GLuint> terrain_vbo_depth_indices_;
 
     // Generates a random terrain piece and pushes it back into circular_vector VAO buffer
     //   Starting terrain is generated all at once but flowing terrain generation is spread
@@ -223,14 +252,14 @@ class Terrain {
     void RandomizeGeneration(const bool is_start = false);
     // Generate Terrain tile piece with road
     //   Mutates the input members, (e.g. vertices, indicies etc.) and then
-    //   calls CreateVAO and pushes the result back to the terrain_vao_handle_
+    //   calls CreateVAO and pushes the result back to the tiles_
     //   @param The tile type to generate e.g. kStraight, kTurnLeft etc.
     //   @warn creates and pushes back a road VAO based on the terrain middle section
     //   @warn pushes next road collision map into member queue
     void GenerateStartingTerrain(RoadType road_type);
     // Generate Terrain tile piece with road
     //   Mutates the input members, (e.g. vertices, indicies etc.) and then
-    //   calls CreateVAO and pushes the result back to the terrain_vao_handle_
+    //   calls CreateVAO and pushes the result back to the tiles_
     //   The members are mutated over $kGenerationTicks to spread load
     //   @param The tile type to generate e.g. kStraight, kTurnLeft etc.
     //   @warn creates and pushes back a road VAO based on the terrain middle section
@@ -253,69 +282,13 @@ class Terrain {
     // @warn  for optimzation this should only be called once because road indices and UV don't change
     // @warn  modifies the inputs!
     void InitializeRoadIndicesAndUV(std::vector<int> &indices, std::vector<glm::vec2> &texture_coordinates_uv) const;
-    // Generates the indices to be used by the tile type
-    // @param  The type of tile, Terrain or Road
-    // @note  These don't change for the same x_length_ * z_length_ height maps
-    // @return  A vector of indices for generating vertices
-    std::vector<int> InitializeIndices(const TileType tile_type) const;
-
-    // TERRAIN GENERATION HELPERS
-    // Model the heights using an X^3 mathematical functions, then randomize heights
-    // for all vertices in heightmap
-    //   @param  start  Index to start looping from
-    //   @param  end    Index to finish the loop
-    //   @warn pretty expensive operation 10000*2 loops
-    //   @warn spread over a couple of loops
-    void HelperMakeHeights(int start, const int end);
-    // Smooths the terrain at the connections
-    //   Spreads the load over 2 ticks
-    //   @param bool, whether or not this is the first call
-    //   @warn requires a last row member
-    //   @warn AverageHeights modifies heights_ member
-    void HelperMakeSmoothHeights(const bool is_first_call);
-    // Averages the given member to smooth the terrain
-    //   Has a range for X but runs through the entire Z plane (for splitting water 
-    //   and cliff
-    //   @param start, the start of the heightmap in the X plane
-    //   @param end,   the end of the heightmap in the X plane
-    //   @param vec_t, a reference to a vector which contains heightmap values or vec3 and
-    //             will be modified. Infact any vector type with + and /= element operators
-    //             should work.
-    //   @param vec_other_t, a reference to a vector which contains @vec_t values from the
-    //                       previous tile
-    //   @warn @a vec_t member is modified
-    template<typename T>
-    void AverageVector(const int start, const int end, std::vector<T> &vec_t, const std::vector<T> &vec_other_t);
-    // Overloaded function to generate a square height map on the X/Z plane. Different
-    // road_type parameters can be added to curve the Z coordinates and hence make turning
-    // pieces.
-    // @param  road_type       An enum representing the mathematical model to be applied to Z
-    // @param  tile_type       An enum representing whether the tile is water or terrain
-    // @param  min_position    The relative start position of the heightmap over X/Z
-    // @param  position_range  The spread of the heightmap over X/Z 
-    // @warn  No changes can be made to vertices_ member until the Road Helpers complete
-    void HelperMakeVertices(const RoadType road_type = kStraight, const TileType tile_type = kTerrain,
-        const float min_position = 0.0f, const float position_range = 20.0f);
-    // Generates the normals by doing a cross product of neighbouring vertices
-    // @warn  No changes can be made to normals_ member until the Road Helpers complete
-    void HelperMakeNormals();
 
     // ROAD GENERATION HELPERS
-    // Rip the road parts of the terrain vertice vector using calulcated magic numbers and store
-    // these in the vertices_road_ vector
-    // @return  A pair of VBO handles (for use in VBO deletion)
-    void HelperMakeRoadVertices();
     // Rip the road parts of the terrain normals vector using calulcated magic numbers and store
     // these in the normals_road_ vector
     // @warn  requires a preceeding call to HelperMakeNormals otherwise undefined behaviour
     // @warn  for optimzation this should only be called once because road normals don't change
     void HelperMakeRoadNormals();
-    // Generates a collision coordinate mapping
-    //   Finds all edge vertices of road in order then pairs them with the closest vertices
-    //   on the opposite side of the road
-    // @warn  requires a preceeding call to HelperMakeRoadVertices otherwise undefined behaviour
-    // @warn  this is O(n^2) with n = 36  TODO improve complexity
-    void HelperMakeRoadCollisionMap();
 
     // OPENGL RENDERING FUNCTIONS
     // Creates a new vertex array object and loads in data into a vertex attribute buffer
@@ -331,42 +304,68 @@ class Terrain {
     //   @param  tile_type  An enum representing the proper members to use
     //   @return vao_handle, the vao handle
     GLuint CreateVao(TileType tile_type);
-    // Creates a texture pointer from file
-    //   @return  GLuint  The int pointing to the opengl texture data
-    GLuint LoadTexture(const std::string &filename) const;
+    // Creates the position only VAO of the last terrain tile for the shadow map
+    //   Shares the position VBO of the terrain VAO, only the depth indices are new
+    //   @return vao_handle, the vao handle
+    //   @warn  requires a preceeding call to CreateVao(kTerrain)
+    GLuint CreateDepthVao();
+    // Pushes back the descriptor of a freshly generated terrain tile
+    //   The bounding box is taken from the workspace vertices
+    //   @param terrain_vao, the terrain VAO of the tile
+    //   @param depth_vao, the position only VAO of the tile
+    //   @param road_type, the turn type of the tile
+    //   @warn  the road VAO is filled in once it has been created
+    void PushTileDescriptor(const GLuint terrain_vao, const GLuint depth_vao, const RoadType road_type);
+    // Uploads the props of every tile the scatter worker has placed
+    //   The props of a tile which was passed before they were placed are dropped
+    void UpdateScatter();
+    // Creates the uniform buffer of the terrain's Materials block
+    //   @return  The buffer handle, sized for kMaxMaterials
+    //   @warn  requires the road texture to be loaded
+    GLuint CreateMaterialBlock() const;
 
     // Verbose Debugging mode
     bool is_debugging_;
 };
 
-inline GLuint Terrain::cliff_bump() const {
+// The cliff normal map
+inline const TextureLayer &Terrain::cliff_bump() const {
   return cliff_bump_;
 }
-
-inline GLuint Terrain::road_bump() const {
+// The moss mixed into the cliffs
+inline const TextureLayer &Terrain::road_bump() const {
   return road_bump_;
 }
-// Accessor for the VAO
-// TODO comment
-inline const circular_vector<GLuint> * Terrain::terrain_vao_handle() const {
-  return &terrain_vao_handle_;
+// Accessor for the uniform buffer of the terrain's Materials block
+//   The terrain's vertices have no a_material so they all use slot 0
+inline GLuint Terrain::material_block() const {
+  return material_block_;
+}
+// A container filled with the loaded tiles in proceeding order
+inline const circular_vector<Terrain::TileDescriptor> * Terrain::tiles() const {
+  return &tiles_;
+}
+// Accessor for the low resolution strip continuing past the last tile
+inline const Horizon * Terrain::horizon() const {
+  return &horizon_;
+}
+// Accessor for the version of the loaded tiles
+//   Changes whenever a terrain or road VAO is added or removed
+inline unsigned int Terrain::tile_version() const {
+  return tile_version_;
 }
 // Accessor for the Shader object
-inline const Shader Terrain::shader() const {
+inline const Shader &Terrain::shader() const {
   return shader_;
 }
-// TODO comment
-inline const circular_vector<unsigned int> * Terrain::road_vao_handle() const {
-  return &road_vao_handle_;
-}
-// TODO comment
-inline GLuint Terrain::road_texture() const {
+// The road texture used for binding, its layer is in the material block
+inline const TextureLayer &Terrain::road_texture() const {
   return road_texture_;
 }
-// Accessor for the loaded texture
-//   @warn requires a texture to be loaded with LoadTexture()
-inline GLuint Terrain::texture() const {
-  return texture_;
+// Accessor for the streamed cliff materials
+//   Holds the texture array sampled by the terrain tiles
+inline const TextureStreamer * Terrain::texture_streamer() const {
+  return &texture_streamer_;
 }
 // Accessor for the width (Amount of Grid boxes width-wise)
 inline int Terrain::width() const {
@@ -376,15 +375,15 @@ inline int Terrain::width() const {
 inline int Terrain::height() const {
   return z_length_;
 }
-// Accessor for the amount of indices
-//   Used in render to efficiently draw triangles
+// Accessor for the amount of indices in an unsimplified tile
+//   Used as the baseline for the adaptive triangle counts
 inline int Terrain::indice_count() const {
-  return indice_count_;
+  return generator_.indice_count();
 }
 // Accessor for the amount of indices
 //   Used in render to efficiently draw triangles
 inline int Terrain::road_indice_count() const {
-  return road_indice_count_;
+  return generator_.road_indice_count();
 }
 // Accessor for the collision checking data structure
 // A queue representing each road tile for collision checking
@@ -0,0 +1,281 @@
+/**
+ * terrain_soak, a headless soak test and throughput harness for the terrain
+ *
+ * Runs the CPU half of the tile pipeline (TileGenerator) for many seeds on
+ * every core, checks invariants of every generated tile and prints the
+ * throughput, per stage latency and peak memory as JSON
+ *
+ * Usage: ./terrain_soak [seeds = 64] [tiles per seed = 200] [threads = all cores]
+ *   Exits with 1 if any tile broke an invariant, the first few are printed to stderr
+ *   Exits with 2 if an argument isn't a positive whole number
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <sys/resource.h>
+
+#include "tile_generator.h"
+
+// The tile size used by the game
+static const int kTileSize = 96;
+// The tiles Terrain generates before it starts picking turns
+//   3 starting tiles plus 5 straight randomized tiles
+static const int kStraightTiles = 8;
+// The largest allowed gap between a tile's first row and the previous tile's last row
+static const float kSeamEpsilon = 1e-4f;
+// The amount of invariant failures printed before staying quiet
+static const unsigned int kMaxReportedFailures = 10;
+
+// The pipeline stages in the order they are run
+enum Stage {
+  kHeights = 0,
+  kSmooth,
+  kVertices,
+  kNormals,
+  kRoad,
+  kCollision,
+  kAdaptive,
+  kStageCount,
+};
+static const char * kStageNames[kStageCount] = {
+  "heights", "smooth", "vertices", "normals", "road", "collision", "adaptive",
+};
+
+// The timings and failures gathered by one worker
+struct SoakResult {
+  // Microseconds spent in each stage, one sample per tile
+  std::vector<double> stage_us[kStageCount];
+  unsigned long tiles;
+  unsigned long failures;
+};
+
+// Guards the failure reporting
+static std::mutex report_mutex;
+static unsigned int reported_failures = 0;
+
+// Prints an invariant failure to stderr (only the first few)
+static void ReportFailure(const unsigned int seed, const int tile, const char * what) {
+  std::lock_guard<std::mutex> lock(report_mutex);
+  if (reported_failures++ < kMaxReportedFailures)
+    fprintf(stderr, "terrain_soak - seed %u tile %d: %s\n", seed, tile, what);
+}
+
+// Whether every component of the vector is a real number
+static bool IsFinite(const glm::vec3 &v) {
+  return std::isfinite(v.x) && std::isfinite(v.y) && std::isfinite(v.z);
+}
+
+// Checks the invariants of the tile that was just generated
+//   @param generator, the generator holding the tile
+//   @param prev_last_row, the last vertice row of the previous tile (empty for the first)
+//   @return  The amount of broken invariants
+static unsigned int CheckTile(const TileGenerator &generator, const std::vector<glm::vec3> &prev_last_row,
+    const unsigned int seed, const int tile) {
+  const TerrainWorkspace * workspace = generator.workspace();
+  unsigned int failures = 0;
+
+  // No NaN (or infinite) vertices and normals
+  for (unsigned int x = 0; x < workspace->vertices.size(); ++x) {
+    if (!IsFinite(workspace->vertices[x])) {
+      ReportFailure(seed, tile, "non finite vertex");
+      ++failures;
+      break;
+    }
+  }
+  for (unsigned int x = 0; x < workspace->normals.size(); ++x) {
+    if (!IsFinite(workspace->normals[x])) {
+      ReportFailure(seed, tile, "NaN normal");
+      ++failures;
+      break;
+    }
+  }
+
+  // The first row continues on exactly from the previous tile
+  for (unsigned int x = 0; x < prev_last_row.size(); ++x) {
+    if (glm::distance(workspace->vertices[x], prev_last_row[x]) > kSeamEpsilon) {
+      ReportFailure(seed, tile, "seam does not match the previous tile");
+      ++failures;
+      break;
+    }
+  }
+
+  // The boundary pairs move forward along the road
+  const std::vector<std::pair<glm::vec3, glm::vec3> > &pairs = workspace->boundary_pairs;
+  const glm::vec3 heading = (pairs.back().first + pairs.back().second)
+    - (pairs.front().first + pairs.front().second);
+  for (unsigned int z = 1; z < pairs.size(); ++z) {
+    const glm::vec3 step = (pairs[z].first + pairs[z].second)
+      - (pairs[z-1].first + pairs[z-1].second);
+    if (glm::dot(step, heading) <= 0.0f) {
+      ReportFailure(seed, tile, "boundary pairs out of order");
+      ++failures;
+      break;
+    }
+  }
+
+  // The adaptive triangulation only references the tile's vertices
+  const std::vector<int> &indices = workspace->adaptive_indices;
+  if (indices.size() % 3 != 0) {
+    ReportFailure(seed, tile, "adaptive indices are not whole triangles");
+    ++failures;
+  }
+  for (unsigned int x = 0; x < indices.size(); ++x) {
+    if (indices[x] < 0 || indices[x] >= int(workspace->vertices.size())) {
+      ReportFailure(seed, tile, "adaptive indice out of range");
+      ++failures;
+      break;
+    }
+  }
+  return failures;
+}
+
+// Generates tiles for seeds taken from next_seed until there are none left
+static void Work(std::atomic<unsigned int> *next_seed, const unsigned int seeds,
+    const int tiles_per_seed, SoakResult *result) {
+  typedef std::chrono::steady_clock Clock;
+  result->tiles = 0;
+  result->failures = 0;
+  std::vector<glm::vec3> prev_last_row;
+  unsigned int seed;
+  while ((seed = (*next_seed)++) < seeds) {
+    TileGenerator generator(kTileSize, kTileSize, seed);
+    prev_last_row.clear();
+    for (int tile = 0; tile < tiles_per_seed; ++tile) {
+      if (tile >= kStraightTiles)
+        generator.BeginTile();
+      const TileGenerator::RoadType road_type = generator.next_turn();
+
+      Clock::time_point times[kStageCount + 1];
+      times[kHeights] = Clock::now();
+      generator.MakeHeights(0, generator.random_iterations());
+      times[kSmooth] = Clock::now();
+      generator.MakeSmoothHeights(true);
+      generator.MakeSmoothHeights(false);
+      times[kVertices] = Clock::now();
+      generator.MakeVertices(road_type);
+      times[kNormals] = Clock::now();
+      generator.MakeNormals();
+      times[kRoad] = Clock::now();
+      generator.MakeRoadVertices();
+      times[kCollision] = Clock::now();
+      generator.MakeRoadCollisionMap();
+      times[kAdaptive] = Clock::now();
+      generator.MakeAdaptiveIndices();
+      times[kStageCount] = Clock::now();
+
+      for (int stage = 0; stage < kStageCount; ++stage) {
+        result->stage_us[stage].push_back(
+            std::chrono::duration<double, std::micro>(times[stage+1] - times[stage]).count());
+      }
+      result->failures += CheckTile(generator, prev_last_row, seed, tile);
+      ++result->tiles;
+
+      const std::vector<glm::vec3> &vertices = generator.workspace()->vertices;
+      prev_last_row.assign(vertices.end() - kTileSize, vertices.end());
+    }
+  }
+}
+
+// Parses an argument as a count
+//   @param count, set to the count
+//   @return  false if it isn't a whole number above 0
+static bool ParseCount(const char * argument, unsigned int * count) {
+  char * end;
+  errno = 0;
+  const long value = strtol(argument, &end, 10);
+  if (end == argument || *end != '\0' || errno == ERANGE || value <= 0 || value > INT_MAX)
+    return false;
+  *count = value;
+  return true;
+}
+
+// The value at the given fraction of the sorted samples
+static double Percentile(const std::vector<double> &sorted, const double fraction) {
+  if (sorted.empty())
+    return 0.0;
+  const unsigned int index = std::min<unsigned int>(sorted.size() - 1, sorted.size() * fraction);
+  return sorted[index];
+}
+
+int main(int argc, char **argv) {
+  // Seeds, tiles per seed and threads, hardware_concurrency is 0 if unknown
+  unsigned int counts[3] = { 64, 200, std::max(std::thread::hardware_concurrency(), 1u) };
+  if (argc > 4) {
+    fprintf(stderr, "Usage: %s [seeds = 64] [tiles per seed = 200] [threads = all cores]\n", argv[0]);
+    return 2;
+  }
+  for (int x = 1; x < argc; ++x) {
+    if (!ParseCount(argv[x], &counts[x-1])) {
+      fprintf(stderr, "terrain_soak - %s is not a positive whole number\n", argv[x]);
+      fprintf(stderr, "Usage: %s [seeds = 64] [tiles per seed = 200] [threads = all cores]\n", argv[0]);
+      return 2;
+    }
+  }
+  const unsigned int seeds = counts[0];
+  const int tiles_per_seed = counts[1];
+  unsigned int threads = counts[2];
+  threads = std::min(threads, std::max(seeds, 1u));
+
+  std::atomic<unsigned int> next_seed(0);
+  std::vector<SoakResult> results(threads);
+  std::vector<std::thread> workers;
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (unsigned int x = 0; x < threads; ++x)
+    workers.push_back(std::thread(Work, &next_seed, seeds, tiles_per_seed, &results[x]));
+  for (unsigned int x = 0; x < threads; ++x)
+    workers[x].join();
+  const double seconds = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+
+  // Merge the workers
+  unsigned long tiles = 0, failures = 0;
+  std::vector<double> stage_us[kStageCount];
+  for (unsigned int x = 0; x < threads; ++x) {
+    tiles += results[x].tiles;
+    failures += results[x].failures;
+    for (int stage = 0; stage < kStageCount; ++stage) {
+      stage_us[stage].insert(stage_us[stage].end(),
+          results[x].stage_us[stage].begin(), results[x].stage_us[stage].end());
+    }
+  }
+
+  // Peak resident memory, ru_maxrss is in kilobytes on Linux (bytes on OS X)
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+  const long peak_rss_kb = usage.ru_maxrss / 1024;
+#else
+  const long peak_rss_kb = usage.ru_maxrss;
+#endif
+
+  printf("{\n");
+  printf("  \"seeds\": %u,\n", seeds);
+  printf("  \"tiles_per_seed\": %d,\n", tiles_per_seed);
+  printf("  \"threads\": %u,\n", threads);
+  printf("  \"tiles\": %lu,\n", tiles);
+  printf("  \"seconds\": %.3f,\n", seconds);
+  printf("  \"tiles_per_sec\": %.1f,\n", seconds > 0.0 ? tiles / seconds : 0.0);
+  printf("  \"failures\": %lu,\n", failures);
+  printf("  \"peak_rss_kb\": %ld,\n", peak_rss_kb);
+  printf("  \"stages_us\": {\n");
+  for (int stage = 0; stage < kStageCount; ++stage) {
+    std::sort(stage_us[stage].begin(), stage_us[stage].end());
+    printf("    \"%s\": { \"p50\": %.1f, \"p99\": %.1f }%s\n", kStageNames[stage],
+        Percentile(stage_us[stage], 0.50), Percentile(stage_us[stage], 0.99),
+        stage == kStageCount - 1 ? "" : ",");
+  }
+  printf("  }\n");
+  printf("}\n");
+
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,321 @@
+#include "texture_arrays.h"
+
+#include "lib/stb_image/stb_image.h"
+
+// The grey of a layer until it is uploaded (or if it fails to load)
+static const unsigned char kPlaceholderGrey = 128;
+
+// Where the decoded layers are cached
+const char * const TextureArrays::kCacheDirectory = "textures/cache";
+
+// Resizes RGBA pixels to size x size
+//   Nearest neighbour is enough as the mipmaps are filtered
+static std::vector<unsigned char> Resize(const unsigned char * data, const int x, const int y,
+    const int size) {
+  std::vector<unsigned char> pixels(size * size * 4);
+  for (int row = 0; row < size; ++row) {
+    const int src_row = row * y / size;
+    for (int col = 0; col < size; ++col) {
+      const int src_col = col * x / size;
+      const unsigned char *src = data + (src_row * x + src_col) * 4;
+      unsigned char *dst = &pixels[(row * size + col) * 4];
+      dst[0] = src[0];
+      dst[1] = src[1];
+      dst[2] = src[2];
+      dst[3] = src[3];
+    }
+  }
+  return pixels;
+}
+
+// Whether a texel of RGBA pixels is not fully opaque
+static bool HasAlpha(const unsigned char * data, const int x, const int y) {
+  for (int texel = 0; texel < x * y; ++texel) {
+    if (data[texel * 4 + 3] != 255)
+      return true;
+  }
+  return false;
+}
+
+// Appends every mipmap level of size x size RGBA pixels, down to 1 x 1
+//   Each texel is the average of the 2 x 2 texels above it
+static void BuildMips(std::vector<unsigned char> * pixels, int size) {
+  pixels->reserve(pixels->size() * 4 / 3 + 4);
+  unsigned int level = 0;
+  for (; size > 1; size /= 2) {
+    const int half = size / 2;
+    const unsigned int next = pixels->size();
+    pixels->resize(next + half * half * 4);
+    const unsigned char *src = &(*pixels)[level];
+    unsigned char *dst = &(*pixels)[next];
+    for (int row = 0; row < half; ++row) {
+      for (int col = 0; col < half; ++col) {
+        const unsigned char *top = src + (row * 2 * size + col * 2) * 4;
+        const unsigned char *bottom = top + size * 4;
+        for (int channel = 0; channel < 4; ++channel) {
+          dst[(row * half + col) * 4 + channel] = (top[channel] + top[channel + 4]
+              + bottom[channel] + bottom[channel + 4] + 2) / 4;
+        }
+      }
+    }
+    level = next;
+  }
+}
+
+// Construct with no buckets and starts the workers
+//   @param backend, the backend the arrays are created and uploaded through
+TextureArrays::TextureArrays(RenderBackend * backend) : cache_(kCacheDirectory), backend_(backend),
+  is_allocated_(false),
+  pixel_buffer_(0), pending_(0), start_(std::chrono::steady_clock::now()), is_running_(true) {
+    // hardware_concurrency is 0 if unknown
+    unsigned int workers = std::thread::hardware_concurrency();
+    if (workers == 0)
+      workers = 1;
+    if (workers > kMaxWorkers)
+      workers = kMaxWorkers;
+    for (unsigned int x = 0; x < workers; ++x)
+      workers_.push_back(std::thread(&TextureArrays::Work, this));
+}
+
+// Stops and joins the workers, frees the arrays
+TextureArrays::~TextureArrays() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_running_ = false;
+  }
+  condition_.notify_all();
+  for (unsigned int x = 0; x < workers_.size(); ++x)
+    workers_[x].join();
+  for (; !decoded_.empty(); decoded_.pop()) {
+    if (decoded_.front().mapped.base)
+      TextureCache::Unmap(&decoded_.front().mapped);
+  }
+  for (unsigned int x = 0; x < buckets_.size(); ++x)
+    backend_->DeleteTextures(1, &buckets_[x].texture);
+  if (pixel_buffer_)
+    backend_->DeleteBuffers(1, &pixel_buffer_);
+}
+
+// Loads an image into a layer, each file is only loaded once
+//   Only the header of a cached image or one without an alpha channel is
+//   read here, the rest is mapped or decoded on a worker
+//   @param filename, the image file
+//   @return  The layer, grey if the file couldn't be loaded
+//   @warn  the array has no storage until Allocate
+TextureLayer TextureArrays::Load(const std::string &filename) {
+  std::map<std::string, TextureLayer>::const_iterator loaded = loaded_.find(filename);
+  if (loaded != loaded_.end())
+    return loaded->second;
+  assert(!is_allocated_ && "Textures must be loaded before TextureArrays::Allocate");
+
+  Job job;
+  job.filename = filename;
+  job.is_cached = false;
+  job.is_placeholder = false;
+  job.mapped.base = NULL;
+  TextureLayer texture;
+  texture.has_alpha = false;
+  int x, y, n;
+  // stbi_info can't read every TGA, those are decoded here too
+  if (cache_.Find(filename, &job.size, &texture.has_alpha)) {
+    job.is_cached = true;
+  } else if (stbi_info(filename.c_str(), &x, &y, &n) && n != 2 && n != 4) {
+    job.size = BucketSize(x, y);
+  } else {
+    unsigned char *data = stbi_load(filename.c_str(), &x, &y, &n, 4);
+    if (!data) {
+      fprintf(stderr, "TextureArrays - could not load %s\n", filename.c_str());
+      job.is_placeholder = true;
+      job.size = kMinSize;
+      job.pixels.assign(kMinSize * kMinSize * 4, kPlaceholderGrey);
+    } else {
+      job.size = BucketSize(x, y);
+      texture.has_alpha = HasAlpha(data, x, y);
+      job.pixels = Resize(data, x, y, job.size);
+      stbi_image_free(data);
+    }
+  }
+
+  job.has_alpha = texture.has_alpha;
+  job.bucket = FindBucket(job.size);
+  Bucket &bucket = buckets_[job.bucket];
+  job.layer = bucket.layers++;
+  texture.texture = bucket.texture;
+  texture.layer = job.layer;
+  loaded_[filename] = texture;
+  ++pending_;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    jobs_.push(Job());
+    std::swap(jobs_.back(), job);
+  }
+  condition_.notify_one();
+  return texture;
+}
+
+// Allocates every array with its mipmaps, each layer grey until uploaded
+//   The grey is copied from the pixel buffer, so it never leaves the GPU
+//   Trilinear repeat is also set on the arrays, for drivers without sampler objects
+void TextureArrays::Allocate() {
+  int largest = kMinSize;
+  for (unsigned int x = 0; x < buckets_.size(); ++x)
+    largest = buckets_[x].size > largest ? buckets_[x].size : largest;
+  const std::vector<unsigned char> grey(largest * largest * 4, kPlaceholderGrey);
+  backend_->GenBuffers(1, &pixel_buffer_);
+
+  for (unsigned int x = 0; x < buckets_.size(); ++x) {
+    const Bucket &bucket = buckets_[x];
+    backend_->BindTexture(GL_TEXTURE_2D_ARRAY, bucket.texture);
+    backend_->TexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    backend_->TexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    backend_->TexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    backend_->TexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    for (int level = 0, size = bucket.size; size >= 1; ++level, size /= 2) {
+      backend_->TexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8, size, size, bucket.layers,
+          0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+    }
+  }
+
+  backend_->BindBuffer(GL_PIXEL_UNPACK_BUFFER, pixel_buffer_);
+  backend_->BufferData(GL_PIXEL_UNPACK_BUFFER, grey.size(), &grey[0], GL_STATIC_DRAW);
+  for (unsigned int x = 0; x < buckets_.size(); ++x) {
+    const Bucket &bucket = buckets_[x];
+    backend_->BindTexture(GL_TEXTURE_2D_ARRAY, bucket.texture);
+    for (int level = 0, size = bucket.size; size >= 1; ++level, size /= 2) {
+      for (unsigned int y = 0; y < bucket.layers; ++y) {
+        backend_->TexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, y, size, size, 1,
+            GL_RGBA, GL_UNSIGNED_BYTE, 0);
+      }
+    }
+  }
+  backend_->BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+  backend_->BindTexture(GL_TEXTURE_2D_ARRAY, 0);
+  is_allocated_ = true;
+  printf("TextureArrays - placeholders ready %.0f ms after construction, %u layers to upload\n",
+      ElapsedMs(), pending_);
+}
+
+// Uploads up to kUploadsPerTick finished layers
+//   Should be called once per tick after Allocate
+void TextureArrays::Update() {
+  if (!pending_)
+    return;
+  assert(is_allocated_ && "TextureArrays::Allocate must be called before Update");
+  std::vector<Job> decoded;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (!decoded_.empty() && decoded.size() < kUploadsPerTick) {
+      decoded.push_back(Job());
+      std::swap(decoded.back(), decoded_.front());
+      decoded_.pop();
+    }
+  }
+  for (unsigned int x = 0; x < decoded.size(); ++x) {
+    Upload(&decoded[x]);
+    --pending_;
+  }
+  if (!decoded.empty() && !pending_)
+    printf("TextureArrays - fully textured %.0f ms after construction\n", ElapsedMs());
+}
+
+// The worker loop, decodes jobs until stopped
+void TextureArrays::Work() {
+  while (true) {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      while (is_running_ && jobs_.empty())
+        condition_.wait(lock);
+      if (!is_running_)
+        return;
+      std::swap(job, jobs_.front());
+      jobs_.pop();
+    }
+    Decode(&job);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    decoded_.push(Job());
+    std::swap(decoded_.back(), job);
+  }
+}
+
+// The bucket of a size, creating it if it is the first of its size
+//   @return  The index into buckets_
+unsigned int TextureArrays::FindBucket(const int size) {
+  for (unsigned int x = 0; x < buckets_.size(); ++x) {
+    if (buckets_[x].size == size)
+      return x;
+  }
+  Bucket bucket;
+  bucket.size = size;
+  bucket.layers = 0;
+  backend_->GenTextures(1, &bucket.texture);
+  buckets_.push_back(bucket);
+  return buckets_.size() - 1;
+}
+
+// The bucket size of an image
+//   @return  The power of two at or below the longest side, clamped to [kMinSize, kMaxSize]
+int TextureArrays::BucketSize(const int x, const int y) {
+  const int longest = x > y ? x : y;
+  int size = kMinSize;
+  while (size * 2 <= longest && size < kMaxSize)
+    size *= 2;
+  return size;
+}
+
+// Maps a cached layer, or decodes (unless done by Load), mipmaps and caches it
+//   A file which couldn't be decoded is mipmapped grey but not cached
+//   @param job, its mapping or pixels are set to every level
+void TextureArrays::Decode(Job * job) const {
+  if (job->is_cached && cache_.Map(job->filename, &job->mapped)) {
+    if (job->mapped.levels_length == TextureCache::LevelsLength(job->size))
+      return;
+    // Replaced since Load read it
+    TextureCache::Unmap(&job->mapped);
+  }
+  if (job->pixels.empty()) {
+    int x, y, n;
+    unsigned char *data = stbi_load(job->filename.c_str(), &x, &y, &n, 4);
+    if (!data) {
+      fprintf(stderr, "TextureArrays - could not load %s\n", job->filename.c_str());
+      job->is_placeholder = true;
+      job->pixels.assign(job->size * job->size * 4, kPlaceholderGrey);
+    } else {
+      job->pixels = Resize(data, x, y, job->size);
+      stbi_image_free(data);
+    }
+  }
+  BuildMips(&job->pixels, job->size);
+  // The grey isn't the file's content, later runs try decoding it again
+  if (!job->is_placeholder)
+    cache_.Store(job->filename, job->size, job->has_alpha, job->pixels);
+}
+
+// Uploads every level of a decoded or mapped layer
+//   The pixel buffer is orphaned first, so an upload still reading it isn't waited on
+//   Mapped layers are unmapped once copied
+void TextureArrays::Upload(Job * job) {
+  const Bucket &bucket = buckets_[job->bucket];
+  const unsigned char * levels = job->mapped.base ? job->mapped.levels : &job->pixels[0];
+  const size_t length = job->mapped.base ? job->mapped.levels_length : job->pixels.size();
+  backend_->BindBuffer(GL_PIXEL_UNPACK_BUFFER, pixel_buffer_);
+  backend_->BufferData(GL_PIXEL_UNPACK_BUFFER, length, 0, GL_STREAM_DRAW);
+  backend_->BufferSubData(GL_PIXEL_UNPACK_BUFFER, 0, length, levels);
+  if (job->mapped.base)
+    TextureCache::Unmap(&job->mapped);
+  backend_->BindTexture(GL_TEXTURE_2D_ARRAY, bucket.texture);
+  unsigned int offset = 0;
+  for (int level = 0, size = bucket.size; size >= 1; ++level, size /= 2) {
+    backend_->TexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, job->layer, size, size, 1,
+        GL_RGBA, GL_UNSIGNED_BYTE, (const GLvoid *) (size_t) offset);
+    offset += size * size * 4;
+  }
+  backend_->BindTexture(GL_TEXTURE_2D_ARRAY, 0);
+  backend_->BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+// The milliseconds since construction
+double TextureArrays::ElapsedMs() const {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_).count();
+}
@@ -0,0 +1,169 @@
+#ifndef ASSIGN3_TEXTURE_ARRAYS_H_
+#define ASSIGN3_TEXTURE_ARRAYS_H_
+
+#include <vector>
+#include <string>
+#include <map>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <utility>
+#include <cstdio>
+#include <cassert>
+
+#include <GL/glew.h>
+#include "texture_cache.h"
+#include "render_backend.h"
+
+// A loaded texture, a layer of one of the TextureArrays
+struct TextureLayer {
+  // The texture array of the layer's bucket
+  GLuint texture;
+  // The layer to sample
+  float layer;
+  // Whether a texel is not fully opaque
+  bool has_alpha;
+};
+
+// Packs every loaded texture into one 2D texture array per size bucket
+//   An image is resized to the power of two at or below its longest side,
+//   clamped to [kMinSize, kMaxSize], and becomes a layer of that size's array
+//   Draws of textures in the same bucket share a bind, each samples its own
+//   layer, see MaterialBlock::layer
+//   Images are decoded, resized and mipmapped on a pool of worker threads,
+//   only their headers are read by Load. Allocate gives every layer a grey
+//   placeholder so the first frame can be drawn before they are finished,
+//   Update then uploads the finished layers through a pixel buffer, the
+//   uploads go through a RenderBackend so a recording counts their bytes
+//   Decoded layers are kept in a TextureCache, later runs map their levels
+//   instead of decoding
+//   The arrays are mipmapped, how they are sampled is the Renderer's sampler
+//   objects' state
+//   @warn  every texture must be loaded before Allocate
+class TextureArrays {
+  public:
+    // Construct with no buckets and starts the workers
+    //   @param backend, the backend the arrays are created and uploaded through
+    explicit TextureArrays(RenderBackend * backend);
+    // Stops and joins the workers, frees the arrays
+    ~TextureArrays();
+
+    // Loads an image into a layer, each file is only loaded once
+    //   The layer is decoded (or mapped from the cache) on a worker, uncached
+    //   images which may have alpha are decoded here as their transparency
+    //   decides a model's draws
+    //   @param filename, the image file
+    //   @return  The layer, grey if the file couldn't be loaded
+    //   @warn  the array has no storage until Allocate
+    TextureLayer Load(const std::string &filename);
+    // Allocates every array with its mipmaps, each layer grey until uploaded
+    //   @warn requires a GL context
+    void Allocate();
+    // Uploads up to kUploadsPerTick finished layers
+    //   Should be called once per tick after Allocate
+    void Update();
+
+    // Accessor for the amount of texture arrays
+    inline unsigned int bucket_count() const;
+    // Accessor for the amount of layers not uploaded yet
+    inline unsigned int pending_count() const;
+
+  private:
+    // CONSTANTS
+    // The smallest and largest bucket
+    static const int kMinSize = 64;
+    static const int kMaxSize = 2048;
+    // The most decode threads, fewer on machines with fewer cores
+    static const unsigned int kMaxWorkers = 4;
+    // The most layers uploaded per tick, spreads the uploads over frames
+    static const unsigned int kUploadsPerTick = 2;
+    // Where the decoded layers are cached
+    static const char * const kCacheDirectory;
+
+    // The layers of one size
+    struct Bucket {
+      // The width and height of every layer
+      int size;
+      // The GL texture array
+      GLuint texture;
+      // The amount of layers
+      unsigned int layers;
+    };
+    // A layer to decode, or one decoded with its mipmaps
+    struct Job {
+      unsigned int bucket;
+      unsigned int layer;
+      int size;
+      std::string filename;
+      bool has_alpha;
+      // Whether Load found the layer in the cache
+      bool is_cached;
+      // Whether the file couldn't be decoded, its grey placeholder isn't cached
+      bool is_placeholder;
+      // Level 0 RGBA if decoded by Load, then every level, largest first
+      std::vector<unsigned char> pixels;
+      // Every level, if mapped from the cache instead of decoded
+      MappedTexture mapped;
+    };
+
+    // The buckets, in order of first use
+    std::vector<Bucket> buckets_;
+    // Every file loaded so far
+    std::map<std::string, TextureLayer> loaded_;
+    // The layers decoded by this and earlier runs
+    const TextureCache cache_;
+    // The backend the arrays are created and uploaded through
+    RenderBackend * const backend_;
+    // Set by Allocate, no layers can be added after
+    bool is_allocated_;
+    // The pixel buffer the layers are uploaded through
+    GLuint pixel_buffer_;
+    // The amount of layers loaded but not uploaded
+    unsigned int pending_;
+    // When constructed, the start of the timings
+    std::chrono::steady_clock::time_point start_;
+
+    // WORKER THREADS
+    // Layers to decode
+    std::queue<Job> jobs_;
+    // Decoded layers to upload
+    std::queue<Job> decoded_;
+    // Guards jobs_, decoded_ and is_running_
+    std::mutex mutex_;
+    // Wakes a worker up on new jobs
+    std::condition_variable condition_;
+    // Cleared on destruction to stop the workers
+    bool is_running_;
+    // The workers decoding images
+    std::vector<std::thread> workers_;
+
+    // The worker loop, decodes jobs until stopped
+    void Work();
+    // The bucket of a size, creating it if it is the first of its size
+    //   @return  The index into buckets_
+    unsigned int FindBucket(const int size);
+    // The bucket size of an image
+    //   @return  The power of two at or below the longest side, clamped to [kMinSize, kMaxSize]
+    static int BucketSize(const int x, const int y);
+    // Maps a cached layer, or decodes (unless done by Load), mipmaps and caches it
+    //   @param job, its mapping or pixels are set to every level
+    void Decode(Job * job) const;
+    // Uploads every level of a decoded or mapped layer, unmapping it
+    void Upload(Job * job);
+    // The milliseconds since construction
+    double ElapsedMs() const;
+};
+
+// Accessor for the amount of texture arrays
+inline unsigned int TextureArrays::bucket_count() const {
+  return buckets_.size();
+}
+
+// Accessor for the amount of layers not uploaded yet
+inline unsigned int TextureArrays::pending_count() const {
+  return pending_;
+}
+
+#endif
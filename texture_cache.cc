@@ -0,0 +1,144 @@
+#include "texture_cache.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+// Construct with the directory the files are kept in
+TextureCache::TextureCache(const std::string &directory) : directory_(directory) {
+}
+
+// Reads the header of a source's cache file
+//   @param source, the image file
+//   @param size, set to the size of level 0
+//   @param has_alpha, set to whether a texel is not fully opaque
+//   @return  false if there is no file or it is stale
+bool TextureCache::Find(const std::string &source, int * size, bool * has_alpha) const {
+  TextureCacheHeader expected;
+  if (!SourceHeader(source, &expected))
+    return false;
+  FILE * file = fopen(CachePath(source).c_str(), "rb");
+  if (!file)
+    return false;
+  TextureCacheHeader header;
+  const bool is_read = fread(&header, sizeof(header), 1, file) == 1;
+  fclose(file);
+  if (!is_read || !IsFresh(header, expected))
+    return false;
+  *size = header.size;
+  *has_alpha = header.has_alpha != 0;
+  return true;
+}
+
+// Maps the levels of a source's cache file
+//   The pages are read as they are uploaded, nothing is decoded
+//   @param texture, set to the mapping, see Unmap
+//   @return  false if there is no file or it is stale
+bool TextureCache::Map(const std::string &source, MappedTexture * texture) const {
+  TextureCacheHeader expected;
+  if (!SourceHeader(source, &expected))
+    return false;
+  const int descriptor = open(CachePath(source).c_str(), O_RDONLY);
+  if (descriptor == -1)
+    return false;
+  struct stat status;
+  if (fstat(descriptor, &status) != 0 || size_t(status.st_size) < sizeof(TextureCacheHeader)) {
+    close(descriptor);
+    return false;
+  }
+  void * base = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+  // The mapping holds its own reference to the file
+  close(descriptor);
+  if (base == MAP_FAILED)
+    return false;
+
+  texture->base = base;
+  texture->length = status.st_size;
+  const TextureCacheHeader &header = *static_cast<const TextureCacheHeader *>(base);
+  if (!IsFresh(header, expected)
+      || texture->length != sizeof(TextureCacheHeader) + LevelsLength(header.size)) {
+    Unmap(texture);
+    return false;
+  }
+  texture->levels = static_cast<const unsigned char *>(base) + sizeof(TextureCacheHeader);
+  texture->levels_length = LevelsLength(header.size);
+  return true;
+}
+
+// Writes a source's levels, replacing its file
+//   Written to a temporary file first, so a reader never sees half a file
+//   @param levels, every RGBA level of size x size down to 1 x 1
+void TextureCache::Store(const std::string &source, const int size, const bool has_alpha,
+    const std::vector<unsigned char> &levels) const {
+  TextureCacheHeader header;
+  if (!SourceHeader(source, &header) || levels.size() != LevelsLength(size))
+    return;
+  header.size = size;
+  header.has_alpha = has_alpha ? 1 : 0;
+
+  // Fails harmlessly if it exists
+  mkdir(directory_.c_str(), 0755);
+  const std::string path = CachePath(source);
+  const std::string temporary = path + ".tmp";
+  FILE * file = fopen(temporary.c_str(), "wb");
+  if (!file) {
+    fprintf(stderr, "TextureCache - could not write %s\n", temporary.c_str());
+    return;
+  }
+  const bool is_written = fwrite(&header, sizeof(header), 1, file) == 1
+    && fwrite(&levels[0], levels.size(), 1, file) == 1;
+  fclose(file);
+  if (!is_written || rename(temporary.c_str(), path.c_str()) != 0) {
+    fprintf(stderr, "TextureCache - could not write %s\n", path.c_str());
+    remove(temporary.c_str());
+  }
+}
+
+// Unmaps a mapping of Map
+void TextureCache::Unmap(MappedTexture * texture) {
+  munmap(texture->base, texture->length);
+  texture->base = NULL;
+  texture->levels = NULL;
+}
+
+// The bytes of every RGBA level of a size down to 1 x 1
+size_t TextureCache::LevelsLength(const int size) {
+  size_t length = 0;
+  for (int level = size; level >= 1; level /= 2)
+    length += size_t(level) * level * 4;
+  return length;
+}
+
+// The cache file of a source, named by the FNV-1a hash of its path
+std::string TextureCache::CachePath(const std::string &source) const {
+  unsigned long long hash = 14695981039346656037ull;
+  for (unsigned int x = 0; x < source.size(); ++x)
+    hash = (hash ^ static_cast<unsigned char>(source[x])) * 1099511628211ull;
+  char name[32];
+  snprintf(name, sizeof(name), "/%016llx.tex", hash);
+  return directory_ + name;
+}
+
+// The header a source's file must have, without its size and alpha
+//   @return  false if the source doesn't exist
+bool TextureCache::SourceHeader(const std::string &source, TextureCacheHeader * header) {
+  struct stat status;
+  if (stat(source.c_str(), &status) != 0)
+    return false;
+  memset(header, 0, sizeof(*header));
+  memcpy(header->magic, "A3TX", 4);
+  header->version = kVersion;
+  header->source_mtime = status.st_mtime;
+  header->source_size = status.st_size;
+  return true;
+}
+
+// Whether a read header belongs to the source's current header
+bool TextureCache::IsFresh(const TextureCacheHeader &read, const TextureCacheHeader &expected) {
+  return memcmp(read.magic, expected.magic, 4) == 0
+    && read.version == expected.version
+    && read.source_mtime == expected.source_mtime
+    && read.source_size == expected.source_size
+    && read.size > 0;
+}
@@ -0,0 +1,81 @@
+#ifndef ASSIGN3_TEXTURE_CACHE_H_
+#define ASSIGN3_TEXTURE_CACHE_H_
+
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstring>
+#include <cstddef>
+
+// The header of a cache file, followed by every mip level largest first
+//   @warn  bump kVersion when the layout or the levels' contents change
+struct TextureCacheHeader {
+  // "A3TX"
+  char magic[4];
+  unsigned int version;
+  // The source file the levels were decoded from, stale if either differs
+  long long source_mtime;
+  long long source_size;
+  // The width and height of level 0, levels go down to 1 x 1
+  int size;
+  // Whether a texel is not fully opaque
+  int has_alpha;
+};
+
+// The levels of a cache file mapped into memory
+struct MappedTexture {
+  // The mapping, the header included
+  void * base;
+  size_t length;
+  // Every RGBA level, largest first
+  const unsigned char * levels;
+  size_t levels_length;
+};
+
+// A directory of decoded textures with their mipmaps, one file per source
+//   Filled the first time a source is decoded, later runs map the levels
+//   instead of decoding them. A file is stale once its source's modification
+//   time or size changes
+//   Every method only touches its source's file, so workers can share it
+class TextureCache {
+  public:
+    // Construct with the directory the files are kept in
+    explicit TextureCache(const std::string &directory);
+
+    // Reads the header of a source's cache file
+    //   @param source, the image file
+    //   @param size, set to the size of level 0
+    //   @param has_alpha, set to whether a texel is not fully opaque
+    //   @return  false if there is no file or it is stale
+    bool Find(const std::string &source, int * size, bool * has_alpha) const;
+    // Maps the levels of a source's cache file
+    //   @param texture, set to the mapping, see Unmap
+    //   @return  false if there is no file or it is stale
+    bool Map(const std::string &source, MappedTexture * texture) const;
+    // Writes a source's levels, replacing its file
+    //   @param levels, every RGBA level of size x size down to 1 x 1
+    void Store(const std::string &source, const int size, const bool has_alpha,
+        const std::vector<unsigned char> &levels) const;
+    // Unmaps a mapping of Map
+    static void Unmap(MappedTexture * texture);
+
+    // The bytes of every RGBA level of a size down to 1 x 1
+    static size_t LevelsLength(const int size);
+
+  private:
+    // CONSTANTS
+    static const unsigned int kVersion = 1;
+
+    // The directory the files are kept in
+    const std::string directory_;
+
+    // The cache file of a source
+    std::string CachePath(const std::string &source) const;
+    // The header a source's file must have, without its size and alpha
+    //   @return  false if the source doesn't exist
+    static bool SourceHeader(const std::string &source, TextureCacheHeader * header);
+    // Whether a read header belongs to the source's current header
+    static bool IsFresh(const TextureCacheHeader &read, const TextureCacheHeader &expected);
+};
+
+#endif
@@ -0,0 +1,214 @@
+#include "texture_streamer.h"
+
+#include "lib/stb_image/stb_image.h"
+
+// Appends every mipmap level of size x size RGB pixels, down to 1 x 1
+//   Each texel is the average of the 2 x 2 texels above it
+static void BuildMips(std::vector<unsigned char> * pixels, int size) {
+  pixels->reserve(pixels->size() * 4 / 3 + 3);
+  unsigned int level = 0;
+  for (; size > 1; size /= 2) {
+    const int half = size / 2;
+    const unsigned int next = pixels->size();
+    pixels->resize(next + half * half * 3);
+    const unsigned char *src = &(*pixels)[level];
+    unsigned char *dst = &(*pixels)[next];
+    for (int row = 0; row < half; ++row) {
+      for (int col = 0; col < half; ++col) {
+        const unsigned char *top = src + (row * 2 * size + col * 2) * 3;
+        const unsigned char *bottom = top + size * 3;
+        for (int channel = 0; channel < 3; ++channel) {
+          dst[(row * half + col) * 3 + channel] = (top[channel] + top[channel + 3]
+              + bottom[channel] + bottom[channel + 3] + 2) / 4;
+        }
+      }
+    }
+    level = next;
+  }
+}
+
+// Construct with the materials which can be streamed
+//   Blocks until material 0 has been uploaded
+//   @param filenames, the image file of each material
+//   @param backend, the backend the array is created and uploaded through
+TextureStreamer::TextureStreamer(const std::vector<std::string> &filenames, RenderBackend * backend) :
+  filenames_(filenames), backend_(backend), is_running_(true), worker_(&TextureStreamer::Work, this) {
+    for (unsigned char x = 0; x < kLayers; ++x) {
+      layers_[x].material = -1;
+      layers_[x].uses = 0;
+      layers_[x].is_ready = false;
+    }
+
+    // Allocate every layer and level up front, this is the whole budget
+    backend_->GenTextures(1, &texture_);
+    backend_->BindTexture(GL_TEXTURE_2D_ARRAY, texture_);
+    backend_->TexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    backend_->TexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    backend_->TexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    backend_->TexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    for (int level = 0, size = kLayerSize; size >= 1; ++level, size /= 2) {
+      backend_->TexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGB8, size, size, kLayers,
+          0, GL_RGB, GL_UNSIGNED_BYTE, 0);
+    }
+    backend_->BindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    // Fallback material, never released
+    layers_[0].material = 0;
+    layers_[0].uses = 1;
+    Upload(0, Decode(filenames_.at(0)));
+    layers_[0].is_ready = true;
+}
+
+// Stops and joins the worker thread
+TextureStreamer::~TextureStreamer() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_running_ = false;
+  }
+  condition_.notify_one();
+  worker_.join();
+}
+
+// Marks the material as used by a tile, decoding it if it isn't resident
+//   @param material, the index into the filenames
+//   @return  The material granted, material 0 when all layers are in use
+//   @warn  the returned material is the one to Release
+unsigned char TextureStreamer::Request(const unsigned char material) {
+  assert(material < filenames_.size() && "material out of range");
+  // Already resident (or decoding)
+  for (unsigned char x = 0; x < kLayers; ++x) {
+    if (layers_[x].material == material) {
+      ++layers_[x].uses;
+      return material;
+    }
+  }
+  // Reuse an unused layer
+  for (unsigned char x = 0; x < kLayers; ++x) {
+    if (layers_[x].uses == 0) {
+      layers_[x].material = material;
+      layers_[x].uses = 1;
+      layers_[x].is_ready = false;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        requests_.push(std::make_pair(x, material));
+      }
+      condition_.notify_one();
+      return material;
+    }
+  }
+  // Over budget, use the pinned fallback
+  ++layers_[0].uses;
+  return 0;
+}
+
+// Marks the material as no longer used by a tile
+//   Once unused its layer can be reused
+//   @param material, the index into the filenames
+void TextureStreamer::Release(const unsigned char material) {
+  for (unsigned char x = 0; x < kLayers; ++x) {
+    if (layers_[x].material == material) {
+      // The fallback layer is never released
+      if (layers_[x].uses > (x == 0 ? 1u : 0u))
+        --layers_[x].uses;
+      return;
+    }
+  }
+}
+
+// Uploads any finished decodes into their layers
+//   Decodes for layers which were reused in the meantime are dropped
+//   Should be called once per tick
+void TextureStreamer::Update() {
+  std::queue<Decoded> decoded;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    decoded.swap(decoded_);
+  }
+  while (!decoded.empty()) {
+    Layer &layer = layers_[decoded.front().layer];
+    if (layer.material == decoded.front().material) {
+      Upload(decoded.front().layer, decoded.front().pixels);
+      layer.is_ready = true;
+    }
+    decoded.pop();
+  }
+}
+
+// The layer to sample for the material
+//   @return  layer 0 if the material is not uploaded yet
+float TextureStreamer::layer(const unsigned char material) const {
+  for (unsigned char x = 0; x < kLayers; ++x) {
+    if (layers_[x].material == material && layers_[x].is_ready)
+      return x;
+  }
+  return 0;
+}
+
+// The worker loop, decodes requests until stopped
+void TextureStreamer::Work() {
+  while (true) {
+    std::pair<unsigned char, unsigned char> request;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      while (is_running_ && requests_.empty())
+        condition_.wait(lock);
+      if (!is_running_)
+        return;
+      request = requests_.front();
+      requests_.pop();
+    }
+    Decoded decoded;
+    decoded.layer = request.first;
+    decoded.material = request.second;
+    decoded.pixels = Decode(filenames_.at(request.second));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    decoded_.push(decoded);
+  }
+}
+
+// Loads and resizes an image to kLayerSize x kLayerSize RGB with its mipmaps
+//   Nearest neighbour is enough as the mipmaps are built from the result
+//   @param filename, the image file
+//   @return  Every level, largest first, grey if the file couldn't be loaded
+std::vector<unsigned char> TextureStreamer::Decode(const std::string &filename) const {
+  std::vector<unsigned char> pixels(kLayerSize * kLayerSize * 3, 128);
+  int x, y, n;
+  unsigned char *data = stbi_load(filename.c_str(), &x, &y, &n, 3);
+  if (!data) {
+    fprintf(stderr, "TextureStreamer - could not load %s\n", filename.c_str());
+    BuildMips(&pixels, kLayerSize);
+    return pixels;
+  }
+  for (int row = 0; row < kLayerSize; ++row) {
+    const int src_row = row * y / kLayerSize;
+    for (int col = 0; col < kLayerSize; ++col) {
+      const int src_col = col * x / kLayerSize;
+      const unsigned char *src = data + (src_row * x + src_col) * 3;
+      unsigned char *dst = &pixels[(row * kLayerSize + col) * 3];
+      dst[0] = src[0];
+      dst[1] = src[1];
+      dst[2] = src[2];
+    }
+  }
+  stbi_image_free(data);
+  BuildMips(&pixels, kLayerSize);
+  return pixels;
+}
+
+// Uploads every level of a decoded material into a layer
+//   Only the layer is written, the other layers' mipmaps are left alone
+//   The rows of the smallest RGB levels aren't 4 byte aligned
+void TextureStreamer::Upload(const unsigned char layer, const std::vector<unsigned char> &pixels) {
+  backend_->BindTexture(GL_TEXTURE_2D_ARRAY, texture_);
+  backend_->PixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  unsigned int offset = 0;
+  for (int level = 0, size = kLayerSize; size >= 1; ++level, size /= 2) {
+    assert(offset + size * size * 3 <= pixels.size() && "Decoded material is missing levels");
+    backend_->TexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, size, size, 1,
+        GL_RGB, GL_UNSIGNED_BYTE, &pixels[offset]);
+    offset += size * size * 3;
+  }
+  backend_->PixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  backend_->BindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
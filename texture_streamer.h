@@ -0,0 +1,123 @@
+#ifndef ASSIGN3_TEXTURE_STREAMER_H_
+#define ASSIGN3_TEXTURE_STREAMER_H_
+
+#include <vector>
+#include <string>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdio>
+#include <cassert>
+
+#include <GL/glew.h>
+#include "render_backend.h"
+
+// Streams a set of same sized materials into the layers of one 2D texture array
+//   Materials are decoded, resized and mipmapped on a worker thread when
+//   requested and uploaded on the GL thread in Update(). Only kLayers materials are ever
+//   resident, a layer is reused once every tile using it has been released
+//   Material 0 is loaded on construction and pinned to layer 0 so there is
+//   always something to fall back to
+//   It is created and uploaded through a RenderBackend so a recording counts its bytes
+//   @warn  Request, Release and Update must be called from the GL thread
+class TextureStreamer {
+  public:
+    // Construct with the materials which can be streamed
+    //   Blocks until material 0 has been uploaded
+    //   @param filenames, the image file of each material
+    //   @param backend, the backend the array is created and uploaded through
+    TextureStreamer(const std::vector<std::string> &filenames, RenderBackend * backend);
+    // Stops and joins the worker thread
+    ~TextureStreamer();
+
+    // Marks the material as used by a tile, decoding it if it isn't resident
+    //   @param material, the index into the filenames
+    //   @return  The material granted, material 0 when all layers are in use
+    //   @warn  the returned material is the one to Release
+    unsigned char Request(const unsigned char material);
+    // Marks the material as no longer used by a tile
+    //   Once unused its layer can be reused
+    //   @param material, the index into the filenames
+    void Release(const unsigned char material);
+    // Uploads any finished decodes into their layers
+    //   Should be called once per tick
+    void Update();
+
+    // Accessor for the texture array
+    inline GLuint texture() const;
+    // Accessor for the amount of materials that can be requested
+    inline unsigned char material_count() const;
+    // The layer to sample for the material
+    //   @return  layer 0 if the material is not uploaded yet
+    float layer(const unsigned char material) const;
+
+  private:
+    // CONSTANTS
+    // The width and height every material is resized to
+    static const int kLayerSize = 512;
+    // The amount of layers, i.e. the maximum resident materials
+    //   kLayers * kLayerSize^2 * 3 * 4/3 (mips) bytes of texture memory
+    //   Fewer than the terrain's materials, layers are reused as tiles pass
+    static const unsigned char kLayers = 3;
+
+    // A decoded material waiting for upload
+    struct Decoded {
+      unsigned char layer;
+      unsigned char material;
+      // Every level, largest first
+      std::vector<unsigned char> pixels;
+    };
+    // A layer of the texture array
+    struct Layer {
+      // The material in the layer
+      int material;
+      // The amount of tiles using the layer
+      unsigned int uses;
+      // Whether the material has been uploaded
+      bool is_ready;
+    };
+
+    // The image file of each material
+    const std::vector<std::string> filenames_;
+    // The backend the array is created and uploaded through
+    RenderBackend * const backend_;
+    // The GL texture array
+    GLuint texture_;
+    // The state of each layer
+    Layer layers_[kLayers];
+
+    // WORKER THREAD
+    // Layer and material pairs to decode
+    std::queue<std::pair<unsigned char, unsigned char> > requests_;
+    // Decoded materials to upload
+    std::queue<Decoded> decoded_;
+    // Guards requests_, decoded_ and is_running_
+    std::mutex mutex_;
+    // Wakes the worker up on new requests
+    std::condition_variable condition_;
+    // Cleared on destruction to stop the worker
+    bool is_running_;
+    // The worker decoding images
+    std::thread worker_;
+
+    // The worker loop, decodes requests until stopped
+    void Work();
+    // Loads and resizes an image to kLayerSize x kLayerSize RGB with its mipmaps
+    //   @param filename, the image file
+    //   @return  Every level, largest first, grey if the file couldn't be loaded
+    std::vector<unsigned char> Decode(const std::string &filename) const;
+    // Uploads every level of a decoded material into a layer
+    void Upload(const unsigned char layer, const std::vector<unsigned char> &pixels);
+};
+
+// Accessor for the texture array
+inline GLuint TextureStreamer::texture() const {
+  return texture_;
+}
+// Accessor for the amount of materials that can be requested
+inline unsigned char TextureStreamer::material_count() const {
+  return filenames_.size();
+}
+
+#endif
@@ -0,0 +1,854 @@
+#include "tile_generator.h"
+
+#include "glm/gtx/rotate_vector.hpp"
+
+// Construct with width and height specified
+//   @param width, the amount of vertices across a tile (a multiple of 32)
+//   @param height, the amount of vertices along a tile (equal to width)
+//   @param seed, the seed of the random engine
+TileGenerator::TileGenerator(const int width, const int height, const unsigned int seed) :
+  // Setup Constants
+  x_length_(width), z_length_(height), length_multiplier_(width / 32), kRandomIterations(10000*length_multiplier_),
+  indices_(InitializeIndices()),
+  // 31 quads in row, 2 triangles in quad, 3 rows, 3 vertices per triangle
+  //   Above based on 32 x_length_ & z_length_
+  road_indice_count_((x_length_-1)*2*((18-15)*length_multiplier_)*3),
+  // Default vars
+  engine_(seed), next_turn_(kStraight),
+  rotation_(0), prev_rotation_(0), z_smooth_max_(10 * length_multiplier_), is_first_tile_(true),
+  // Scratch buffers for generation
+  workspace_(new TerrainWorkspace()) {
+    prev_cliff_x3_rand_ = Random() % 20 + 1;
+    prev_water_x3_rand_ = Random() % 15 + 5;
+    prev_spacing_rand_ = (Random() % 100)*0.003f - 0.15f;
+    // Setup Vars
+    workspace_->heights.resize(x_length_ * z_length_); // Initialize to 0 to avoid seg fault during smoothing
+    workspace_->vertices.resize(x_length_ * z_length_); // Initialize to 0 to avoid seg fault during smoothing
+    workspace_->normals.resize(x_length_ * z_length_);  // Initialize to 0 to avoid seg fault during smoothing
+    // Reserve the largest outputs so generation never reallocates
+    workspace_->adaptive_indices.reserve(indices_.size());
+    workspace_->vertices_road.reserve((4*length_multiplier_)*z_length_);
+    workspace_->boundary_pairs.reserve(z_length_);
+    workspace_->water_side.reserve((15*length_multiplier_)*z_length_);
+    workspace_->cliff_side.reserve(1*z_length_);
+    next_tile_start_ = glm::vec2(-10,-10);
+    // Height randomization vars
+    int center_left_x = x_length_/2 - x_length_/4;
+    int center_z = z_length_ - z_length_/2;
+    x_water_position_ = center_left_x, z_water_position_ = center_z;
+    int center_right_x = x_length_ - x_length_/2;
+    x_cliff_position_ = center_right_x, z_cliff_position_ = center_z;
+  }
+
+// Frees the workspace
+TileGenerator::~TileGenerator() {
+  delete workspace_;
+}
+
+// A random non negative integer from the generator's own engine
+//   Used in place of rand() so generators on different threads don't share state
+int TileGenerator::Random() {
+  return engine_();
+}
+
+// Picks the turn type and connection smoothing of the next tile
+//   To be called once before each generated tile (except the starting tiles)
+void TileGenerator::BeginTile() {
+  // TODO add different chances to the turn types
+  next_turn_ = RoadType(Random() % 3);
+  z_smooth_max_ = (Random() % 3 + 8)*length_multiplier_;
+}
+
+// Generates the vertices of the tile along the road_type curve
+//   Moves next_tile_start and rotation on to the end of the tile
+//   @param road_type, the tile type to generate e.g. kStraight, kTurnLeft etc.
+void TileGenerator::MakeVertices(const RoadType road_type) {
+  // Expand spacing of tiles subtly
+  float v = (Random() % 100)*0.003f - 0.15f;
+  prev_spacing_rand_ += v;
+  if (prev_spacing_rand_ < 20)
+    prev_spacing_rand_ = 20;
+  else if (prev_spacing_rand_ > 25)
+    prev_spacing_rand_ = 25;
+  HelperMakeVertices(road_type, 0, prev_spacing_rand_);
+}
+
+// Generates the indices of an unsimplified tile
+// @note  These don't change for the same x_length_ * z_length_ height maps
+// @return  A vector of indices for generating normals
+std::vector<int> TileGenerator::InitializeIndices() const {
+  // CONSTRUCT HEIGHT MAP INDICES
+  // 2 triangles for every quad of the terrain mesh
+  const unsigned int numTriangles = ( x_length_ - 1 ) * ( z_length_ - 1 ) * 2;
+  // The indices generated for all the terrain and water tiles
+  //   These should only be generated once as x_lengths and z_lengths are the
+  //   same between tiles.
+  std::vector<int> indices(numTriangles * 3);
+  unsigned int index = 0; // Index in the index buffer
+  for (int j = 0; j < (z_length_ - 1); ++j )
+  {
+    for (int i = 0; i < (x_length_ - 1); ++i )
+    {
+      int vertexIndex = ( j * x_length_ ) + i;
+      // Top triangle (T0)
+      indices[index++] = vertexIndex;                        // V0
+      indices[index++] = vertexIndex + x_length_ + 1;        // V3
+      indices[index++] = vertexIndex + 1;                    // V1
+      // Bottom triangle (T1)
+      indices[index++] = vertexIndex;                        // V0
+      indices[index++] = vertexIndex + x_length_;            // V2
+      indices[index++] = vertexIndex + x_length_ + 1;        // V3
+    }
+  }
+
+  return indices;
+}
+
+// Model the heights using an X^3 mathematical functions, then randomize heights
+// for all vertices in heightmap
+//   @param  start  Index to start looping from, 0 starts a new tile
+//   @param  end    Index to finish the loop
+//   @warn pretty expensive operation 10000*2 loops
+//   @warn spread over a couple of loops
+void TileGenerator::MakeHeights(const int start, const int end) {
+  if (start == 0) {
+
+    // Store the connecting row to smooth
+    workspace_->temp_last_row_heights.assign(workspace_->heights.end()-x_length_, workspace_->heights.end());
+
+    // Generate base model of terrain (X^3 i.e. cubic)
+    prev_cliff_x3_rand_ += Random() % 8 - 4; //flucuation of the cliff base height
+    if (prev_cliff_x3_rand_ < 5)
+      prev_cliff_x3_rand_ = 5;
+    else if (prev_cliff_x3_rand_ > 20)
+      prev_cliff_x3_rand_ = 20;
+    prev_water_x3_rand_ += Random() % 6 - 3; //flucuation of the water base height
+    if (prev_water_x3_rand_ < 5)
+      prev_water_x3_rand_ = 5;
+    else if (prev_water_x3_rand_ > 20)
+      prev_water_x3_rand_ = 20;
+    for (int z = 0; z < z_length_; ++z) {
+      for (int x = 0; x < x_length_; ++x) {
+        // Normalize x between -1 and 1
+        float norm_x = (float)x / (x_length_-1);
+        norm_x *= 2.0;
+        norm_x -= 1.0;
+
+        // Height modelled using X^3
+        if (x > x_length_/2) {
+          workspace_->heights.at(x+z*x_length_) = prev_cliff_x3_rand_*(norm_x*norm_x*norm_x);
+        } else {
+          workspace_->heights.at(x+z*x_length_) = prev_water_x3_rand_*(norm_x*norm_x*norm_x);
+        }
+      }
+    }
+  }
+
+  // Randomize Bottom Terrain
+  for (int i = start; i < end; ++i) {
+    int v = Random() % 4 + 1;
+    switch(v) {
+      case 1: x_water_position_++;
+              break;
+      case 2: x_water_position_--;
+              break;
+      case 3: z_water_position_++;
+              break;
+      case 4: z_water_position_--;
+              break;
+    }
+    if (x_water_position_ < 0) {
+      x_water_position_ = x_length_/2-2 * length_multiplier_;
+      continue;
+    } else if (x_water_position_ > x_length_/2-2 * length_multiplier_) {
+      x_water_position_ = 0;
+      continue;
+    }
+    if (z_water_position_ < 0) {
+      z_water_position_ = z_length_-1;
+      continue;
+    } else if (z_water_position_ > z_length_-1) {
+      z_water_position_ = 0;
+      continue;
+    }
+    workspace_->heights.at(x_water_position_ + z_water_position_*x_length_) -= 0.100f;
+  }
+
+  // Randomize Top Terrain
+  for (int i = start; i < end; ++i) {
+    int v = Random() % 4 + 1;
+    switch(v) {
+      case 1: x_cliff_position_++;
+              break;
+      case 2: x_cliff_position_--;
+              break;
+      case 3: z_cliff_position_++;
+              break;
+      case 4: z_cliff_position_--;
+              break;
+    }
+    if (x_cliff_position_ < x_length_/2+4 * length_multiplier_) {
+      x_cliff_position_ = x_length_-1;
+      continue;
+    } else if (x_cliff_position_ > x_length_-1) {
+      x_cliff_position_ = x_length_/2+4 * length_multiplier_;
+      continue;
+    }
+    if (z_cliff_position_ < 0) {
+      z_cliff_position_ = z_length_-1;
+      continue;
+    } else if (z_cliff_position_ > z_length_-1) {
+      z_cliff_position_ = 0;
+      continue;
+    }
+    workspace_->heights.at(x_cliff_position_ + z_cliff_position_*x_length_) += 0.100f;
+  }
+
+}
+
+// Smooths the terrain at the connections
+//   Spreads the load over 2 ticks
+//   @param bool, whether or not this is the first call
+//   @warn requires a last row member
+//   @warn AverageVector modifies the workspace heights
+void TileGenerator::MakeSmoothHeights(const bool is_first_call) {
+  if (is_first_call) {
+    // EXTEND FLOOR (REMOVES LONG DISTANCE ARTEFACTS)
+    int x = 0; // last is constant
+    for (int z = 0; z < z_length_; ++z) {
+      workspace_->heights.at(x + z*x_length_) = -40.0f;
+    }
+    // for (int x = 1; x < 4; ++x) {
+    //   for (int z = 0; z < z_length_; ++z) {
+    //     workspace_->heights.at(x + z*x_length_) -= 20.0f;
+    //   }
+    // }
+
+    // SMOOTH CONNECTIONS
+    // Compare connection rows to eachother and smooth new one
+    for (int x = 0; x < x_length_; ++x) {
+      workspace_->heights.at(x+0*x_length_) = workspace_->temp_last_row_heights.at(x);
+      // workspace_->heights.at(x+0*x_length_) = 0;
+    }
+
+    // SMOOTH WATER TERRAIN
+    AverageVector(1, x_length_/2-4, workspace_->heights, workspace_->temp_last_row_heights);
+    return;
+  } 
+  // SMOOTH CLIFF TERRAIN
+  AverageVector((x_length_/2+5), x_length_-1, workspace_->heights, workspace_->temp_last_row_heights);
+  AverageVector((x_length_/2+5), x_length_-1, workspace_->heights, workspace_->temp_last_row_heights);
+  // AverageVector((x_length_/2+15), x_length_-1, workspace_->heights, workspace_->temp_last_row_heights);
+  // AverageVector((x_length_/2+15), x_length_-1, workspace_->heights, workspace_->temp_last_row_heights);
+  // AverageVector((x_length_/2+15), x_length_-1, workspace_->heights, workspace_->temp_last_row_heights);
+
+}
+
+// Averages the given member to smooth the terrain
+//   Has a range for X but runs through the entire Z plane (for splitting water 
+//   and cliff
+//   @param start, the start of the heightmap in the X plane
+//   @param end,   the end of the heightmap in the X plane
+//   @param vec_t, a reference to a vector which contains heightmap values or vec3 and
+//             will be modified. Infact any vector type with + and /= element operators
+//             should work.
+//   @param vec_other_t, a reference to a vector which contains @vec_t values from the
+//                       previous tile
+//   @warn @a vec_t member is modified
+template<typename T>
+void TileGenerator::AverageVector(const int start, const int end, std::vector<T> &vec_t, const std::vector<T> &vec_other_t) {
+  int z = 0;
+  int x = start;
+  for (; x < end; ++x) {
+    // Get all elements around center
+    //   Orientation is from car start facing
+    T &center = vec_t.at(x + z*x_length_);
+    const T &left = vec_t.at(x+1 + z*x_length_);
+    const T &right = vec_t.at(x-1 + z*x_length_);
+    const T &bot = vec_other_t.at(x);
+    const T &top = vec_t.at(x + (z+1)*x_length_);
+    const T &top_left = vec_t.at(x+1 + (z+1)*x_length_);
+    const T &top_right = vec_t.at(x-1 + (z+1)*x_length_);
+    const T &bot_left = vec_other_t.at(x+1);
+    const T &bot_right = vec_other_t.at(x-1);
+
+    T average = (center+top+bot+left+right
+        +top_left+top_right+bot_left+bot_right);
+    average /= 9.0f;
+    center = average;  //pass by reference
+  }
+  // new scope
+  {
+    x = end;
+    // Get all elements around center
+    //   Orientation is from car start facing
+    T &center = vec_t.at(x + z*x_length_);
+    const T &left = T();
+    const T &right = vec_t.at(x-1 + z*x_length_);
+    const T &bot = vec_other_t.at(x);
+    const T &top = vec_t.at(x + (z+1)*x_length_);
+    const T &top_left = T();
+    const T &top_right = vec_t.at(x-1 + (z+1)*x_length_);
+    const T &bot_left = T();
+    const T &bot_right = vec_other_t.at(x-1);
+
+    T average = (center+top+bot+left+right
+        +top_left+top_right+bot_left+bot_right);
+    average /= 9.0f;
+    center = average;  //pass by reference
+  }
+
+  z = 1;
+  for (; z < z_length_ - 1; ++z) {
+    int x = start;
+    for (; x < end; ++x) {
+      // Get all elements around center
+      //   Orientation is from car start facing
+      T &center = vec_t.at(x + z*x_length_);
+      const T &left = vec_t.at(x+1 + z*x_length_);
+      const T &right = vec_t.at(x-1 + z*x_length_);
+      const T &bot = vec_t.at(x + (z-1)*x_length_);
+      const T &top = vec_t.at(x + (z+1)*x_length_);
+      const T &top_left = vec_t.at(x+1 + (z+1)*x_length_);
+      const T &top_right = vec_t.at(x-1 + (z+1)*x_length_);
+      const T &bot_left = vec_t.at(x+1 + (z-1)*x_length_);
+      const T &bot_right = vec_t.at(x-1 + (z-1)*x_length_);
+
+      T average = (center+top+bot+left+right
+          +top_left+top_right+bot_left+bot_right);
+      average /= 9.0f;
+      center = average;  //pass by reference
+    }
+    x = end;
+    // Get all elements around center
+    //   Orientation is from car start facing
+    T &center = vec_t.at(x + z*x_length_);
+    const T &left = T();
+    const T &right = vec_t.at(x-1 + z*x_length_);
+    const T &bot = vec_t.at(x + (z-1)*x_length_);
+    const T &top = vec_t.at(x + (z+1)*x_length_);
+    const T &top_left = T();
+    const T &top_right = vec_t.at(x-1 + (z+1)*x_length_);
+    const T &bot_left = T();
+    const T &bot_right = vec_t.at(x-1 + (z-1)*x_length_);
+
+    T average = (center+top+bot+left+right
+        +top_left+top_right+bot_left+bot_right);
+    average /= 9.0f;
+    center = average;  //pass by reference
+  }
+  z = z_length_-1;
+  for (x = start; x < end; ++x) {
+    // Get all elements around center
+    //   Orientation is from car start facing
+    T &center = vec_t.at(x + z*x_length_);
+    const T &left = vec_t.at(x+1 + z*x_length_);
+    const T &right = vec_t.at(x-1 + z*x_length_);
+    const T &bot = vec_t.at(x + (z-1)*x_length_);
+    const T &bot_left = vec_t.at(x+1 + (z-1)*x_length_);
+    const T &bot_right = vec_t.at(x-1 + (z-1)*x_length_);
+    T average = (center+bot+left+right
+        +bot_left+bot_right);
+    average /= 6.0f;
+    center = average;  //pass by reference
+  }
+  // New scope
+  {
+    x = end;
+    // Get all elements around center
+    //   Orientation is from car start facing
+    T &center = vec_t.at(x + z*x_length_);
+    const T &left = T();
+    const T &right = vec_t.at(x-1 + z*x_length_);
+    const T &bot = vec_t.at(x + (z-1)*x_length_);
+    const T &top_left = T();
+    const T &bot_left = T();
+    const T &bot_right = vec_t.at(x-1 + (z-1)*x_length_);
+
+    T average = (center+bot+left+right
+        +top_left+bot_left+bot_right);
+    average /= 7.0f;
+    center = average;  //pass by reference
+  }
+}
+
+// Overloaded function to generate a square height map on the X/Z plane. Different
+// road_type parameters can be added to curve the Z coordinates and hence make turning
+// pieces.
+// @param  road_type       An enum representing the mathematical model to be applied to Z
+// @param  min_position    The relative start position of the heightmap over X/Z
+// @param  position_range  The spread of the heightmap over X/Z 
+// @warn  No changes can be made to the workspace vertices until the Road Helpers complete
+void TileGenerator::HelperMakeVertices(const RoadType road_type,
+    const float min_position, const float position_range) {
+  // Store the connecting row to smooth
+  std::vector<glm::vec3>::iterator z_smooth_begin = workspace_->vertices.end()-1*x_length_;
+  std::vector<glm::vec3>::iterator z_smooth_end = workspace_->vertices.end()-0*x_length_;
+  std::vector<glm::vec3> &temp_last_row_vertices = workspace_->temp_last_row_vertices;
+  temp_last_row_vertices.assign(z_smooth_begin, z_smooth_end);
+
+  // Zero vertice vector
+  // workspace_->vertices.assign(x_length_ * z_length_, glm::vec3());
+
+  int offset;
+  // First, build the data for the vertex buffer
+  for (int z = 0; z < z_length_; z++) {
+    for (int x = 0; x < x_length_; x++) {
+      offset = (z*x_length_)+x;
+      float xRatio = x / (float) (x_length_ - 1);
+
+      // Build our heightmap from the top down, so that our triangles are 
+      // counter-clockwise.
+      float zRatio = (z / (float) (z_length_ - 1));
+
+      float xPosition = min_position + (xRatio * position_range);
+      float yPosition = workspace_->heights.at(offset);
+      float zPosition = min_position + (zRatio * position_range);
+
+      // Curve addition
+      switch(road_type) {
+        // case 0: straight road => do nothing
+        case kStraight:
+          break;
+        // case 1: x^2 turnning road
+        case kTurnLeft:
+          {
+            float zSquare = zPosition * zPosition; //x^2
+            xPosition = zSquare/(position_range*5.5) + xPosition;
+            break;
+          }
+        case kTurnRight:
+          {
+            float zSquare = zPosition * zPosition; //x^2
+            xPosition = -zSquare/(position_range*5.5) + xPosition;
+            break;
+          }
+      }
+
+      workspace_->vertices.at(offset) = glm::vec3(xPosition, yPosition, zPosition);
+    }
+  }
+  // special point for finding pivot translation
+  unsigned int pivot_x = 18 * length_multiplier_; // relative tile x position of pivot
+  const glm::vec3 &pivot = workspace_->vertices.at(pivot_x);
+  // pivot.y = 10000.0f;
+  // Rotate the point using glm function
+  glm::vec3 rotated = glm::rotateY(pivot, rotation_);
+  float translate_x = pivot.x - rotated.x;
+  float translate_z = pivot.z - rotated.z;
+  for (int y = 0; y < z_length_; y++) {
+    for (int x = 0; x < x_length_; x++) {
+      offset = (y*x_length_)+x;
+
+      glm::vec3 rotated = workspace_->vertices.at(offset);
+      rotated = glm::rotateY(rotated, rotation_);
+      float xPosition = rotated.x + translate_x;
+      float zPosition = rotated.z + translate_z;
+      // xPosition = rotated.x + position_range/2;
+      float yPosition = rotated.y;
+
+      workspace_->vertices.at(offset) = glm::vec3(xPosition + next_tile_start_.x, yPosition,
+          zPosition + next_tile_start_.y);
+    }
+  }
+  const glm::vec3 &pivot_end = workspace_->vertices.at(pivot_x + (z_length_-1)*x_length_);
+  // Set next z position
+  next_tile_start_.y = pivot_end.z;
+
+  // Calculate next_tile_start_.x position (next X tile position)
+  float displacement_x = pivot_end.x - pivot.x;
+  next_tile_start_.x += displacement_x;
+  switch(road_type) {
+    // A straight road keeps the rotation
+    case kStraight:
+      break;
+    case kTurnLeft:
+      {
+        // generate random number between 18.00 and 24.99
+        float random = Random() % 700 / 100.0f + 18;
+        rotation_ += random;
+        // rotation_ += 18.0f;
+        break;
+      }
+    case kTurnRight:
+      {
+        // generate random number between 18.00 and 24.99
+        float random = Random() % 700 / 100.0f + 18;
+        rotation_ -= random;
+        break;
+      }
+  }
+
+  // Make Left side infinite
+  float const cos_rot = cos(DEG2RAD(prev_rotation_)); //optimization
+  float const sin_rot = -sin(DEG2RAD(prev_rotation_)); //optimization
+  prev_rotation_ = rotation_;
+  for (int x = 0; x < 4; ++x) {
+    for (int z = 0; z < z_length_; ++z) {
+      float &vert_x = workspace_->vertices.at((x_length_-x-1)+z*x_length_).x;
+      vert_x += 40 * cos_rot;
+      float &vert_z = workspace_->vertices.at((x_length_-x-1)+z*x_length_).z;
+      vert_z += 40 * sin_rot;
+    }
+  }
+  // Make Right side infinite
+  for (int x = 0; x < 4; ++x) {
+    for (int z = 0; z < z_length_; ++z) {
+      float &vert_x = workspace_->vertices.at(x+z*x_length_).x;
+      vert_x -= 40 * cos_rot;
+      float &vert_z = workspace_->vertices.at(x+z*x_length_).z;
+      vert_z -= 40 * sin_rot;
+    }
+  }
+  // Give left side structure - RELAX O(4N)
+  for (int x = 0; x < 4; ++x) {
+    // Try to remove first couple layers going too high
+    int z = 0;
+    // while (z <= z_smooth_max_) {
+    //   float &vert_y = workspace_->vertices.at((x_length_-x-1)+z*x_length_).y;
+    //     vert_y = -20.0f;
+    //   ++z;
+    // }
+    // Randomly decrease slope
+    int r = Random() % 40 + 10;
+    for (; z < z_length_; ++z) {
+      float &vert_y = workspace_->vertices.at((x_length_-x-1)+z*x_length_).y;
+      vert_y -= r;
+    }
+  }
+  // The first tile has no previous row to connect to
+  //   Smoothing towards the zeroed workspace would collapse its first rows
+  if (is_first_tile_) {
+    is_first_tile_ = false;
+    return;
+  }
+  // SMOOTH CONNECTIONS
+  // Compare connection rows to eachother and smooth new one
+  std::vector<glm::vec3> translate_column_by;
+  for (int x = 0; x < x_length_; ++x) {
+    glm::vec3 dis_between_smooth = workspace_->vertices.at(x+(z_smooth_max_)*x_length_) - temp_last_row_vertices.at(x+0*x_length_);
+    dis_between_smooth.x /= z_smooth_max_;
+    dis_between_smooth.z /= z_smooth_max_;
+    glm::vec3 new_column_size = dis_between_smooth;
+    glm::vec3 translate_by = new_column_size;
+    translate_column_by.push_back(translate_by);
+    // printf("trans = %f,%f\n",translate_by.x,translate_by.z);
+  }
+  for (unsigned int z = 0; z < z_smooth_max_; ++z) {
+    for (int x = 0; x < x_length_; ++x) {
+      float &vert_x = workspace_->vertices.at(x+z*x_length_).x;
+      vert_x = temp_last_row_vertices.at(x).x + z * translate_column_by.at(x).x;
+
+      float &vert_z = workspace_->vertices.at(x+z*x_length_).z;
+      vert_z = temp_last_row_vertices.at(x).z + z * translate_column_by.at(x).z;
+    }
+  }
+  // Ensure heights are connected
+  for (int x = 0; x < x_length_; ++x) {
+    float &vert_y = workspace_->vertices.at(x+0*x_length_).y;
+    vert_y = temp_last_row_vertices.at(x).y;
+  }
+
+  // Smooth left side structure LOOKS BAD
+  // AverageVector(x_length_-4,x_length_-1,workspace_->vertices, temp_last_row_vertices);
+
+}
+
+// Generates the normals by doing a cross product of neighbouring vertices
+// @warn  No changes can be made to the workspace normals until the Road Helpers complete
+void TileGenerator::MakeNormals() {
+  // normals.assign(x_length_*z_length_, glm::vec3());
+  // Reset normals vector but save last X row to start
+  for (unsigned int i = 0, x = workspace_->normals.size()-x_length_-1;
+      x < workspace_->normals.size(); ++i, ++x) {
+    workspace_->normals.at(i) = workspace_->normals.at(x);
+  }
+  std::fill(workspace_->normals.begin()+1,workspace_->normals.end(), glm::vec3()); //fill rest with zero
+  // for ( unsigned int i = z_smooth_max_*x_length_; i < indices.size()-2; i += 3 )  {
+  for ( unsigned int i = 0; i < indices_.size()-2; i += 3 )  {
+    glm::vec3 v0 = workspace_->vertices[ indices_[i + 0] ];
+    glm::vec3 v1 = workspace_->vertices[ indices_[i + 1] ];
+    glm::vec3 v2 = workspace_->vertices[ indices_[i + 2] ];
+
+    glm::vec3 normal = glm::normalize( glm::cross( v1 - v0, v2 - v0 ) );
+    // printf("norm = (%f,%f,%f)\n",normal.x,normal.y,normal.z);
+
+    // Remove NaN normals
+    // if (normal.x != normal.x) {
+    // printf("Overlapping vertices being crossed\n");
+    // } else {
+    workspace_->normals[ indices_[i + 0] ] += normal;
+    workspace_->normals[ indices_[i + 1] ] += normal;
+    workspace_->normals[ indices_[i + 2] ] += normal;
+    // }
+  }
+
+  for ( unsigned int i = 0; i < workspace_->normals.size(); ++i ) {
+    workspace_->normals[i] = glm::normalize( workspace_->normals[i] );
+  }
+}
+
+// Generates an adaptive triangulation of the tile into the workspace
+//   The grid is split into kSimplifyBlockSize blocks, each block is either culled
+//   (under water), collapsed (within kSimplifyTolerance of its corners) or kept whole
+//   Collapsed blocks are fanned from an interior vertex and keep every edge vertex
+//   shared with a non collapsed neighbour so no cracks are introduced
+//   Triangles under the road (drawn 0.01 above) are never visible and also dropped
+//   The depth indices add them back, they stand in for the road in the shadow map
+// @warn  requires a preceeding call to HelperMakeVertices otherwise undefined behaviour
+void TileGenerator::MakeAdaptiveIndices() {
+  enum BlockState {
+    kBlockCulled = 0,
+    kBlockCollapsed = 1,
+    kBlockWhole = 2,
+  };
+  const int quads_x = x_length_ - 1;
+  const int quads_z = z_length_ - 1;
+  const int blocks_x = (quads_x + kSimplifyBlockSize - 1) / kSimplifyBlockSize;
+  const int blocks_z = (quads_z + kSimplifyBlockSize - 1) / kSimplifyBlockSize;
+  // The quads covered by the road, see InitializeIndices(kRoad)
+  const int road_start_x = 15 * length_multiplier_;
+  const int road_end_x = 18 * length_multiplier_;
+
+  // CLASSIFY BLOCKS
+  std::vector<BlockState> block_state(blocks_x * blocks_z, kBlockWhole);
+  for (int bz = 0; bz < blocks_z; ++bz) {
+    for (int bx = 0; bx < blocks_x; ++bx) {
+      const int x0 = bx * kSimplifyBlockSize;
+      const int z0 = bz * kSimplifyBlockSize;
+      const int x1 = std::min(x0 + kSimplifyBlockSize, quads_x);
+      const int z1 = std::min(z0 + kSimplifyBlockSize, quads_z);
+      BlockState &state = block_state.at(bx + bz*blocks_x);
+
+      // Under water
+      bool is_submerged = true;
+      for (int z = z0; z <= z1 && is_submerged; ++z) {
+        for (int x = x0; x <= x1; ++x) {
+          if (workspace_->vertices.at(x + z*x_length_).y >= kWaterCullHeight) {
+            is_submerged = false;
+            break;
+          }
+        }
+      }
+      if (is_submerged) {
+        state = kBlockCulled;
+        continue;
+      }
+      // Road edges follow the full resolution vertices
+      //   Too thin blocks have no interior vertex to fan from
+      if ((x0 < road_end_x + 1 && x1 > road_start_x - 1)
+          || x1 - x0 < 2 || z1 - z0 < 2)
+        continue;
+
+      // Flat, compare every vertex against the bilinear patch of the corners
+      const glm::vec3 &c00 = workspace_->vertices.at(x0 + z0*x_length_);
+      const glm::vec3 &c10 = workspace_->vertices.at(x1 + z0*x_length_);
+      const glm::vec3 &c01 = workspace_->vertices.at(x0 + z1*x_length_);
+      const glm::vec3 &c11 = workspace_->vertices.at(x1 + z1*x_length_);
+      bool is_flat = true;
+      for (int z = z0; z <= z1 && is_flat; ++z) {
+        const float v = float(z - z0) / (z1 - z0);
+        for (int x = x0; x <= x1; ++x) {
+          const float u = float(x - x0) / (x1 - x0);
+          const glm::vec3 patch = (1-v) * ((1-u)*c00 + u*c10) + v * ((1-u)*c01 + u*c11);
+          if (glm::distance(patch, workspace_->vertices.at(x + z*x_length_)) > kSimplifyTolerance) {
+            is_flat = false;
+            break;
+          }
+        }
+      }
+      if (is_flat)
+        state = kBlockCollapsed;
+    }
+  }
+
+  // EMIT INDICES
+  workspace_->adaptive_indices.clear();
+  for (int bz = 0; bz < blocks_z; ++bz) {
+    for (int bx = 0; bx < blocks_x; ++bx) {
+      const int x0 = bx * kSimplifyBlockSize;
+      const int z0 = bz * kSimplifyBlockSize;
+      const int x1 = std::min(x0 + kSimplifyBlockSize, quads_x);
+      const int z1 = std::min(z0 + kSimplifyBlockSize, quads_z);
+
+      switch(block_state.at(bx + bz*blocks_x)) {
+        case kBlockCulled:
+          break;
+        case kBlockWhole:
+          for (int j = z0; j < z1; ++j) {
+            for (int i = x0; i < x1; ++i) {
+              if (i >= road_start_x && i < road_end_x)
+                continue;
+              // Same winding as InitializeIndices
+              const int v0 = (j * x_length_) + i;
+              const int v1 = v0 + 1;
+              const int v2 = v0 + x_length_;
+              const int v3 = v0 + x_length_ + 1;
+              const float max_top = std::max(workspace_->vertices.at(v0).y,
+                  std::max(workspace_->vertices.at(v3).y, workspace_->vertices.at(v1).y));
+              const float max_bot = std::max(workspace_->vertices.at(v0).y,
+                  std::max(workspace_->vertices.at(v2).y, workspace_->vertices.at(v3).y));
+              // Top triangle (T0)
+              if (max_top >= kWaterCullHeight) {
+                workspace_->adaptive_indices.push_back(v0);
+                workspace_->adaptive_indices.push_back(v3);
+                workspace_->adaptive_indices.push_back(v1);
+              }
+              // Bottom triangle (T1)
+              if (max_bot >= kWaterCullHeight) {
+                workspace_->adaptive_indices.push_back(v0);
+                workspace_->adaptive_indices.push_back(v2);
+                workspace_->adaptive_indices.push_back(v3);
+              }
+            }
+          }
+          break;
+        case kBlockCollapsed:
+          {
+            // An edge only needs its inner vertices if the neighbour keeps them
+            //   Tile borders always keep them to match the neighbouring tiles
+            const bool is_left_full   = bx == 0
+              || block_state.at(bx-1 + bz*blocks_x) != kBlockCollapsed;
+            const bool is_right_full  = bx == blocks_x-1
+              || block_state.at(bx+1 + bz*blocks_x) != kBlockCollapsed;
+            const bool is_bottom_full = bz == 0
+              || block_state.at(bx + (bz-1)*blocks_x) != kBlockCollapsed;
+            const bool is_top_full    = bz == blocks_z-1
+              || block_state.at(bx + (bz+1)*blocks_x) != kBlockCollapsed;
+            // Walk the boundary in the same (clockwise over X/Z) order as InitializeIndices
+            std::vector<int> &boundary = workspace_->block_boundary;
+            boundary.clear();
+            for (int z = z0; z < z1; ++z)
+              if (z == z0 || is_left_full)
+                boundary.push_back(x0 + z*x_length_);
+            for (int x = x0; x < x1; ++x)
+              if (x == x0 || is_top_full)
+                boundary.push_back(x + z1*x_length_);
+            for (int z = z1; z > z0; --z)
+              if (z == z1 || is_right_full)
+                boundary.push_back(x1 + z*x_length_);
+            for (int x = x1; x > x0; --x)
+              if (x == x1 || is_bottom_full)
+                boundary.push_back(x + z0*x_length_);
+            // Fan from an interior vertex
+            const int pivot = (x0 + (x1-x0)/2) + (z0 + (z1-z0)/2)*x_length_;
+            for (unsigned int i = 0; i < boundary.size(); ++i) {
+              workspace_->adaptive_indices.push_back(pivot);
+              workspace_->adaptive_indices.push_back(boundary.at(i));
+              workspace_->adaptive_indices.push_back(boundary.at((i+1) % boundary.size()));
+            }
+            break;
+          }
+      }
+    }
+  }
+
+  // FILL THE ROAD FOR THE SHADOW MAP
+  //   The road is only 0.01 above these quads, so they cast the same shadow
+  //   from the position stream the terrain already has
+  std::vector<int> &depth_indices = workspace_->depth_indices;
+  depth_indices.assign(workspace_->adaptive_indices.begin(), workspace_->adaptive_indices.end());
+  for (int j = 0; j < quads_z; ++j) {
+    for (int i = road_start_x; i < road_end_x; ++i) {
+      // Same winding as InitializeIndices
+      const int v0 = (j * x_length_) + i;
+      const int v1 = v0 + 1;
+      const int v2 = v0 + x_length_;
+      const int v3 = v0 + x_length_ + 1;
+      depth_indices.push_back(v0);
+      depth_indices.push_back(v3);
+      depth_indices.push_back(v1);
+      depth_indices.push_back(v0);
+      depth_indices.push_back(v2);
+      depth_indices.push_back(v3);
+    }
+  }
+}
+
+// Rip the road parts of the terrain heightmap using calulcated magic numbers and store
+// these in the workspace vertices_road vector
+// @warn  requires a preceeding call to HelperMakeVertices otherwise undefined behaviour
+void TileGenerator::MakeRoadVertices() {
+  workspace_->vertices_road.clear();
+  for (int x = 15 * length_multiplier_; x < 19 * length_multiplier_; ++x) {
+    for (unsigned int z = 0; z < z_length_; ++z){
+      workspace_->vertices_road.push_back(workspace_->vertices.at(x + z*x_length_));
+      // Lift road a bit above terrain to make it visible
+      workspace_->vertices_road.back().y += 0.01f;
+      // workspace_->vertices_road.back().y += 0.01f + 0.02*rotation_;
+    }
+  }
+
+  // Store water vertices
+  std::vector<glm::vec3> &water_side = workspace_->water_side;
+  water_side.clear();
+  for (int x = 0; x < 15 * length_multiplier_; ++x) {
+    for (unsigned int z = 0; z < z_length_; ++z) {
+      water_side.push_back(workspace_->vertices.at(x + z*x_length_)); // other side vertices
+    }
+  }
+
+  // Store cliff vertices (only 1 row)
+  std::vector<glm::vec3> &cliff_side = workspace_->cliff_side;
+  cliff_side.clear();
+  // NOTE the +1 in below loop is a tweak for 96x96 terrain
+  for (int x = 19 * length_multiplier_+1; x < 20 * length_multiplier_+1; ++x) {
+    for (unsigned int z = 0; z < z_length_; ++z) {
+      cliff_side.push_back(workspace_->vertices.at(x + z*x_length_)); // other side vertices
+    }
+  }
+}
+
+// Generates a collision coordinate mapping
+//   Finds all edge vertices of road in order then pairs them with the closest vertices
+//   on the opposite side of the road
+// @warn  requires a preceeding call to MakeRoadVertices otherwise undefined behaviour
+void TileGenerator::MakeRoadCollisionMap() {
+  // NOT NECCESSARY ANYMORE 96x96 FULLY FIXES THIS
+  //
+  // unsigned int x_new_row_size = 18 * length_multiplier_ - 15 * length_multiplier_;
+  // std::vector<glm::vec3> left_side, right_side;
+  // left_side.reserve(z_length_);
+  // right_side.reserve(z_length_);
+  // // Make both sides
+  // for (unsigned int z = 0; z < z_length_; ++z){
+  //   const glm::vec3 &left = workspace_->vertices_road.at(0 + z);
+  //   const glm::vec3 &right = workspace_->vertices_road.at(z + z_length_ * (x_new_row_size));
+  //   left_side.push_back(left); // left? side vertices
+  //   right_side.push_back(right); // other side vertices
+  // }
+
+  // colisn_vec tile_map;
+  // tile_map.reserve(z_length_);
+  // std::pair<glm::vec3,glm::vec3> min_max_x_pair;
+  // // Pair left side to it's closest point on opposite side
+  // for (unsigned int z = 0; z < z_length_; ++z) {
+  //   const glm::vec3 &left = left_side.at(z);
+  //   min_max_x_pair.first = left;
+  //   float smallest_diff = glm::distance(left_side.at(z), right_side.front());
+  //   glm::vec3 closest_point = right_side.front();
+  //   for (unsigned int x = 1; x < z_length_; ++x) {
+  //     float curr_diff = glm::distance(left_side.at(z), right_side.at(x));
+  //     if (curr_diff < smallest_diff) {
+  //       smallest_diff = curr_diff;
+  //       closest_point = right_side.at(x);
+  //     }
+  //   }
+  //   min_max_x_pair.second = closest_point;
+  //
+  //   tile_map.push_back(min_max_x_pair); // doesnt insert when duplicate
+  // }
+
+  unsigned int x_new_row_size = 18 * length_multiplier_ - 15 * length_multiplier_;
+  std::vector<std::pair<glm::vec3, glm::vec3> > &tile_map = workspace_->boundary_pairs;
+  tile_map.clear();
+  std::pair<glm::vec3,glm::vec3> min_max_x_pair;
+  for (unsigned int z = 0; z < z_length_; ++z){
+    const glm::vec3 &left = workspace_->vertices_road.at(0 + z);
+    const glm::vec3 &right = workspace_->vertices_road.at(z + z_length_ * (x_new_row_size));
+    min_max_x_pair.first = left; // left? side vertices
+    min_max_x_pair.second = right; // other side vertices
+
+    tile_map.push_back(min_max_x_pair);
+  }
+}
@@ -0,0 +1,257 @@
+#ifndef ASSIGN3_TILE_GENERATOR_H_
+#define ASSIGN3_TILE_GENERATOR_H_
+
+#include <vector>
+#include <cmath>
+#include <random>
+#include <algorithm>
+
+#include "constants.h"
+
+#include "glm/glm.hpp"
+
+// Scratch buffers used while generating a single tile
+//   Allocated apart from the Terrain render state so that generation doesn't
+//   share cache lines with the per frame fields, and reused between tiles
+struct TerrainWorkspace {
+  // Vertices to be generated for next terrain (or water) tile
+  std::vector<glm::vec3> vertices;
+  // Normals to be generated for the next terrain (or water) tile
+  std::vector<glm::vec3> normals;
+  // This vector is used to build heights and smooths previous tile connections
+  std::vector<float> heights;
+  // The adaptive indices to be generated for the next terrain tile
+  //   Drops triangles that are hidden under water or road, and collapses flat blocks
+  std::vector<int> adaptive_indices;
+  // The indices drawn into the shadow map for the next terrain tile
+  //   The adaptive indices with the hole under the road filled, so the road
+  //   itself needn't cast a shadow
+  std::vector<int> depth_indices;
+  // Vertices to be generated for the next road tile
+  std::vector<glm::vec3> vertices_road;
+  // The edge vertice pairs of the next road tile, see Terrain::colisn_boundary_pairs
+  std::vector<std::pair<glm::vec3, glm::vec3> > boundary_pairs;
+  // The water side vertices of the next tile for collision checking
+  std::vector<glm::vec3> water_side;
+  // The cliff side vertices of the next tile for collision checking
+  std::vector<glm::vec3> cliff_side;
+  // The last row used for smoothing
+  std::vector<float> temp_last_row_heights;
+  // The last row of vertices used for smoothing the tile connection
+  std::vector<glm::vec3> temp_last_row_vertices;
+  // The boundary of a collapsed block while making the adaptive indices
+  std::vector<int> block_boundary;
+};
+
+// The CPU half of the terrain tile pipeline
+//   Builds the heights, vertices, normals, road and collision data of one tile
+//   after another into its workspace, without touching OpenGL. Terrain drives
+//   the stages over several ticks and uploads the results, the soak harness
+//   drives them back to back on many threads
+//   Every generator has its own random engine so instances are independent
+class TileGenerator {
+  public:
+    // The turn type of a tile
+    enum RoadType {
+      kStraight = 0,
+      kTurnLeft = 1,
+      kTurnRight = 2,
+    };
+
+    // Construct with width and height specified
+    //   @param width, the amount of vertices across a tile (a multiple of 32)
+    //   @param height, the amount of vertices along a tile (equal to width)
+    //   @param seed, the seed of the random engine
+    TileGenerator(const int width, const int height, const unsigned int seed);
+    // Frees the workspace
+    ~TileGenerator();
+
+    // A random non negative integer from the generator's own engine
+    int Random();
+    // Picks the turn type and connection smoothing of the next tile
+    //   To be called once before each generated tile (except the starting tiles)
+    void BeginTile();
+
+    // Model the heights using an X^3 mathematical functions, then randomize heights
+    // for all vertices in heightmap
+    //   @param  start  Index to start looping from, 0 starts a new tile
+    //   @param  end    Index to finish the loop
+    //   @warn pretty expensive operation, see random_iterations
+    void MakeHeights(const int start, const int end);
+    // Smooths the terrain at the connections
+    //   Spreads the load over 2 calls
+    //   @param bool, whether or not this is the first call
+    void MakeSmoothHeights(const bool is_first_call);
+    // Generates the vertices of the tile along the road_type curve
+    //   Moves next_tile_start and rotation on to the end of the tile
+    //   @param road_type, the tile type to generate e.g. kStraight, kTurnLeft etc.
+    void MakeVertices(const RoadType road_type);
+    // Generates the normals by doing a cross product of neighbouring vertices
+    void MakeNormals();
+    // Rips the road, water side and cliff side vertices from the tile
+    // @warn  requires a preceeding call to MakeVertices otherwise undefined behaviour
+    void MakeRoadVertices();
+    // Generates a collision coordinate mapping of the road edges
+    // @warn  requires a preceeding call to MakeRoadVertices otherwise undefined behaviour
+    void MakeRoadCollisionMap();
+    // Generates an adaptive triangulation of the tile
+    //   The grid is split into kSimplifyBlockSize blocks, each block is either culled
+    //   (under water), collapsed (within kSimplifyTolerance of its corners) or kept whole
+    //   Also makes the depth indices, which cover the road
+    // @warn  requires a preceeding call to MakeVertices otherwise undefined behaviour
+    void MakeAdaptiveIndices();
+
+    // Accessor for the buffers of the tile being generated
+    inline const TerrainWorkspace * workspace() const;
+    // Accessor for the turn type of the next tile
+    inline RoadType next_turn() const;
+    // Accessor for the X/Z position the next tile will start from (road pivot)
+    inline const glm::vec2 &next_tile_start() const;
+    // Accessor for the heading of the next tile in degrees from positive z
+    inline float rotation() const;
+    // Accessor for the cubic base height of the cliff side
+    inline float cliff_height() const;
+    // Accessor for the cubic base height of the water side
+    inline float water_height() const;
+    // Accessor for the amount of height randomizing iterations in a tile
+    //   MakeHeights should be called over [0, random_iterations)
+    inline int random_iterations() const;
+    // Accessor for the amount of indices in an unsimplified tile
+    inline unsigned int indice_count() const;
+    // Accessor for the amount of indices in a road tile
+    inline unsigned int road_indice_count() const;
+
+  private:
+    // CONSTANTS
+    // Width of the heightmap
+    const unsigned char x_length_;
+    // Height of the heightmap
+    const unsigned char z_length_;
+    // The multiplier for all magic numbers
+    //   @warn this requires a square heightmap
+    //   @warn dimensions should be multiples of 32
+    const char length_multiplier_;
+    // The maximum number of randomizing height generation iterations
+    const int kRandomIterations;
+    // The amount of quads per side of an adaptive triangulation block
+    const unsigned char kSimplifyBlockSize = 5;
+    // Triangles with all vertices below this height are hidden by the water
+    //   The water plane sits at -3 and its waves dip at most ~1.7 below that
+    const float kWaterCullHeight = -5.0f;
+    // The screen space error allowed when collapsing a block (in pixels)
+    const float kSimplifyPixelError = 1.0f;
+    // The closest distance a collapsed block is expected to be viewed from
+    const float kSimplifyViewDistance = 8.0f;
+    // The world space error allowed when collapsing a block
+    //   Derived from the above using the default 55 degree fov and 480 pixel high window
+    const float kSimplifyTolerance = kSimplifyPixelError * 2.0f * kSimplifyViewDistance
+      * tan(DEG2RAD(55.0f / 2.0f)) / 480.0f;
+    // The indices generated for all the tiles
+    //   These should only be generated once as x_lengths and z_lengths are the
+    //   same between tiles.
+    const std::vector<int> indices_;
+    // The amount of indices in a road tile
+    const unsigned int road_indice_count_;
+
+    // GENERATION STATE
+    // The random engine, seeded on construction
+    std::minstd_rand engine_;
+    // The x and y positions of the height randomization for the (left) cliff part
+    int x_cliff_position_;
+    int z_cliff_position_;
+    // The x and y positions of the height randomization for the (right) water part
+    int x_water_position_;
+    int z_water_position_;
+    // The turn type of the next tile
+    RoadType next_turn_;
+    // The previous random value used to generate the cliff and water (X^3 i.e. cubic) base heights
+    //   Used to ensure there are no sudden peaks and for extra feel
+    char prev_cliff_x3_rand_;
+    char prev_water_x3_rand_;
+    // The previous random value used to generate next spacing of tile
+    float prev_spacing_rand_;
+    // The current X,Z displacement from zero
+    //   Used for joining tiles
+    glm::vec2 next_tile_start_;
+    // Current road tile end rotation
+    //   The rotation of the entire next tile from positive z
+    //   Positive degrees rotate leftwards (anti cw from spidermans facing)
+    float rotation_;
+    // The above used for UV stretch correction;
+    float prev_rotation_;
+    // The amount of (tile relative) Z rows from the back to smooth
+    //   Is needed to connect rotated rows
+    unsigned int z_smooth_max_;
+    // Whether no tile has been generated yet
+    //   The first tile isn't connected to anything
+    bool is_first_tile_;
+    // The scratch buffers for generating the next tile
+    //   Separately allocated and reused for every tile
+    TerrainWorkspace * const workspace_;
+
+    // Generates the indices of an unsimplified tile
+    // @note  These don't change for the same x_length_ * z_length_ height maps
+    // @return  A vector of indices for generating normals
+    std::vector<int> InitializeIndices() const;
+    // Averages the given member to smooth the terrain
+    //   Has a range for X but runs through the entire Z plane (for splitting water
+    //   and cliff
+    //   @param start, the start of the heightmap in the X plane
+    //   @param end,   the end of the heightmap in the X plane
+    //   @param vec_t, a reference to a vector which contains heightmap values or vec3 and
+    //             will be modified. Infact any vector type with + and /= element operators
+    //             should work.
+    //   @param vec_other_t, a reference to a vector which contains @vec_t values from the
+    //                       previous tile
+    //   @warn @a vec_t member is modified
+    template<typename T>
+    void AverageVector(const int start, const int end, std::vector<T> &vec_t, const std::vector<T> &vec_other_t);
+    // Overloaded function to generate a square height map on the X/Z plane. Different
+    // road_type parameters can be added to curve the Z coordinates and hence make turning
+    // pieces.
+    // @param  road_type       An enum representing the mathematical model to be applied to Z
+    // @param  min_position    The relative start position of the heightmap over X/Z
+    // @param  position_range  The spread of the heightmap over X/Z
+    // @warn  No changes can be made to the workspace vertices until the Road Helpers complete
+    void HelperMakeVertices(const RoadType road_type, const float min_position, const float position_range);
+};
+
+// Accessor for the buffers of the tile being generated
+inline const TerrainWorkspace * TileGenerator::workspace() const {
+  return workspace_;
+}
+// Accessor for the turn type of the next tile
+inline TileGenerator::RoadType TileGenerator::next_turn() const {
+  return next_turn_;
+}
+// Accessor for the X/Z position the next tile will start from (road pivot)
+inline const glm::vec2 &TileGenerator::next_tile_start() const {
+  return next_tile_start_;
+}
+// Accessor for the heading of the next tile in degrees from positive z
+inline float TileGenerator::rotation() const {
+  return rotation_;
+}
+// Accessor for the cubic base height of the cliff side
+inline float TileGenerator::cliff_height() const {
+  return prev_cliff_x3_rand_;
+}
+// Accessor for the cubic base height of the water side
+inline float TileGenerator::water_height() const {
+  return prev_water_x3_rand_;
+}
+// Accessor for the amount of height randomizing iterations in a tile
+//   MakeHeights should be called over [0, random_iterations)
+inline int TileGenerator::random_iterations() const {
+  return kRandomIterations;
+}
+// Accessor for the amount of indices in an unsimplified tile
+inline unsigned int TileGenerator::indice_count() const {
+  return indices_.size();
+}
+// Accessor for the amount of indices in a road tile
+inline unsigned int TileGenerator::road_indice_count() const {
+  return road_indice_count_;
+}
+
+#endif